@@ -380,7 +380,7 @@ static void OnFileChanged(void* obj, struct Stream* stream, const cc_string* nam
 }
 
 static void OnInit(void) {
-	ScheduledTask_Add(GAME_DEF_TICKS, Animations_Tick);
+	ScheduledTask_AddEx("Animations_Tick", GAME_DEF_TICKS, Animations_Tick, TASK_PRIORITY_LOW, 1, 0);
 	Event_Register_(&TextureEvents.PackChanged, NULL, OnPackChanged);
 	Event_Register_(&TextureEvents.FileChanged, NULL, OnFileChanged);
 }
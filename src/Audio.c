@@ -908,6 +908,7 @@ static cc_result Sound_ReadWaveData(struct Stream* stream, struct Sound* snd) {
 		} else if (fourCC == WAV_FourCC('d','a','t','a')) {
 			snd->data = Mem_TryAlloc(size, 1);
 			snd->size = size;
+			Mem_SetPlace(snd->data, "sound data");
 
 			if (!snd->data) return ERR_OUT_OF_MEMORY;
 			return Stream_Read(stream, (cc_uint8*)snd->data, size);
@@ -1215,6 +1216,7 @@ static cc_result Music_PlayOgg(struct Stream* source) {
 	cur  = 0;
 	data = (cc_int16*)Mem_TryAlloc(chunkSize * AUDIO_MAX_BUFFERS, 2);
 	if (!data) { res = ERR_OUT_OF_MEMORY; goto cleanup; }
+	Mem_SetPlace(data, "music buffers");
 
 	/* fill up with some samples before playing */
 	for (i = 0; i < AUDIO_MAX_BUFFERS && !res; i++) {
@@ -25,6 +25,7 @@ void Bitmap_Allocate(struct Bitmap* bmp, int width, int height) {
 void Bitmap_TryAllocate(struct Bitmap* bmp, int width, int height) {
 	bmp->width = width; bmp->height = height;
 	bmp->scan0 = (BitmapCol*)Mem_TryAlloc(width * height, 4);
+	Mem_SetPlace(bmp->scan0, "bitmap data");
 }
 
 void Bitmap_AllocateClearedPow2(struct Bitmap* bmp, int width, int height) {
@@ -41,6 +42,7 @@ void Bitmap_TryAllocateClearedPow2(struct Bitmap* bmp, int width, int height) {
 
 	bmp->width = width; bmp->height = height;
 	bmp->scan0 = (BitmapCol*)Mem_TryAllocCleared(width * height, 4);
+	Mem_SetPlace(bmp->scan0, "bitmap data");
 }
 
 void Bitmap_Scale(struct Bitmap* dst, struct Bitmap* src, 
@@ -391,6 +393,7 @@ cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
 
 			bmp->scan0 = (BitmapCol*)Mem_TryAlloc(bmp->width * bmp->height, 4);
 			if (!bmp->scan0) return ERR_OUT_OF_MEMORY;
+			Mem_SetPlace(bmp->scan0, "bitmap data");
 
 			bitsPerSample = tmp[8]; col = tmp[9];
 			rowExpander = Png_GetExpander(col, bitsPerSample);
@@ -9,12 +9,17 @@
 #include "Options.h"
 #include "Generator.h"
 #include "Platform.h"
+#include "Jobs.h"
 #include "Game.h"
 #include "Logger.h"
 #include "Vectors.h"
-#include "Chat.h"
+#include "Formats.h"
+#include "Errors.h"
+#include "Stream.h"
+#include "Utils.h"
+#include "String.h"
 
-/* Data for a resizable queue, used for liquid physic tick entries. */
+/* Data for a resizable queue, used for entries in a slot of a tick wheel. */
 struct TickQueue {
 	cc_uint32* entries; /* Buffer holding the items in the tick queue */
 	int capacity; /* Max number of elements in the buffer */
@@ -43,11 +48,6 @@ static void TickQueue_Resize(struct TickQueue* queue) {
 	cc_uint32* entries;
 	int i, idx, capacity;
 
-	if (queue->capacity >= (Int32_MaxValue / 4)) {
-		Chat_AddRaw("&cToo many physics entries, clearing");
-		TickQueue_Clear(queue);
-	}
-
 	capacity = queue->capacity * 2;
 	if (capacity < 32) capacity = 32;
 	entries = (cc_uint32*)Mem_Alloc(capacity, 4, "physics tick queue");
@@ -86,22 +86,119 @@ static cc_uint32 TickQueue_Dequeue(struct TickQueue* queue) {
 }
 
 
+/* Two level timing wheel of blocks waiting to be ticked, so that a waiting block */
+/*  is only touched when it is scheduled, and then again when its tick is due. */
+/* Blocks due in the current span of WHEEL_SIZE ticks go directly into a slot of the near */
+/*  level, while blocks due in later spans go into a slot of the far level. When the */
+/*  wheel enters a new span, the matching far slot is moved into the near slots. */
+/* (Blocks due in the same tick are always ticked in the order they were scheduled) */
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+
+struct TickWheel {
+	struct TickQueue near[WHEEL_SIZE]; /* Indices of blocks due in each tick of the current span */
+	struct TickQueue far[WHEEL_SIZE];  /* Pairs of (index, due tick) of blocks due in each later span */
+	cc_uint32 tick;    /* Tick most recently advanced to */
+	cc_uint8* pending; /* Bit per block in the world, set if the block is in the wheel */
+	int count;    /* Number of blocks in the wheel */
+	int peak;     /* Highest number of blocks in the wheel at once */
+	int rejected; /* Number of blocks not scheduled, because they were already in the wheel */
+};
+
+static void TickWheel_Init(struct TickWheel* wheel) {
+	int i;
+	for (i = 0; i < WHEEL_SIZE; i++) {
+		TickQueue_Init(&wheel->near[i]);
+		TickQueue_Init(&wheel->far[i]);
+	}
+	wheel->tick     = 0;
+	wheel->pending  = NULL;
+	wheel->count    = 0;
+	wheel->peak     = 0;
+	wheel->rejected = 0;
+}
+
+static void TickWheel_Clear(struct TickWheel* wheel) {
+	int i;
+	for (i = 0; i < WHEEL_SIZE; i++) {
+		TickQueue_Clear(&wheel->near[i]);
+		TickQueue_Clear(&wheel->far[i]);
+	}
+	Mem_Free(wheel->pending);
+	TickWheel_Init(wheel);
+}
+
+/* Schedules the given block to be ticked after 'delay' more ticks have passed. */
+/* NOTE: Blocks that are already waiting to be ticked are not scheduled again. */
+/* (e.g. water spreading into the same block from multiple neighbours in one tick) */
+static void TickWheel_Schedule(struct TickWheel* wheel, int index, int delay) {
+	cc_uint8 bit = 1 << (index & 0x07);
+	cc_uint32 due;
+
+	if (!wheel->pending) {
+		wheel->pending = (cc_uint8*)Mem_AllocCleared((World.Volume + 7) >> 3, 1, "physics pending");
+	}
+	if (wheel->pending[index >> 3] & bit) { wheel->rejected++; return; }
+	wheel->pending[index >> 3] |= bit;
+
+	delay = max(0, min(delay, PHYSICS_MAX_DELAY));
+	due   = wheel->tick + 1 + delay;
+
+	if ((due >> WHEEL_BITS) == (wheel->tick >> WHEEL_BITS)) {
+		TickQueue_Enqueue(&wheel->near[due & WHEEL_MASK], index);
+	} else {
+		TickQueue_Enqueue(&wheel->far[(due >> WHEEL_BITS) & WHEEL_MASK], index);
+		TickQueue_Enqueue(&wheel->far[(due >> WHEEL_BITS) & WHEEL_MASK], due);
+	}
+
+	wheel->count++;
+	if (wheel->count > wheel->peak) wheel->peak = wheel->count;
+}
+
+/* Moves on to the next tick, returning the queue of blocks that are due in that tick. */
+/* NOTE: Blocks must be removed from the returned queue using TickWheel_Dequeue. */
+static struct TickQueue* TickWheel_Advance(struct TickWheel* wheel) {
+	struct TickQueue* slot;
+	cc_uint32 index, due;
+	wheel->tick++;
+
+	/* Entering a new span, so move blocks from far level into the near level */
+	if ((wheel->tick & WHEEL_MASK) == 0) {
+		slot = &wheel->far[(wheel->tick >> WHEEL_BITS) & WHEEL_MASK];
+
+		while (slot->count) {
+			index = TickQueue_Dequeue(slot);
+			due   = TickQueue_Dequeue(slot);
+			TickQueue_Enqueue(&wheel->near[due & WHEEL_MASK], index);
+		}
+	}
+	return &wheel->near[wheel->tick & WHEEL_MASK];
+}
+
+/* Removes the next block from the queue returned by TickWheel_Advance. */
+static int TickWheel_Dequeue(struct TickWheel* wheel, struct TickQueue* due) {
+	int index = (int)TickQueue_Dequeue(due);
+	/* Block can be scheduled again from now on */
+	wheel->pending[index >> 3] &= ~(1 << (index & 0x07));
+	wheel->count--;
+	return index;
+}
+
+
 struct Physics_ Physics;
 static RNGState physics_rnd;
 static int physics_tickCount;
 static int physics_maxWaterX, physics_maxWaterY, physics_maxWaterZ;
-static struct TickQueue lavaQ, waterQ;
+static struct TickWheel lavaQ, waterQ, scheduledQ;
 
-#define PHYSICS_DELAY_MASK 0xF8000000UL
-#define PHYSICS_POS_MASK   0x07FFFFFFUL
-#define PHYSICS_DELAY_SHIFT 27
-#define PHYSICS_ONE_DELAY   (1U << PHYSICS_DELAY_SHIFT)
-#define PHYSICS_LAVA_DELAY (30U << PHYSICS_DELAY_SHIFT)
-#define PHYSICS_WATER_DELAY (5U << PHYSICS_DELAY_SHIFT)
+#define PHYSICS_LAVA_DELAY  30
+#define PHYSICS_WATER_DELAY 5
 
 static void Physics_OnNewMapLoaded(void* obj) {
-	TickQueue_Clear(&lavaQ);
-	TickQueue_Clear(&waterQ);
+	TickWheel_Clear(&lavaQ);
+	TickWheel_Clear(&waterQ);
+	TickWheel_Clear(&scheduledQ);
 
 	physics_maxWaterX = World.MaxX - 2;
 	physics_maxWaterY = World.MaxY - 2;
@@ -224,15 +321,58 @@ static void Physics_DoFalling(int index, BlockID block) {
 	Physics_ActivateNeighbours(x, y, z, start);
 }
 
-static cc_bool Physics_CheckItem(struct TickQueue* queue, int* posIndex) {
-	cc_uint32 item = TickQueue_Dequeue(queue);
-	*posIndex     = (int)(item & PHYSICS_POS_MASK);
+/* Liquid ticks are split into a scan stage and an apply stage. The scan stage only reads the */
+/*  world to work out which neighbours each due liquid might flow into, so it can be split */
+/*  across the job workers. The apply stage then updates blocks on the main thread, in the */
+/*  same order as the queue, re-checking each neighbour against the current world. */
+/* (Result is identical to ticking serially, as liquid ticks only ever change empty or liquid */
+/*  cells, so a neighbour the scan rejected can't become one that liquid would flow into) */
+/* Due items are scanned in batches, to reduce the overhead of claiming work */
+#define PHYSICS_SCAN_BATCH 2048
+/* Queues with fewer items than this are just ticked serially on the main thread */
+/*  (scanning is slower than ticking serially, if it can't be spread across threads) */
+#define PHYSICS_SCAN_MIN 16384
+
+/* Flow directions are packed into the upper bits of scanned items (block indices only need 27 bits) */
+#define PHYSICS_FLOW_XMIN (1UL << 27)
+#define PHYSICS_FLOW_XMAX (1UL << 28)
+#define PHYSICS_FLOW_ZMIN (1UL << 29)
+#define PHYSICS_FLOW_ZMAX (1UL << 30)
+#define PHYSICS_FLOW_YMIN (1UL << 31)
+#define PHYSICS_FLOW_MASK 0xF8000000UL
+typedef cc_uint32 (*PhysicsScanFunc)(int index);
+
+static struct PhysicsScan {
+	cc_uint32* items; /* Indices of due items, with flow directions once scanned */
+	int count, capacity;
+	PhysicsScanFunc func;
+} physics_scan;
+
+static void Physics_ScanBatch(void* obj, int beg, int end) {
+	int i;
+	for (i = beg; i < end; i++) {
+		physics_scan.items[i] |= physics_scan.func((int)physics_scan.items[i]);
+	}
+}
+
+/* Calculates the flow directions of the items that are due this tick */
+/* Returns false if the queue is too small to be worth scanning on multiple threads */
+static cc_bool Physics_ScanQueue(struct TickQueue* due, PhysicsScanFunc func) {
+	int i;
+	if (!Jobs_WorkerCount || due->count < PHYSICS_SCAN_MIN) return false;
 
-	if (item >= PHYSICS_ONE_DELAY) {
-		item -= PHYSICS_ONE_DELAY;
-		TickQueue_Enqueue(queue, item);
-		return false;
+	if (due->count > physics_scan.capacity) {
+		physics_scan.items    = (cc_uint32*)Mem_Realloc(physics_scan.items, due->count, 4, "physics scan");
+		physics_scan.capacity = due->count;
 	}
+	physics_scan.count = due->count;
+
+	for (i = 0; i < due->count; i++) {
+		physics_scan.items[i] = due->entries[(due->head + i) & due->mask];
+	}
+
+	physics_scan.func = func;
+	Jobs_ParallelFor(due->count, PHYSICS_SCAN_BATCH, Physics_ScanBatch, NULL);
 	return true;
 }
 
@@ -322,7 +462,7 @@ static void Physics_HandleMushroom(int index, BlockID block) {
 
 
 static void Physics_PlaceLava(int index, BlockID block) {
-	TickQueue_Enqueue(&lavaQ, PHYSICS_LAVA_DELAY | index);
+	TickWheel_Schedule(&lavaQ, index, PHYSICS_LAVA_DELAY);
 }
 
 static void Physics_PropagateLava(int posIndex, int x, int y, int z) {
@@ -330,7 +470,7 @@ static void Physics_PropagateLava(int posIndex, int x, int y, int z) {
 	if (block == BLOCK_WATER || block == BLOCK_STILL_WATER) {
 		Game_UpdateBlock(x, y, z, BLOCK_STONE);
 	} else if (Blocks.Collide[block] == COLLIDE_NONE) {
-		TickQueue_Enqueue(&lavaQ, PHYSICS_LAVA_DELAY | posIndex);
+		TickWheel_Schedule(&lavaQ, posIndex, PHYSICS_LAVA_DELAY);
 		Game_UpdateBlock(x, y, z, BLOCK_LAVA);
 	}
 }
@@ -346,13 +486,52 @@ static void Physics_ActivateLava(int index, BlockID block) {
 	if (y > 0)          Physics_PropagateLava(index - World.OneY, x, y - 1, z);
 }
 
+static cc_bool Physics_LavaCanFlow(int index) {
+	BlockID block = World.Blocks[index];
+	return block == BLOCK_WATER || block == BLOCK_STILL_WATER || Blocks.Collide[block] == COLLIDE_NONE;
+}
+
+/* NOTE: Called from multiple threads, so must only read the world */
+static cc_uint32 Physics_ScanLava(int index) {
+	BlockID block = World.Blocks[index];
+	cc_uint32 flow = 0;
+	int x, y, z;
+	/* Empty cells might still be flooded by earlier items in the queue */
+	if (!(block == BLOCK_LAVA || block == BLOCK_STILL_LAVA) && Blocks.Collide[block] != COLLIDE_NONE) return 0;
+	World_Unpack(index, x, y, z);
+
+	if (x > 0          && Physics_LavaCanFlow(index - 1))           flow |= PHYSICS_FLOW_XMIN;
+	if (x < World.MaxX && Physics_LavaCanFlow(index + 1))           flow |= PHYSICS_FLOW_XMAX;
+	if (z > 0          && Physics_LavaCanFlow(index - World.Width)) flow |= PHYSICS_FLOW_ZMIN;
+	if (z < World.MaxZ && Physics_LavaCanFlow(index + World.Width)) flow |= PHYSICS_FLOW_ZMAX;
+	if (y > 0          && Physics_LavaCanFlow(index - World.OneY))  flow |= PHYSICS_FLOW_YMIN;
+	return flow;
+}
+
+static void Physics_FlowLava(int index, cc_uint32 flow) {
+	int x, y, z;
+	World_Unpack(index, x, y, z);
+
+	if (flow & PHYSICS_FLOW_XMIN) Physics_PropagateLava(index - 1,           x - 1, y,     z);
+	if (flow & PHYSICS_FLOW_XMAX) Physics_PropagateLava(index + 1,           x + 1, y,     z);
+	if (flow & PHYSICS_FLOW_ZMIN) Physics_PropagateLava(index - World.Width, x,     y,     z - 1);
+	if (flow & PHYSICS_FLOW_ZMAX) Physics_PropagateLava(index + World.Width, x,     y,     z + 1);
+	if (flow & PHYSICS_FLOW_YMIN) Physics_PropagateLava(index - World.OneY,  x,     y - 1, z);
+}
+
 static void Physics_TickLava(void) {
-	int i, count = lavaQ.count;
+	struct TickQueue* due = TickWheel_Advance(&lavaQ);
+	int i, count = due->count;
+	cc_bool scanned = Physics_ScanQueue(due, Physics_ScanLava);
+
 	for (i = 0; i < count; i++) {
-		int index;
-		if (Physics_CheckItem(&lavaQ, &index)) {
-			BlockID block = World.Blocks[index];
-			if (!(block == BLOCK_LAVA || block == BLOCK_STILL_LAVA)) continue;
+		int index     = TickWheel_Dequeue(&lavaQ, due);
+		BlockID block = World.Blocks[index];
+		if (!(block == BLOCK_LAVA || block == BLOCK_STILL_LAVA)) continue;
+
+		if (scanned) {
+			Physics_FlowLava(index, physics_scan.items[i] & PHYSICS_FLOW_MASK);
+		} else {
 			Physics_ActivateLava(index, block);
 		}
 	}
@@ -360,27 +539,30 @@ static void Physics_TickLava(void) {
 
 
 static void Physics_PlaceWater(int index, BlockID block) {
-	TickQueue_Enqueue(&waterQ, PHYSICS_WATER_DELAY | index);
+	TickWheel_Schedule(&waterQ, index, PHYSICS_WATER_DELAY);
+}
+
+static cc_bool Physics_NearSponge(int x, int y, int z) {
+	int xx, yy, zz;
+	for (yy = (y < 2 ? 0 : y - 2); yy <= (y > physics_maxWaterY ? World.MaxY : y + 2); yy++) {
+		for (zz = (z < 2 ? 0 : z - 2); zz <= (z > physics_maxWaterZ ? World.MaxZ : z + 2); zz++) {
+			for (xx = (x < 2 ? 0 : x - 2); xx <= (x > physics_maxWaterX ? World.MaxX : x + 2); xx++) {
+				if (World_GetBlock(xx, yy, zz) == BLOCK_SPONGE) return true;
+			}
+		}
+	}
+	return false;
 }
 
 static void Physics_PropagateWater(int posIndex, int x, int y, int z) {
 	BlockID block = World.Blocks[posIndex];
-	int xx, yy, zz;
 
 	if (block == BLOCK_LAVA || block == BLOCK_STILL_LAVA) {
 		Game_UpdateBlock(x, y, z, BLOCK_STONE);
 	} else if (Blocks.Collide[block] == COLLIDE_NONE && block != BLOCK_ROPE) {
-		/* Sponge check */		
-		for (yy = (y < 2 ? 0 : y - 2); yy <= (y > physics_maxWaterY ? World.MaxY : y + 2); yy++) {
-			for (zz = (z < 2 ? 0 : z - 2); zz <= (z > physics_maxWaterZ ? World.MaxZ : z + 2); zz++) {
-				for (xx = (x < 2 ? 0 : x - 2); xx <= (x > physics_maxWaterX ? World.MaxX : x + 2); xx++) {
-					block = World_GetBlock(xx, yy, zz);
-					if (block == BLOCK_SPONGE) return;
-				}
-			}
-		}
+		if (Physics_NearSponge(x, y, z)) return;
 
-		TickQueue_Enqueue(&waterQ, PHYSICS_WATER_DELAY | posIndex);
+		TickWheel_Schedule(&waterQ, posIndex, PHYSICS_WATER_DELAY);
 		Game_UpdateBlock(x, y, z, BLOCK_WATER);
 	}
 }
@@ -396,13 +578,72 @@ static void Physics_ActivateWater(int index, BlockID block) {
 	if (y > 0)          Physics_PropagateWater(index - World.OneY,  x,     y - 1, z);
 }
 
+/* Whether sponges can be replaced by liquids (and so sponge checks may change during a tick) */
+static cc_bool Physics_SpongeFloods(void) {
+	return Blocks.Collide[BLOCK_SPONGE] == COLLIDE_NONE;
+}
+
+static cc_bool Physics_WaterCanFlow(int index, int x, int y, int z) {
+	BlockID block = World.Blocks[index];
+	if (block == BLOCK_LAVA || block == BLOCK_STILL_LAVA) return true;
+	if (Blocks.Collide[block] != COLLIDE_NONE || block == BLOCK_ROPE) return false;
+	return Physics_SpongeFloods() || !Physics_NearSponge(x, y, z);
+}
+
+/* NOTE: Called from multiple threads, so must only read the world */
+static cc_uint32 Physics_ScanWater(int index) {
+	BlockID block = World.Blocks[index];
+	cc_uint32 flow = 0;
+	int x, y, z;
+	/* Empty cells might still be flooded by earlier items in the queue */
+	if (!(block == BLOCK_WATER || block == BLOCK_STILL_WATER) && Blocks.Collide[block] != COLLIDE_NONE) return 0;
+	World_Unpack(index, x, y, z);
+
+	if (x > 0          && Physics_WaterCanFlow(index - 1,           x - 1, y,     z))     flow |= PHYSICS_FLOW_XMIN;
+	if (x < World.MaxX && Physics_WaterCanFlow(index + 1,           x + 1, y,     z))     flow |= PHYSICS_FLOW_XMAX;
+	if (z > 0          && Physics_WaterCanFlow(index - World.Width, x,     y,     z - 1)) flow |= PHYSICS_FLOW_ZMIN;
+	if (z < World.MaxZ && Physics_WaterCanFlow(index + World.Width, x,     y,     z + 1)) flow |= PHYSICS_FLOW_ZMAX;
+	if (y > 0          && Physics_WaterCanFlow(index - World.OneY,  x,     y - 1, z))     flow |= PHYSICS_FLOW_YMIN;
+	return flow;
+}
+
+/* Same as Physics_PropagateWater, but skips sponge check (as scan stage already did it) */
+static void Physics_FlowWaterTo(int posIndex, int x, int y, int z) {
+	BlockID block = World.Blocks[posIndex];
+
+	if (block == BLOCK_LAVA || block == BLOCK_STILL_LAVA) {
+		Game_UpdateBlock(x, y, z, BLOCK_STONE);
+	} else if (Blocks.Collide[block] == COLLIDE_NONE && block != BLOCK_ROPE) {
+		TickWheel_Schedule(&waterQ, posIndex, PHYSICS_WATER_DELAY);
+		Game_UpdateBlock(x, y, z, BLOCK_WATER);
+	}
+}
+
+static void Physics_FlowWater(int index, cc_uint32 flow) {
+	int x, y, z;
+	World_Unpack(index, x, y, z);
+	if (Physics_SpongeFloods()) { Physics_ActivateWater(index, BLOCK_WATER); return; }
+
+	if (flow & PHYSICS_FLOW_XMIN) Physics_FlowWaterTo(index - 1,           x - 1, y,     z);
+	if (flow & PHYSICS_FLOW_XMAX) Physics_FlowWaterTo(index + 1,           x + 1, y,     z);
+	if (flow & PHYSICS_FLOW_ZMIN) Physics_FlowWaterTo(index - World.Width, x,     y,     z - 1);
+	if (flow & PHYSICS_FLOW_ZMAX) Physics_FlowWaterTo(index + World.Width, x,     y,     z + 1);
+	if (flow & PHYSICS_FLOW_YMIN) Physics_FlowWaterTo(index - World.OneY,  x,     y - 1, z);
+}
+
 static void Physics_TickWater(void) {
-	int i, count = waterQ.count;
+	struct TickQueue* due = TickWheel_Advance(&waterQ);
+	int i, count = due->count;
+	cc_bool scanned = Physics_ScanQueue(due, Physics_ScanWater);
+
 	for (i = 0; i < count; i++) {
-		int index;
-		if (Physics_CheckItem(&waterQ, &index)) {
-			BlockID block = World.Blocks[index];
-			if (!(block == BLOCK_WATER || block == BLOCK_STILL_WATER)) continue;
+		int index     = TickWheel_Dequeue(&waterQ, due);
+		BlockID block = World.Blocks[index];
+		if (!(block == BLOCK_WATER || block == BLOCK_STILL_WATER)) continue;
+
+		if (scanned) {
+			Physics_FlowWater(index, physics_scan.items[i] & PHYSICS_FLOW_MASK);
+		} else {
 			Physics_ActivateWater(index, block);
 		}
 	}
@@ -440,7 +681,7 @@ static void Physics_DeleteSponge(int index, BlockID block) {
 					index = World_Pack(xx, yy, zz);
 					block = World.Blocks[index];
 					if (block == BLOCK_WATER || block == BLOCK_STILL_WATER) {
-						TickQueue_Enqueue(&waterQ, index | PHYSICS_ONE_DELAY);
+						TickWheel_Schedule(&waterQ, index, 1);
 					}
 				}
 			}
@@ -508,8 +749,9 @@ static void Physics_HandleTnt(int index, BlockID block) {
 void Physics_Init(void) {
 	Event_Register_(&WorldEvents.MapLoaded,    NULL, Physics_OnNewMapLoaded);
 	Physics.Enabled = Options_GetBool(OPT_BLOCK_PHYSICS, true);
-	TickQueue_Init(&lavaQ);
-	TickQueue_Init(&waterQ);
+	TickWheel_Init(&lavaQ);
+	TickWheel_Init(&waterQ);
+	TickWheel_Init(&scheduledQ);
 
 	Physics.OnPlace[BLOCK_SAND]        = Physics_DoFalling;
 	Physics.OnPlace[BLOCK_GRAVEL]      = Physics_DoFalling;
@@ -548,8 +790,43 @@ void Physics_Init(void) {
 	Physics.OnPlace[BLOCK_TNT]         = Physics_HandleTnt;
 }
 
+void Physics_GetStats(struct PhysicsStats* stats) {
+	stats->LavaQueued    = lavaQ.count;
+	stats->LavaPeak      = lavaQ.peak;
+	stats->LavaRejected  = lavaQ.rejected;
+	stats->WaterQueued   = waterQ.count;
+	stats->WaterPeak     = waterQ.peak;
+	stats->WaterRejected = waterQ.rejected;
+}
+
 void Physics_Free(void) {
 	Event_Unregister_(&WorldEvents.MapLoaded,    NULL, Physics_OnNewMapLoaded);
+	TickWheel_Clear(&lavaQ);
+	TickWheel_Clear(&waterQ);
+	TickWheel_Clear(&scheduledQ);
+	Mem_Free(physics_scan.items);
+	physics_scan.items    = NULL;
+	physics_scan.capacity = 0;
+}
+
+void Physics_ScheduleTick(int index, int delay) {
+	if (!World.Blocks || index < 0 || index >= World.Volume) return;
+	TickWheel_Schedule(&scheduledQ, index, delay);
+}
+
+static void Physics_TickScheduled(void) {
+	struct TickQueue* due = TickWheel_Advance(&scheduledQ);
+	PhysicsHandler handler;
+	BlockID block;
+	int index;
+
+	/* NOTE: Handlers scheduling ticks never add to the due queue, as the delay is always at least one tick */
+	while (due->count) {
+		index   = TickWheel_Dequeue(&scheduledQ, due);
+		block   = World.Blocks[index];
+		handler = Physics.OnScheduledTick[block];
+		if (handler) handler(index, block);
+	}
 }
 
 void Physics_Tick(void) {
@@ -559,6 +836,83 @@ void Physics_Tick(void) {
 	Physics_TickLava();
 	Physics_TickWater();
 	/*}*/
+	Physics_TickScheduled();
 	physics_tickCount++;
 	Physics_TickRandomBlocks();
 }
+
+
+/* Headless benchmark, so physics changes can be timed and checked for identical behaviour */
+static void Physics_BenchWarn(const cc_string* msg) {
+	Platform_Log(msg->buffer, msg->length);
+}
+
+static void Physics_BenchLog(const char* name, struct TickWheel* wheel) {
+	cc_string str; char strBuffer[STRING_SIZE];
+	String_InitArray(str, strBuffer);
+
+	String_Format4(&str, "%c: %i waiting, %i peak, %i duplicates rejected", 
+					name, &wheel->count, &wheel->peak, &wheel->rejected);
+	Platform_Log(str.buffer, str.length);
+}
+
+cc_result Physics_RunBenchmark(const cc_string* path, int ticks, int seed) {
+	cc_string str; char strBuffer[STRING_SIZE];
+	IMapImporter importer;
+	struct Stream stream;
+	cc_uint64 beg, end;
+	cc_uint32 crc;
+	float elapsed, rate;
+	cc_result res;
+	int i;
+
+	Logger_WarnFunc = Physics_BenchWarn;
+	Blocks_Component.Init();
+	Physics_Init();
+	Physics.Enabled = true;
+	World_Reset();
+
+	/* Same as Map_LoadFrom, but without resetting or moving the player, */
+	/*  as the rest of the game isn't initialised when benchmarking */
+	importer = Map_FindImporter(path);
+	if (!importer) { Logger_SysWarn2(ERR_NOT_SUPPORTED, "decoding", path); return ERR_NOT_SUPPORTED; }
+
+	res = Stream_OpenFile(&stream, path);
+	if (res) { Logger_SysWarn2(res, "opening", path); return res; }
+	res = importer(&stream);
+
+	/* No point logging error for closing readonly file */
+	stream.Close(&stream);
+	if (res) { Logger_SysWarn2(res, "decoding", path); return res; }
+
+	World_SetNewMap(World.Blocks, World.Width, World.Height, World.Length);
+	Lighting_Component.OnNewMapLoaded();
+	Random_Seed(&physics_rnd, seed);
+	/* Liquid queue scans are spread across the job workers */
+	Jobs_Component.Init();
+
+	beg = Stopwatch_Measure();
+	for (i = 0; i < ticks; i++) { Physics_Tick(); }
+	end = Stopwatch_Measure();
+
+	elapsed = Stopwatch_ElapsedMicroseconds(beg, end) / 1000.0f;
+	rate    = elapsed ? ticks * 1000.0f / elapsed : 0.0f;
+	crc     = Utils_CRC32(World.Blocks, World.Volume);
+
+	String_InitArray(str, strBuffer);
+	String_Format4(&str, "%i ticks in %f2 ms (%f1 ticks/sec) with %i workers", &ticks, &elapsed, &rate, &Jobs_WorkerCount);
+	Platform_Log(str.buffer, str.length);
+
+	Physics_BenchLog("Lava",      &lavaQ);
+	Physics_BenchLog("Water",     &waterQ);
+	Physics_BenchLog("Scheduled", &scheduledQ);
+
+	str.length = 0;
+	String_Format1(&str, "World checksum: %h", &crc);
+	Platform_Log(str.buffer, str.length);
+
+	Jobs_Component.Free();
+	Physics_Free();
+	World_Reset();
+	return 0;
+}
@@ -19,11 +19,34 @@ CC_VAR extern struct Physics_ {
 	PhysicsHandler OnPlace[256];
 	/* Called when user manually deletes a block. */
 	PhysicsHandler OnDelete[256];
+	/* Called when a tick scheduled for this block using Physics_ScheduleTick is due. */
+	/* e.g. custom blocks that change after some time */
+	PhysicsHandler OnScheduledTick[256];
 } Physics;
 
+/* Statistics about the liquid physics tick queues, since the map was loaded. */
+struct PhysicsStats {
+	int LavaQueued,   WaterQueued;   /* Number of blocks currently waiting to be ticked */
+	int LavaPeak,     WaterPeak;     /* Highest number of blocks that were waiting at once */
+	int LavaRejected, WaterRejected; /* Number of times a block was not queued, as it was already waiting */
+};
+
 void Physics_SetEnabled(cc_bool enabled);
 void Physics_OnBlockChanged(int x, int y, int z, BlockID old, BlockID now);
 void Physics_Init(void);
 void Physics_Free(void);
 void Physics_Tick(void);
+
+/* Longest delay (in physics ticks) that a block tick can be scheduled for. */
+#define PHYSICS_MAX_DELAY 4000
+/* Schedules OnScheduledTick for the block at the given index to be called after 'delay' physics ticks. */
+/* (0 means the next physics tick, longer delays than PHYSICS_MAX_DELAY are clamped) */
+/* NOTE: Blocks already waiting for a scheduled tick are not scheduled again. */
+CC_API void Physics_ScheduleTick(int index, int delay);
+
+/* Loads the given map, then times running the given number of physics ticks with a fixed seed. */
+/* Results (including queue statistics and a checksum of the world afterwards) are logged. */
+/* NOTE: Runs without a window or the rest of the game initialised. (see --physics-bench) */
+cc_result Physics_RunBenchmark(const cc_string* path, int ticks, int seed);
+void Physics_GetStats(struct PhysicsStats* stats);
 #endif
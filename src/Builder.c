@@ -342,6 +342,11 @@ static cc_bool BuildChunk(int x1, int y1, int z1, struct ChunkInfo* info) {
 	Builder_Counts = counts;
 	Builder_BitFlags = bitFlags;
 	Builder_PrePrepareChunk();
+
+	/* Chunks with only gas blocks never have any geometry */
+	if (World_GetChunkOccupancy(x1 >> CHUNK_SHIFT, y1 >> CHUNK_SHIFT, z1 >> CHUNK_SHIFT) == CHUNK_OCCUPANCY_AIR) {
+		info->AllAir = true; return false;
+	}
 	
 	onBorder = 
 		x1 == 0 || y1 == 0 || z1 == 0   || x1 + CHUNK_SIZE >= World.Width ||
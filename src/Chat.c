@@ -18,15 +18,18 @@
 #include "TexturePack.h"
 #include "Options.h"
 #include "Drawer2D.h"
+#include "BlockPhysics.h"
+#include "Particle.h"
+#include "Profiler.h"
 
-static char _st[5][STRING_SIZE];
+static char _st[6][STRING_SIZE];
 static char _br[3][STRING_SIZE];
 static char _cs[2][STRING_SIZE];
 static char announcement[STRING_SIZE];
 static char bigAnnouncement[STRING_SIZE];
 static char smallAnnouncement[STRING_SIZE];
 
-cc_string Chat_Status[5]       = { String_FromArray(_st[0]), String_FromArray(_st[1]), String_FromArray(_st[2]), String_FromArray(_st[3]), String_FromArray(_st[4]) };
+cc_string Chat_Status[6]       = { String_FromArray(_st[0]), String_FromArray(_st[1]), String_FromArray(_st[2]), String_FromArray(_st[3]), String_FromArray(_st[4]), String_FromArray(_st[5]) };
 cc_string Chat_BottomRight[3]  = { String_FromArray(_br[0]), String_FromArray(_br[1]), String_FromArray(_br[2]) };
 cc_string Chat_ClientStatus[2] = { String_FromArray(_cs[0]), String_FromArray(_cs[8]) };
 
@@ -257,6 +260,9 @@ void Chat_AddOf(const cc_string* text, int msgType) {
 		String_Copy(&Chat_ClientStatus[msgType - MSG_TYPE_CLIENTSTATUS_1], text);
 	} else if (msgType >= MSG_TYPE_EXTRASTATUS_1 && msgType <= MSG_TYPE_EXTRASTATUS_2) {
 		String_Copy(&Chat_Status[msgType - MSG_TYPE_EXTRASTATUS_1], text);
+	} else if (msgType == MSG_TYPE_EXTRASTATUS_3) {
+		/* Status[2 to 4] are for server status messages */
+		String_Copy(&Chat_Status[5], text);
 	} 
 
 	Event_RaiseChat(&ChatEvents.ChatReceived, text, msgType);
@@ -511,6 +517,238 @@ static struct ChatCommand ClearDeniedCommand = {
 	}
 };
 
+static void PhysicsCommand_Execute(const cc_string* args, int argsCount) {
+	struct PhysicsStats stats;
+	Physics_GetStats(&stats);
+
+	Chat_Add3("&eWater: &f%i &equeued, &f%i &epeak, &f%i &eduplicates rejected",
+		&stats.WaterQueued, &stats.WaterPeak, &stats.WaterRejected);
+	Chat_Add3("&eLava: &f%i &equeued, &f%i &epeak, &f%i &eduplicates rejected",
+		&stats.LavaQueued,  &stats.LavaPeak,  &stats.LavaRejected);
+}
+
+static struct ChatCommand PhysicsCommand = {
+	"Physics", PhysicsCommand_Execute,
+	COMMAND_FLAG_SINGLEPLAYER_ONLY | COMMAND_FLAG_UNSPLIT_ARGS,
+	{
+		"&a/client physics",
+		"&eDisplays statistics about block physics tick queues.",
+	}
+};
+
+
+static void ParticlesCommand_Execute(const cc_string* args, int argsCount) {
+	struct ParticleStats stats;
+	Particles_GetStats(&stats);
+
+	Chat_Add4("&eParticles: &f%i &eterrain, &f%i &erain, &f%i &ecustom (max &f%i &eeach)",
+		&stats.TerrainCount, &stats.RainCount, &stats.CustomCount, &stats.MaxCount);
+	Chat_Add2("&eTick time: &f%i &eus last, &f%i &eus peak", &stats.TickTime, &stats.TickPeak);
+}
+
+static struct ChatCommand ParticlesCommand = {
+	"Particles", ParticlesCommand_Execute,
+	COMMAND_FLAG_UNSPLIT_ARGS,
+	{
+		"&a/client particles",
+		"&eDisplays the number of live particles, and how long ticking them takes.",
+	}
+};
+
+static void ProfilerCommand_Execute(const cc_string* args, int argsCount) {
+	static const cc_string defPath = String_FromConst("profiler-trace.json");
+	cc_string path;
+	cc_result res;
+
+	if (!argsCount) {
+		Chat_AddRaw("&e/client: &cYou didn't specify on, off or save."); 
+	} else if (String_CaselessEqualsConst(&args[0], "on")) {
+		Profiler_SetEnabled(true);
+		Chat_AddRaw("&e/client: &fProfiler enabled, zone timings are shown at the top right.");
+	} else if (String_CaselessEqualsConst(&args[0], "off")) {
+		Profiler_SetEnabled(false);
+		Chat_AddRaw("&e/client: &fProfiler disabled.");
+	} else if (!String_CaselessEqualsConst(&args[0], "save")) {
+		Chat_Add1("&e/client: &cUnrecognised profiler action &f\"%s\"&c.", &args[0]);
+	} else if (!Profiler_Enabled) {
+		Chat_AddRaw("&e/client: &cProfiler must be enabled first.");
+	} else {
+		path = argsCount > 1 ? args[1] : defPath;
+		res  = Profiler_SaveTrace(&path);
+
+		if (res) { Logger_SysWarn2(res, "saving", &path); return; }
+		Chat_Add1("&e/client: &fSaved profiler trace to &e%s", &path);
+	}
+}
+
+static void FrameStatsCommand_PrintStats(void) {
+	static const float ranges[] = { 0, 8, 16.7f, 33.3f, 50, 100, 1000 * 1000 };
+	cc_string str; char strBuffer[STRING_SIZE];
+	struct ProfilerFrameStats stats;
+	int i, count;
+	Profiler_GetFrameStats(&stats);
+
+	Chat_Add4("&eLast &f%i &eframes: &f%f1 &ems median, &f%f1 &ems 99th percentile, &f%f1 &ems slowest",
+		&stats.frames, &stats.p50Ms, &stats.p99Ms, &stats.maxMs);
+
+	String_InitArray(str, strBuffer);
+	String_AppendConst(&str, "&eFrames by ms:");
+	for (i = 0; i < Array_Elems(ranges) - 1; i++) {
+		count = Profiler_CountFrames(ranges[i], ranges[i + 1]);
+		if (i < Array_Elems(ranges) - 2) {
+			String_Format2(&str, " &7<%f0: &f%i", &ranges[i + 1], &count);
+		} else {
+			String_Format2(&str, " &7%f0+: &f%i", &ranges[i], &count);
+		}
+	}
+	Chat_Add(&str);
+
+	if (!stats.stutters) return;
+	Chat_Add3("&eStutters: &f%i&e, last took &f%f0 &ems in &f%c", &stats.stutters, &stats.stutterMs,
+		stats.stutterZone ? stats.stutterZone : "unknown");
+}
+
+static void FrameStatsCommand_Execute(const cc_string* args, int argsCount) {
+	cc_bool enabled;
+
+	if (!argsCount) {
+		FrameStatsCommand_PrintStats();
+	} else if (String_CaselessEqualsConst(&args[0], "show")) {
+		enabled = !Profiler_ShowFrameStats;
+		Profiler_SetShowFrameStats(enabled);
+		Options_SetBool(OPT_SHOW_FRAME_STATS, enabled);
+		Chat_Add1("&e/client: &fFrame stats in HUD: &e%t", &enabled);
+	} else if (String_CaselessEqualsConst(&args[0], "log")) {
+		enabled = !Profiler_LogFrameStats;
+		Profiler_SetLogFrameStats(enabled);
+		if (Profiler_LogFrameStats != enabled) return;
+
+		Options_SetBool(OPT_LOG_FRAME_STATS, enabled);
+		Chat_Add1("&e/client: &fLogging frame stats to logs/frametimes.csv: &e%t", &enabled);
+	} else {
+		Chat_Add1("&e/client: &cUnrecognised frame stats action &f\"%s\"&c.", &args[0]);
+	}
+}
+
+static struct ChatCommand FrameStatsCommand = {
+	"FrameStats", FrameStatsCommand_Execute,
+	0,
+	{
+		"&a/client framestats [show/log]",
+		"&eDisplays how long recent frames took, and what slowed down stutters.",
+		"&bshow: &eToggles showing frame stats below the FPS in the HUD.",
+		"&blog: &eToggles appending frame stats each second to logs/frametimes.csv",
+	}
+};
+
+static struct ChatCommand ProfilerCommand = {
+	"Profiler", ProfilerCommand_Execute,
+	0,
+	{
+		"&a/client profiler [on/off/save] [file]",
+		"&bon/off: &eShows how long parts of each frame take, at the top right.",
+		"&bsave: &eSaves the last few seconds of timings to a file,",
+		"&e  which can be viewed with chrome://tracing or ui.perfetto.dev",
+	}
+};
+
+static void TasksCommand_Execute(const cc_string* args, int argsCount) {
+	cc_string str; char strBuffer[STRING_SIZE * 2];
+	struct ScheduledTask* task;
+	int i, tps;
+
+	for (i = 0; i < ScheduledTask_Count(); i++) {
+		task = ScheduledTask_Get(i);
+		tps  = (int)(1.0 / task->interval + 0.5);
+		String_InitArray(str, strBuffer);
+
+		String_Format4(&str, "&e%c &7(%i/s): &f%i &eticks, slowest &f%f2 &ems, ",
+			task->name, &tps, &task->ticks, &task->maxMs);
+		String_Format2(&str, "&f%i &edropped, &f%i &epostponed", &task->droppedTicks, &task->deferredFrames);
+		Chat_Add(&str);
+	}
+}
+
+static struct ChatCommand TasksCommand = {
+	"Tasks", TasksCommand_Execute,
+	0,
+	{
+		"&a/client tasks",
+		"&eDisplays statistics for each periodically run task.",
+		"&bdropped: &eTicks skipped to avoid catching up after a long frame",
+		"&bpostponed: &eFrames where catching up ran out of time budget",
+	}
+};
+
+static void MemoryCommand_PrintStats(void) {
+	struct MemPlaceStats places[8], total;
+	float curMB, peakMB;
+	int i, count;
+
+	if (!Mem_IsTracking()) {
+		Chat_AddRaw("&e/client: &cMemory tracking is off, use &a/client memory track &cfirst.");
+		return;
+	}
+	count = Profiler_GetMemoryStats(places, Array_Elems(places), &total);
+
+	curMB  = total.curBytes  / (1024.0f * 1024.0f);
+	peakMB = total.peakBytes / (1024.0f * 1024.0f);
+	Chat_Add3("&eTracked memory: &f%f2 &eMB in &f%i &eblocks, peak &f%f2 &eMB",
+		&curMB, &total.curAllocs, &peakMB);
+
+	for (i = 0; i < count; i++) {
+		curMB  = places[i].curBytes  / (1024.0f * 1024.0f);
+		peakMB = places[i].peakBytes / (1024.0f * 1024.0f);
+		Chat_Add4("&7  %c: &f%f2 &eMB in &f%i &eblocks, peak &f%f2 &eMB",
+			places[i].place, &curMB, &places[i].curAllocs, &peakMB);
+	}
+}
+
+static void MemoryCommand_Execute(const cc_string* args, int argsCount) {
+	static const cc_string path = String_FromConst("logs/memory.csv");
+	cc_bool enabled;
+	cc_result res;
+
+	if (!argsCount) {
+		MemoryCommand_PrintStats();
+	} else if (String_CaselessEqualsConst(&args[0], "track")) {
+		enabled = !Mem_IsTracking();
+		/* Memory shown in the HUD would be meaningless without tracking */
+		if (!enabled) Profiler_SetShowMemory(false);
+		Mem_SetTracking(enabled);
+
+		Options_SetBool(OPT_MEM_TRACKING, enabled);
+		Chat_Add1("&e/client: &fTracking memory allocations: &e%t", &enabled);
+	} else if (String_CaselessEqualsConst(&args[0], "show")) {
+		enabled = !Profiler_ShowMemory;
+		Profiler_SetShowMemory(enabled);
+		Options_SetBool(OPT_SHOW_MEMORY, enabled);
+		Chat_Add1("&e/client: &fMemory usage in HUD: &e%t", &enabled);
+	} else if (!String_CaselessEqualsConst(&args[0], "dump")) {
+		Chat_Add1("&e/client: &cUnrecognised memory action &f\"%s\"&c.", &args[0]);
+	} else if (!Mem_IsTracking()) {
+		Chat_AddRaw("&e/client: &cMemory tracking must be enabled first.");
+	} else {
+		if (!Utils_EnsureDirectory("logs")) return;
+		res = Profiler_SaveMemoryStats(&path);
+
+		if (res) { Logger_SysWarn2(res, "saving", &path); return; }
+		Chat_Add1("&e/client: &fSaved memory usage to &e%s", &path);
+	}
+}
+
+static struct ChatCommand MemoryCommand = {
+	"Memory", MemoryCommand_Execute,
+	0,
+	{
+		"&a/client memory [track/show/dump]",
+		"&eDisplays which places the most memory is allocated for.",
+		"&btrack: &eToggles tracking memory allocations. (only new ones are counted)",
+		"&bshow: &eToggles showing memory usage at the top right of the HUD.",
+		"&bdump: &eSaves memory usage of every place to logs/memory.csv",
+	}
+};
+
 
 /*########################################################################################################################*
 *-------------------------------------------------------CuboidCommand-----------------------------------------------------*
@@ -680,6 +918,12 @@ static void OnInit(void) {
 	Commands_Register(&CuboidCommand);
 	Commands_Register(&TeleportCommand);
 	Commands_Register(&ClearDeniedCommand);
+	Commands_Register(&PhysicsCommand);
+	Commands_Register(&ParticlesCommand);
+	Commands_Register(&ProfilerCommand);
+	Commands_Register(&FrameStatsCommand);
+	Commands_Register(&TasksCommand);
+	Commands_Register(&MemoryCommand);
 
 #if defined CC_BUILD_MOBILE || defined CC_BUILD_WEB
 	/* Better to not log chat by default on mobile/web, */
@@ -249,6 +249,29 @@ Thus it is **NOT SAFE** to allocate a string on the stack. */
 #endif
 #endif
 
+/* Headless builds never create a real window or graphics context */
+/* (e.g. for profiling the game on machines without a GPU or display) */
+/* Software GPU builds render on the CPU instead of using a graphics API */
+/* (e.g. for machines without a GPU, or with a broken/very slow OpenGL driver) */
+#if defined CC_BUILD_HEADLESS || defined CC_BUILD_SOFTGPU
+#undef CC_BUILD_GL
+#undef CC_BUILD_GLMODERN
+#undef CC_BUILD_GLES
+#undef CC_BUILD_EGL
+#undef CC_BUILD_D3D9
+#undef CC_BUILD_D3D11
+#endif
+
+#ifdef CC_BUILD_HEADLESS
+#undef CC_BUILD_X11
+#undef CC_BUILD_SDL
+#undef CC_BUILD_WINGUI
+#undef CC_BUILD_CARBON
+#ifndef CC_BUILD_SOFTGPU
+#define CC_BUILD_NULLGFX
+#endif
+#endif
+
 #if defined CC_BUILD_D3D9 || defined CC_BUILD_D3D11
 typedef void* GfxResourceID;
 #else
@@ -131,6 +131,7 @@ cc_bool Drawer2D_SetFontBitmap(struct Bitmap* bmp) {
 	FreeFontBitmap();
 	fontBitmap = *bmp;
 	tileSize   = bmp->width >> LOG2_CHARS_PER_ROW;
+	Mem_SetPlace(fontBitmap.scan0, "font bitmap");
 
 	CalculateTextWidths();
 	return true;
@@ -896,7 +897,11 @@ static cc_result SysFont_Init(const cc_string* path, struct SysFont* font, FT_Op
 	return 0;
 }
 
-static void* FT_AllocWrapper(FT_Memory memory, long size) { return Mem_TryAlloc(size, 1); }
+static void* FT_AllocWrapper(FT_Memory memory, long size) {
+	void* ptr = Mem_TryAlloc(size, 1);
+	Mem_SetPlace(ptr, "freetype");
+	return ptr;
+}
 static void FT_FreeWrapper(FT_Memory memory, void* block) { Mem_Free(block); }
 static void* FT_ReallocWrapper(FT_Memory memory, long cur_size, long new_size, void* block) {
 	return Mem_TryRealloc(block, new_size, 1);
@@ -1096,6 +1101,7 @@ cc_result Font_Make(struct FontDesc* desc, const cc_string* fontName, int size,
 	Convert_ParseInt(&index, &faceIndex);
 
 	font = (struct SysFont*)Mem_TryAlloc(1, sizeof(struct SysFont));
+	Mem_SetPlace(font, "system font");
 	if (!font) return ERR_OUT_OF_MEMORY;
 
 	SysFonts_InitLibrary();
@@ -437,6 +437,7 @@ static cc_result ApplySkin(struct Entity* e, struct Bitmap* bmp, struct Stream*
 	Gfx_DeleteTexture(&e->TextureId);
 	Entity_SetSkinAll(e, true);
 	if ((res = EnsurePow2Skin(e, bmp))) return res;
+	Mem_SetPlace(bmp->scan0, "skin bitmap");
 	e->SkinType = Utils_CalcSkinType(bmp);
 
 	if (bmp->width > Gfx.MaxTexWidth || bmp->height > Gfx.MaxTexHeight) {
@@ -535,29 +536,434 @@ void Entity_SetSkin(struct Entity* e, const cc_string* skin) {
 }
 
 
+/*########################################################################################################################*
+*-------------------------------------------------------Entity grid-------------------------------------------------------*
+*#########################################################################################################################*/
+/* Entities are bucketed by the chunk sized cell their position is in, so that entities near a */
+/*  point or along a ray can be found without checking every single entity. Cells are hashed */
+/*  into a fixed number of buckets, so the grid doesn't depend on the size of the map. */
+#define GRID_SHIFT 4
+#define GRID_SIZE (1 << GRID_SHIFT)
+#define GRID_BUCKETS 256
+/* Entities whose model extends further than this from their position are always checked */
+#define GRID_MAX_EXTENT ((float)GRID_SIZE)
+/* Entities further away than this from the origin are always checked */
+#define GRID_MAX_COORD 1000000.0f
+/* Queries covering more cells than this just check every entity instead */
+#define GRID_MAX_CELLS 256
+#define GRID_NONE  -1
+#define GRID_LARGE GRID_BUCKETS
+
+static struct EntityGrid {
+	cc_int16 heads[GRID_BUCKETS + 1];    /* First entity in each bucket (last bucket is for large entities) */
+	cc_int16 next[ENTITIES_MAX_COUNT];   /* Next entity in the same bucket */
+	cc_int16 bucket[ENTITIES_MAX_COUNT]; /* Bucket each entity is in, or GRID_NONE */
+	IVec3 cells[ENTITIES_MAX_COUNT];     /* Cell each entity is in */
+} grid;
+
+/* Unsigned multiplication, as signed integer overflow is undefined behaviour */
+#define EntityGrid_Hash(x, y, z) ((int)((((cc_uint32)(x) * 73856093u) ^ ((cc_uint32)(y) * 19349663u) ^ ((cc_uint32)(z) * 83492791u)) & (GRID_BUCKETS - 1)))
+
+static void EntityGrid_Init(void) {
+	int i;
+	for (i = 0; i < Array_Elems(grid.heads);  i++) grid.heads[i]  = GRID_NONE;
+	for (i = 0; i < Array_Elems(grid.bucket); i++) grid.bucket[i] = GRID_NONE;
+}
+
+static void EntityGrid_Remove(int id) {
+	cc_int16* link;
+	if (grid.bucket[id] == GRID_NONE) return;
+
+	for (link = &grid.heads[grid.bucket[id]]; *link != GRID_NONE; link = &grid.next[*link]) {
+		if (*link != id) continue;
+		*link = grid.next[id]; break;
+	}
+	grid.bucket[id] = GRID_NONE;
+}
+
+static cc_bool EntityGrid_IsLarge(struct Entity* e) {
+	struct AABB* bb = &e->ModelAABB;
+	float extent    = max(max(-bb->Min.X, bb->Max.X), max(-bb->Min.Z, bb->Max.Z));
+	extent = max(extent, max(-bb->Min.Y, bb->Max.Y));
+	extent = max(extent, max(e->Size.X, max(e->Size.Y, e->Size.Z)));
+
+	/* NOTE: Also catches NaN positions, as all comparisons with NaN are false */
+	return !(extent < GRID_MAX_EXTENT
+		&& Math_AbsF(e->Position.X) < GRID_MAX_COORD 
+		&& Math_AbsF(e->Position.Y) < GRID_MAX_COORD 
+		&& Math_AbsF(e->Position.Z) < GRID_MAX_COORD);
+}
+
+/* Moves the given entity into the bucket for its current position, if necessary */
+static void EntityGrid_Update(int id) {
+	struct Entity* e = Entities.List[id];
+	IVec3 cell;
+	int bucket;
+
+	if (EntityGrid_IsLarge(e)) {
+		bucket = GRID_LARGE;
+	} else {
+		cell.X = Math_Floor(e->Position.X) >> GRID_SHIFT;
+		cell.Y = Math_Floor(e->Position.Y) >> GRID_SHIFT;
+		cell.Z = Math_Floor(e->Position.Z) >> GRID_SHIFT;
+		bucket = EntityGrid_Hash(cell.X, cell.Y, cell.Z);
+
+		grid.cells[id] = cell;
+	}
+
+	if (bucket == grid.bucket[id]) return;
+	EntityGrid_Remove(id);
+	grid.bucket[id]   = bucket;
+	grid.next[id]     = grid.heads[bucket];
+	grid.heads[bucket] = id;
+}
+
+/* Marks all entities in the given bucket that are in a cell within the given bounds */
+static void EntityGrid_MarkBucket(cc_uint8* found, int bucket, const IVec3* min, const IVec3* max) {
+	IVec3* cell;
+	int id;
+
+	for (id = grid.heads[bucket]; id != GRID_NONE; id = grid.next[id]) {
+		cell = &grid.cells[id];
+		if (cell->X < min->X || cell->Y < min->Y || cell->Z < min->Z) continue;
+		if (cell->X > max->X || cell->Y > max->Y || cell->Z > max->Z) continue;
+		found[id >> 3] |= 1 << (id & 0x07);
+	}
+}
+
+/* Marks all entities in cells within the given bounds */
+static void EntityGrid_MarkCells(cc_uint8* found, const IVec3* min, const IVec3* max) {
+	int x, y, z;
+	for (y = min->Y; y <= max->Y; y++) {
+		for (z = min->Z; z <= max->Z; z++) {
+			for (x = min->X; x <= max->X; x++) {
+				EntityGrid_MarkBucket(found, EntityGrid_Hash(x, y, z), min, max);
+			}
+		}
+	}
+}
+
+/* Outputs the IDs of all marked entities, in ascending order */
+static int EntityGrid_Output(cc_uint8* found, EntityID* ids) {
+	int id, count = 0;
+	/* Large entities might be anywhere */
+	for (id = grid.heads[GRID_LARGE]; id != GRID_NONE; id = grid.next[id]) {
+		found[id >> 3] |= 1 << (id & 0x07);
+	}
+
+	for (id = 0; id < ENTITIES_MAX_COUNT; id++) {
+		if (!Entities.List[id]) continue;
+		/* Entities not added to the grid yet might also be anywhere */
+		if ((found[id >> 3] & (1 << (id & 0x07))) || grid.bucket[id] == GRID_NONE) {
+			ids[count++] = (EntityID)id;
+		}
+	}
+	return count;
+}
+
+/* Outputs the IDs of all entities, in ascending order */
+static int EntityGrid_OutputAll(EntityID* ids) {
+	int id, count = 0;
+	for (id = 0; id < ENTITIES_MAX_COUNT; id++) {
+		if (Entities.List[id]) ids[count++] = (EntityID)id;
+	}
+	return count;
+}
+
+static void EntityGrid_GetCell(const Vec3* pos, IVec3* cell) {
+	cell->X = Math_Floor(pos->X) >> GRID_SHIFT;
+	cell->Y = Math_Floor(pos->Y) >> GRID_SHIFT;
+	cell->Z = Math_Floor(pos->Z) >> GRID_SHIFT;
+}
+
+int Entities_QueryBox(const struct AABB* bb, EntityID* ids) {
+	cc_uint8 found[ENTITIES_MAX_COUNT >> 3] = { 0 };
+	IVec3 min, max;
+	float cells;
+
+	if (!(Math_AbsF(bb->Min.X) < GRID_MAX_COORD && Math_AbsF(bb->Max.X) < GRID_MAX_COORD &&
+		  Math_AbsF(bb->Min.Y) < GRID_MAX_COORD && Math_AbsF(bb->Max.Y) < GRID_MAX_COORD &&
+		  Math_AbsF(bb->Min.Z) < GRID_MAX_COORD && Math_AbsF(bb->Max.Z) < GRID_MAX_COORD)) {
+		return EntityGrid_OutputAll(ids);
+	}
+
+	/* Entities in neighbouring cells might still extend into the box */
+	EntityGrid_GetCell(&bb->Min, &min); min.X--; min.Y--; min.Z--;
+	EntityGrid_GetCell(&bb->Max, &max); max.X++; max.Y++; max.Z++;
+
+	cells = (float)(max.X - min.X + 1) * (max.Y - min.Y + 1) * (max.Z - min.Z + 1);
+	if (cells > GRID_MAX_CELLS) return EntityGrid_OutputAll(ids);
+
+	EntityGrid_MarkCells(found, &min, &max);
+	return EntityGrid_Output(found, ids);
+}
+
+/* Distance along one axis from the given coordinate to the given range */
+static float EntityGrid_AxisDist(float v, float min, float max) {
+	return v < min ? min - v : (v > max ? v - max : 0.0f);
+}
+
+int Entities_QueryRadius(Vec3 pos, float radius, EntityID* ids) {
+	struct AABB bb, *bounds;
+	int i, slot, count, kept = 0;
+	float dx, dy, dz;
+
+	bb.Min.X = pos.X - radius; bb.Max.X = pos.X + radius;
+	bb.Min.Y = pos.Y - radius; bb.Max.Y = pos.Y + radius;
+	bb.Min.Z = pos.Z - radius; bb.Max.Z = pos.Z + radius;
+	count = Entities_QueryBox(&bb, ids);
+
+	for (i = 0; i < count; i++) {
+		slot = EntityTable.Slots[ids[i]];
+		/* Entities not in the table yet have no known bounds, so are always kept */
+		if (slot >= 0) {
+			bounds = &EntityTable.Bounds[slot];
+			dx = EntityGrid_AxisDist(pos.X, bounds->Min.X, bounds->Max.X);
+			dy = EntityGrid_AxisDist(pos.Y, bounds->Min.Y, bounds->Max.Y);
+			dz = EntityGrid_AxisDist(pos.Z, bounds->Min.Z, bounds->Max.Z);
+			if (dx * dx + dy * dy + dz * dz > radius * radius) continue;
+		}
+		ids[kept++] = ids[i];
+	}
+	return kept;
+}
+
+static int EntityGrid_Step(float dir) { return dir > 0.0f ? 1 : (dir < 0.0f ? -1 : 0); }
+
+static float EntityGrid_NextBoundary(float origin, float dir, int cell, int step) {
+	float edge;
+	if (!step) return MATH_POS_INF;
+
+	edge = (float)((cell + (step > 0 ? 1 : 0)) << GRID_SHIFT);
+	return (edge - origin) / dir;
+}
+
+int Entities_QueryRay(Vec3 origin, Vec3 dir, float maxDist, EntityID* ids) {
+	cc_uint8 found[ENTITIES_MAX_COUNT >> 3] = { 0 };
+	IVec3 cell, step, bMin, bMax, nMin, nMax;
+	Vec3 tMax, tDelta;
+	int i, id, steps;
+
+	if (!(Math_AbsF(origin.X) < GRID_MAX_COORD && Math_AbsF(origin.Y) < GRID_MAX_COORD 
+		&& Math_AbsF(origin.Z) < GRID_MAX_COORD)) return EntityGrid_OutputAll(ids);
+
+	/* Work out bounds of all cells entities are currently in */
+	bMin.X = Int32_MaxValue; bMin.Y = Int32_MaxValue; bMin.Z = Int32_MaxValue;
+	bMax.X = Int32_MinValue; bMax.Y = Int32_MinValue; bMax.Z = Int32_MinValue;
+
+	for (i = 0; i < GRID_BUCKETS; i++) {
+		for (id = grid.heads[i]; id != GRID_NONE; id = grid.next[id]) {
+			IVec3_Min(&bMin, &bMin, &grid.cells[id]);
+			IVec3_Max(&bMax, &bMax, &grid.cells[id]);
+		}
+	}
+	/* Entities in neighbouring cells might still extend into the ray's cells */
+	bMin.X--; bMin.Y--; bMin.Z--;
+	bMax.X++; bMax.Y++; bMax.Z++;
+
+	/* Walk the cells along the ray (see "A Fast Voxel Traversal Algorithm for Ray Tracing") */
+	EntityGrid_GetCell(&origin, &cell);
+	step.X = EntityGrid_Step(dir.X); 
+	step.Y = EntityGrid_Step(dir.Y); 
+	step.Z = EntityGrid_Step(dir.Z);
+
+	tMax.X = EntityGrid_NextBoundary(origin.X, dir.X, cell.X, step.X);
+	tMax.Y = EntityGrid_NextBoundary(origin.Y, dir.Y, cell.Y, step.Y);
+	tMax.Z = EntityGrid_NextBoundary(origin.Z, dir.Z, cell.Z, step.Z);
+	tDelta.X = step.X ? GRID_SIZE / Math_AbsF(dir.X) : MATH_POS_INF;
+	tDelta.Y = step.Y ? GRID_SIZE / Math_AbsF(dir.Y) : MATH_POS_INF;
+	tDelta.Z = step.Z ? GRID_SIZE / Math_AbsF(dir.Z) : MATH_POS_INF;
+
+	for (steps = 0; ; steps++) {
+		/* Stop once the ray has left all cells with entities in them, and won't come back */
+		if ((cell.X < bMin.X && step.X <= 0) || (cell.X > bMax.X && step.X >= 0)) break;
+		if ((cell.Y < bMin.Y && step.Y <= 0) || (cell.Y > bMax.Y && step.Y >= 0)) break;
+		if ((cell.Z < bMin.Z && step.Z <= 0) || (cell.Z > bMax.Z && step.Z >= 0)) break;
+		if (steps == GRID_MAX_CELLS) return EntityGrid_OutputAll(ids);
+
+		nMin.X = cell.X - 1; nMin.Y = cell.Y - 1; nMin.Z = cell.Z - 1;
+		nMax.X = cell.X + 1; nMax.Y = cell.Y + 1; nMax.Z = cell.Z + 1;
+		EntityGrid_MarkCells(found, &nMin, &nMax);
+
+		if (tMax.X <= tMax.Y && tMax.X <= tMax.Z) {
+			if (tMax.X > maxDist) break;
+			cell.X += step.X; tMax.X += tDelta.X;
+		} else if (tMax.Y <= tMax.Z) {
+			if (tMax.Y > maxDist) break;
+			cell.Y += step.Y; tMax.Y += tDelta.Y;
+		} else {
+			if (tMax.Z > maxDist) break;
+			cell.Z += step.Z; tMax.Z += tDelta.Z;
+		}
+	}
+	return EntityGrid_Output(found, ids);
+}
+
+
 /*########################################################################################################################*
 *--------------------------------------------------------Entities---------------------------------------------------------*
 *#########################################################################################################################*/
 struct _EntitiesData Entities;
+struct _EntityTableData EntityTable;
 static EntityID entities_closestId;
+#define ENTITYTABLE_MIN_CAPACITY 16
+
+static void EntityTable_Init(void) {
+	int i;
+	for (i = 0; i < ENTITIES_MAX_COUNT; i++) EntityTable.Slots[i] = -1;
+}
+
+static void EntityTable_Free(void) {
+	Mem_Free(EntityTable.IDs);
+	Mem_Free(EntityTable.Ptrs);
+	Mem_Free(EntityTable.Positions);
+	Mem_Free(EntityTable.Velocities);
+	Mem_Free(EntityTable.Bounds);
+
+	EntityTable.IDs       = NULL; EntityTable.Ptrs       = NULL;
+	EntityTable.Positions = NULL; EntityTable.Velocities = NULL;
+	EntityTable.Bounds    = NULL;
+	EntityTable.Count     = 0;    EntityTable.Capacity   = 0;
+}
+
+static void EntityTable_Resize(void) {
+	int capacity = max(ENTITYTABLE_MIN_CAPACITY, EntityTable.Capacity * 2);
+	EntityTable.IDs        = (EntityID*)Mem_Realloc(EntityTable.IDs, capacity, 
+								sizeof(EntityID),       "entity IDs");
+	EntityTable.Ptrs       = (struct Entity**)Mem_Realloc(EntityTable.Ptrs, capacity, 
+								sizeof(struct Entity*), "entity ptrs");
+	EntityTable.Positions  = (Vec3*)Mem_Realloc(EntityTable.Positions, capacity, 
+								sizeof(Vec3),           "entity positions");
+	EntityTable.Velocities = (Vec3*)Mem_Realloc(EntityTable.Velocities, capacity, 
+								sizeof(Vec3),           "entity velocities");
+	EntityTable.Bounds     = (struct AABB*)Mem_Realloc(EntityTable.Bounds, capacity, 
+								sizeof(struct AABB),    "entity bounds");
+	EntityTable.Capacity   = capacity;
+}
+
+/* Refreshes the densely packed copy of the given entity's data */
+static void EntityTable_Sync(int slot) {
+	struct Entity* e = EntityTable.Ptrs[slot];
+	EntityTable.Positions[slot]  = e->Position;
+	EntityTable.Velocities[slot] = e->Velocity;
+	Entity_GetBounds(e, &EntityTable.Bounds[slot]);
+}
+
+/* Moves the slots from the given slot onwards by the given amount */
+static void EntityTable_Shift(int slot, int amount) {
+	int i, count = EntityTable.Count - slot;
+	if (count <= 0) return;
+
+	/* Slots might overlap, so can't just use Mem_Copy */
+	if (amount > 0) {
+		for (i = count - 1; i >= 0; i--) {
+			EntityTable.IDs[slot + i + amount]        = EntityTable.IDs[slot + i];
+			EntityTable.Ptrs[slot + i + amount]       = EntityTable.Ptrs[slot + i];
+			EntityTable.Positions[slot + i + amount]  = EntityTable.Positions[slot + i];
+			EntityTable.Velocities[slot + i + amount] = EntityTable.Velocities[slot + i];
+			EntityTable.Bounds[slot + i + amount]     = EntityTable.Bounds[slot + i];
+		}
+	} else {
+		for (i = 0; i < count; i++) {
+			EntityTable.IDs[slot + i + amount]        = EntityTable.IDs[slot + i];
+			EntityTable.Ptrs[slot + i + amount]       = EntityTable.Ptrs[slot + i];
+			EntityTable.Positions[slot + i + amount]  = EntityTable.Positions[slot + i];
+			EntityTable.Velocities[slot + i + amount] = EntityTable.Velocities[slot + i];
+			EntityTable.Bounds[slot + i + amount]     = EntityTable.Bounds[slot + i];
+		}
+	}
+
+	for (i = slot + amount; i < EntityTable.Count + amount; i++) {
+		EntityTable.Slots[EntityTable.IDs[i]] = i;
+	}
+}
+
+static void EntityTable_Insert(EntityID id, struct Entity* e) {
+	int slot = EntityTable.Slots[id];
+	if (slot >= 0) { EntityTable.Ptrs[slot] = e; EntityTable_Sync(slot); return; }
+
+	if (EntityTable.Count == EntityTable.Capacity) EntityTable_Resize();
+	/* Keep slots in ascending ID order, so entities are still updated in the same order as before */
+	for (slot = 0; slot < EntityTable.Count; slot++) {
+		if (EntityTable.IDs[slot] > id) break;
+	}
+
+	EntityTable_Shift(slot, 1);
+	EntityTable.Count++;
+	EntityTable.IDs[slot]  = id;
+	EntityTable.Ptrs[slot] = e;
+	EntityTable.Slots[id]  = slot;
+	EntityTable_Sync(slot);
+}
+
+static void EntityTable_Delete(EntityID id) {
+	int slot = EntityTable.Slots[id];
+	if (slot < 0) return;
+
+	EntityTable.Slots[id] = -1;
+	EntityTable_Shift(slot + 1, -1);
+	EntityTable.Count--;
+}
+
+/* Plugins might directly change entries in Entities.List instead of using Entities_Add/Remove, */
+/*  so the table is made to match Entities.List (checking every ID is cheap compared to ticking) */
+static void EntityTable_CheckList(void) {
+	struct Entity* e;
+	int id, slot;
+
+	for (id = 0; id < ENTITIES_MAX_COUNT; id++) {
+		e    = Entities.List[id];
+		slot = EntityTable.Slots[id];
+		if (e == (slot >= 0 ? EntityTable.Ptrs[slot] : NULL)) continue;
+
+		if (e) {
+			EntityTable_Insert(id, e);
+		} else {
+			EntityTable_Delete(id);
+		}
+		/* Same as Entities_Add, entity must always be checked in queries until next update */
+		EntityGrid_Remove(id);
+	}
+}
 
 void Entities_Tick(struct ScheduledTask* task) {
+	struct Entity* e;
 	int i;
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i]) continue;
-		Entities.List[i]->VTABLE->Tick(Entities.List[i], task->interval);
+	EntityTable_CheckList();
+
+	for (i = 0; i < EntityTable.Count; i++) {
+		e = EntityTable.Ptrs[i];
+		e->VTABLE->Tick(e, task->interval);
+		EntityTable_Sync(i);
+		EntityGrid_Update(EntityTable.IDs[i]);
+	}
+}
+
+/* Skins are checked separately from Entities_Tick, as that may run on the entity tick thread */
+/*  while applying a downloaded skin requires creating a texture on the main thread */
+static void Entities_CheckSkins(struct ScheduledTask* task) {
+	int i;
+	for (i = 0; i < EntityTable.Count; i++) {
+		Entity_CheckSkin(EntityTable.Ptrs[i]);
 	}
 }
 
 void Entities_RenderModels(double delta, float t) {
+	struct Entity* e;
 	int i;
+	/* Entities.List may have been changed since last tick */
+	EntityTable_CheckList();
 	Gfx_SetTexturing(true);
 	Gfx_SetAlphaTest(true);
+	Model_BeginBatch();
 	
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i]) continue;
-		Entities.List[i]->VTABLE->RenderModel(Entities.List[i], delta, t);
+	for (i = 0; i < EntityTable.Count; i++) {
+		e = EntityTable.Ptrs[i];
+		e->VTABLE->RenderModel(e, delta, t);
+		EntityTable_Sync(i);
+		EntityGrid_Update(EntityTable.IDs[i]);
 	}
+	Model_EndBatch();
 	Gfx_SetTexturing(false);
 	Gfx_SetAlphaTest(false);
 }
@@ -566,7 +972,7 @@ void Entities_RenderModels(double delta, float t) {
 void Entities_RenderNames(void) {
 	struct LocalPlayer* p = &LocalPlayer_Instance;
 	cc_bool hadFog;
-	int i;
+	int i, id;
 
 	if (Entities.NamesMode == NAME_MODE_NONE) return;
 	entities_closestId = Entities_GetClosest(&p->Base);
@@ -577,10 +983,10 @@ void Entities_RenderNames(void) {
 	hadFog = Gfx_GetFog();
 	if (hadFog) Gfx_SetFog(false);
 
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i]) continue;
-		if (i != entities_closestId || i == ENTITIES_SELF_ID) {
-			Entities.List[i]->VTABLE->RenderName(Entities.List[i]);
+	for (i = 0; i < EntityTable.Count; i++) {
+		id = EntityTable.IDs[i];
+		if (id != entities_closestId || id == ENTITIES_SELF_ID) {
+			EntityTable.Ptrs[i]->VTABLE->RenderName(EntityTable.Ptrs[i]);
 		}
 	}
 
@@ -592,7 +998,7 @@ void Entities_RenderNames(void) {
 void Entities_RenderHoveredNames(void) {
 	struct LocalPlayer* p = &LocalPlayer_Instance;
 	cc_bool allNames, hadFog;
-	int i;
+	int i, id;
 
 	if (Entities.NamesMode == NAME_MODE_NONE) return;
 	allNames = !(Entities.NamesMode == NAME_MODE_HOVERED || Entities.NamesMode == NAME_MODE_ALL) 
@@ -604,10 +1010,10 @@ void Entities_RenderHoveredNames(void) {
 	hadFog = Gfx_GetFog();
 	if (hadFog) Gfx_SetFog(false);
 
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i]) continue;
-		if ((i == entities_closestId || allNames) && i != ENTITIES_SELF_ID) {
-			Entities.List[i]->VTABLE->RenderName(Entities.List[i]);
+	for (i = 0; i < EntityTable.Count; i++) {
+		id = EntityTable.IDs[i];
+		if ((id == entities_closestId || allNames) && id != ENTITIES_SELF_ID) {
+			EntityTable.Ptrs[i]->VTABLE->RenderName(EntityTable.Ptrs[i]);
 		}
 	}
 
@@ -644,10 +1050,20 @@ static void Entities_ChatFontChanged(void* obj) {
 	}
 }
 
+void Entities_Add(EntityID id, struct Entity* e) {
+	Entities.List[id] = e;
+	EntityTable_Insert(id, e);
+	/* Position might not be set yet, so always check entity in queries until next tick */
+	EntityGrid_Remove(id);
+}
+
 void Entities_Remove(EntityID id) {
 	Event_RaiseInt(&EntityEvents.Removed, id);
 	Entities.List[id]->VTABLE->Despawn(Entities.List[id]);
+	Model_FreeCache(Entities.List[id]);
 	Entities.List[id] = NULL;
+	EntityTable_Delete(id);
+	EntityGrid_Remove(id);
 }
 
 EntityID Entities_GetClosest(struct Entity* src) {
@@ -655,13 +1071,17 @@ EntityID Entities_GetClosest(struct Entity* src) {
 	Vec3 dir = Vec3_GetDirVector(src->Yaw * MATH_DEG2RAD, src->Pitch * MATH_DEG2RAD);
 	float closestDist = MATH_POS_INF;
 	EntityID targetId = ENTITIES_SELF_ID;
+	EntityID ids[ENTITIES_MAX_COUNT];
 
 	float t0, t1;
-	int i;
+	int i, j, count;
+	count = Entities_QueryRay(eyePos, dir, MATH_POS_INF, ids);
 
-	for (i = 0; i < ENTITIES_SELF_ID; i++) { /* because we don't want to pick against local player */
-		struct Entity* entity = Entities.List[i];
-		if (!entity) continue;
+	for (j = 0; j < count; j++) {
+		struct Entity* entity;
+		i = ids[j];
+		if (i == ENTITIES_SELF_ID) continue; /* because we don't want to pick against local player */
+		entity = Entities.List[i];
 
 		if (Intersection_RayIntersectsRotatedBox(eyePos, dir, entity, &t0, &t1) && t0 < closestDist) {
 			closestDist = t0;
@@ -672,6 +1092,7 @@ EntityID Entities_GetClosest(struct Entity* src) {
 }
 
 void Entities_DrawShadows(void) {
+	struct Entity* e;
 	int i;
 	if (Entities.ShadowsMode == SHADOW_MODE_NONE) return;
 	ShadowComponent_BoundShadowTex = false;
@@ -685,9 +1106,10 @@ void Entities_DrawShadows(void) {
 	ShadowComponent_Draw(Entities.List[ENTITIES_SELF_ID]);
 
 	if (Entities.ShadowsMode == SHADOW_MODE_CIRCLE_ALL) {	
-		for (i = 0; i < ENTITIES_SELF_ID; i++) {
-			if (!Entities.List[i] || !Entities.List[i]->ShouldRender) continue;
-			ShadowComponent_Draw(Entities.List[i]);
+		for (i = 0; i < EntityTable.Count; i++) {
+			e = EntityTable.Ptrs[i];
+			if (EntityTable.IDs[i] == ENTITIES_SELF_ID || !e->ShouldRender) continue;
+			ShadowComponent_Draw(e);
 		}
 	}
 
@@ -815,12 +1237,12 @@ static void LocalPlayer_HandleInput(float* xMoving, float* zMoving) {
 	hacks->FlyingUp    = KeyBind_IsPressed(KEYBIND_FLY_UP);
 	hacks->FlyingDown  = KeyBind_IsPressed(KEYBIND_FLY_DOWN);
 
+	/* NOTE: Noclip state itself is changed in LocalPlayer_InputSet */
 	if (hacks->WOMStyleHacks && hacks->Enabled && hacks->CanNoclip) {
 		if (hacks->Noclip) {
 			/* need a { } block because it's a macro */
 			Vec3_Set(p->Base.Velocity, 0,0,0);
 		}
-		HacksComp_SetNoclip(hacks, KeyBind_IsPressed(KEYBIND_NOCLIP));
 	}
 }
 
@@ -830,6 +1252,12 @@ static void LocalPlayer_InputSet(int key, cc_bool pressed) {
 	if (pressed && !hacks->Enabled) return;
 	if (key == KeyBinds[KEYBIND_SPEED])      hacks->Speeding     = pressed;
 	if (key == KeyBinds[KEYBIND_HALF_SPEED]) hacks->HalfSpeeding = pressed;
+
+	/* WoM style noclip is only active while noclip key is held down */
+	/* NOTE: Changed here instead of in LocalPlayer_Tick, since that may run on the entity tick thread */
+	if (key == KeyBinds[KEYBIND_NOCLIP] && hacks->WOMStyleHacks && hacks->CanNoclip) {
+		HacksComp_SetNoclip(hacks, pressed);
+	}
 }
 
 static void LocalPlayer_InputDown(void* obj, int key, cc_bool was) {
@@ -881,7 +1309,6 @@ static void LocalPlayer_Tick(struct Entity* e, double delta) {
 	AnimatedComp_Update(e, p->Interp.Prev.Pos, p->Interp.Next.Pos, delta);
 	TiltComp_Update(&p->Tilt, delta);
 
-	Entity_CheckSkin(&p->Base);
 	SoundComp_Tick(wasOnGround);
 }
 
@@ -1138,8 +1565,6 @@ static void NetPlayer_Tick(struct Entity* e, double delta) {
 	struct NetPlayer* p = (struct NetPlayer*)e;
 	NetInterpComp_AdvanceState(&p->Interp);
 	p->Base.Position = p->Interp.Prev.Pos;
-
-	Entity_CheckSkin(e);
 	AnimatedComp_Update(e, p->Interp.Prev.Pos, p->Interp.Next.Pos, delta);
 }
 
@@ -1179,6 +1604,8 @@ void NetPlayer_Init(struct NetPlayer* p) {
 *---------------------------------------------------Entities component----------------------------------------------------*
 *#########################################################################################################################*/
 static void Entities_Init(void) {
+	EntityGrid_Init();
+	EntityTable_Init();
 	Event_Register_(&GfxEvents.ContextLost,  NULL, Entities_ContextLost);
 	Event_Register_(&ChatEvents.FontChanged, NULL, Entities_ChatFontChanged);
 	Event_Register_(&InputEvents.Down,       NULL, LocalPlayer_InputDown);
@@ -1194,6 +1621,8 @@ static void Entities_Init(void) {
 
 	Entities.List[ENTITIES_SELF_ID] = &LocalPlayer_Instance.Base;
 	LocalPlayer_Init();
+	EntityTable_Insert(ENTITIES_SELF_ID, &LocalPlayer_Instance.Base);
+	ScheduledTask_AddEx("Entities_CheckSkins", GAME_DEF_TICKS, Entities_CheckSkins, TASK_PRIORITY_NORMAL, 1, 0);
 }
 
 static void Entities_Free(void) {
@@ -1202,6 +1631,7 @@ static void Entities_Free(void) {
 		if (!Entities.List[i]) continue;
 		Entities_Remove((EntityID)i);
 	}
+	EntityTable_Free();
 	Gfx_DeleteTexture(&ShadowComponent_ShadowTex);
 }
 
@@ -95,6 +95,8 @@ struct Entity {
 	char SkinRaw[STRING_SIZE];
 	char NameRaw[STRING_SIZE];
 	struct Texture NameTex;
+	/* Vertices from last time model was drawn, see Model_Render */
+	struct ModelCache* ModelCache;
 };
 typedef cc_bool (*Entity_TouchesCondition)(BlockID block);
 
@@ -130,11 +132,28 @@ void Entity_SetSkin(struct Entity* e, const cc_string* skin);
 
 /* Global data for all entities */
 /* (Actual entities may point to NetPlayers_List or elsewhere) */
+/* NOTE: Entities should be added/removed using Entities_Add/Entities_Remove. List entries changed */
+/*  directly are only copied into EntityTable at the start of the next Entities_Tick or Entities_RenderModels, */
+/*  so such entities are not ticked or rendered (and have stale EntityTable data) until then. */
 CC_VAR extern struct _EntitiesData {
 	struct Entity* List[ENTITIES_MAX_COUNT];
 	cc_uint8 NamesMode, ShadowsMode;
 } Entities;
 
+/* Densely packed copy of frequently accessed data of all entities, in ascending ID order. */
+/* Loops over all entities should iterate over this, instead of checking every entry in Entities.List */
+/* NOTE: Positions/Velocities/Bounds are only refreshed after entities are ticked and rendered */
+CC_VAR extern struct _EntityTableData {
+	int Count, Capacity;
+	EntityID* IDs;         /* ID of entity in each slot */
+	struct Entity** Ptrs;  /* Entity in each slot */
+	Vec3* Positions;       /* Position of entity in each slot */
+	Vec3* Velocities;      /* Velocity of entity in each slot */
+	struct AABB* Bounds;   /* Entity_GetBounds of entity in each slot */
+	/* Slot of the entity with the given ID, or -1 if no such entity */
+	cc_int16 Slots[ENTITIES_MAX_COUNT];
+} EntityTable;
+
 /* Ticks all entities. */
 void Entities_Tick(struct ScheduledTask* task);
 /* Renders all entities. */
@@ -143,10 +162,25 @@ void Entities_RenderModels(double delta, float t);
 void Entities_RenderNames(void);
 /* Renders hovered entity name tags. (these appears through blocks) */
 void Entities_RenderHoveredNames(void);
+/* Sets the entity with the given ID. (replacing any existing entity) */
+/* NOTE: Does not raise EntityEvents.Added event */
+CC_API void Entities_Add(EntityID id, struct Entity* e);
 /* Removes the given entity, raising EntityEvents.Removed event. */
 void Entities_Remove(EntityID id);
 /* Gets the ID of the closest entity to the given entity. */
 EntityID Entities_GetClosest(struct Entity* src);
+
+/* Outputs the IDs of all entities that might intersect the given box, in ascending order. */
+/* NOTE: This is conservative, so callers must still check if entities really do intersect. */
+/* ids must have room for ENTITIES_MAX_COUNT entries. Returns number of IDs output. */
+int Entities_QueryBox(const struct AABB* bb, EntityID* ids);
+/* Outputs the IDs of all entities whose bounds might be within radius of the given position, in ascending order. */
+/* NOTE: Bounds are from EntityTable, so same caveats as Entities_QueryBox apply. */
+int Entities_QueryRadius(Vec3 pos, float radius, EntityID* ids);
+/* Outputs the IDs of all entities that might be hit by the given ray, up to maxDist along it. */
+/* NOTE: Same caveats as Entities_QueryBox apply. dir does not need to be normalised, */
+/*  in which case maxDist is in multiples of the length of dir. */
+int Entities_QueryRay(Vec3 origin, Vec3 dir, float maxDist, EntityID* ids);
 /* Draws shadows under entities, depending on Entities.ShadowsMode */
 void Entities_DrawShadows(void);
 
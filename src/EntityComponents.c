@@ -1201,25 +1201,39 @@ float PhysicsComp_CalcJumpVelocity(float jumpHeight) {
 }
 
 void PhysicsComp_DoEntityPush(struct Entity* entity) {
+	EntityID ids[ENTITIES_MAX_COUNT];
 	struct Entity* other;
+	struct AABB* otherBB;
+	Vec3* otherPos;
 	cc_bool yIntersects;
-	Vec3 dir;
-	float dist, pushStrength;
-	int id;
+	Vec3 dir, centre;
+	float dist, pushStrength, halfY;
+	int i, slot, count;
 	dir.Y = 0.0f;
 
-	for (id = 0; id < ENTITIES_MAX_COUNT; id++) {
-		other = Entities.List[id];
-		if (!other || other == entity) continue;
+	/* Only entities within 1 block horizontally that overlap vertically can push, so a sphere */
+	/*  centred halfway up the entity and reaching 1 block out at its feet and head contains them */
+	halfY  = entity->Size.Y * 0.5f;
+	centre = entity->Position; centre.Y += halfY;
+	count  = Entities_QueryRadius(centre, Math_SqrtF(1.0f + halfY * halfY), ids);
+
+	for (i = 0; i < count; i++) {
+		slot = EntityTable.Slots[ids[i]];
+		if (slot < 0) continue;
+
+		other    = EntityTable.Ptrs[slot];
+		otherPos = &EntityTable.Positions[slot];
+		otherBB  = &EntityTable.Bounds[slot];
+		if (other == entity) continue;
 		if (!other->Model->pushes)     continue;
 
 		yIntersects =
-			entity->Position.Y <= (other->Position.Y  + other->Size.Y) &&
-			 other->Position.Y <= (entity->Position.Y + entity->Size.Y);
+			entity->Position.Y <= otherBB->Max.Y &&
+			 otherPos->Y <= (entity->Position.Y + entity->Size.Y);
 		if (!yIntersects) continue;
 
-		dir.X = other->Position.X - entity->Position.X;
-		dir.Z = other->Position.Z - entity->Position.Z;
+		dir.X = otherPos->X - entity->Position.X;
+		dir.Z = otherPos->Z - entity->Position.Z;
 		dist = dir.X * dir.X + dir.Z * dir.Z;
 		if (dist < 0.002f || dist > 1.0f) continue; /* TODO: range needs to be lower? */
 
@@ -114,5 +114,11 @@ enum CC_ERRORS {
 	ERR_NO_AUDIO_OUTPUT  = 0xCCDED05DUL, /* No audio output devices are connected */
 	ERR_INVALID_DATA_URL = 0xCCDED05EUL, /* Invalid URL provided to download from */
 	ERR_INVALID_OPEN_URL = 0xCCDED05FUL, /* Invalid URL provided to open in new tab */
+
+	CCW_ERR_IDENTIFIER = 0xCCDED060UL, /* CCW stream bytes #1-#4 aren't 'CCWR' */
+	CCW_ERR_VERSION    = 0xCCDED061UL, /* CCW stream uses unsupported version or region size */
+	CCW_ERR_REGIONS    = 0xCCDED062UL, /* CCW regions table or region data is corrupted */
+
+	ERR_CHECKSUM_MISMATCH = 0xCCDED063UL, /* Data doesn't match the checksum it was expected to have */
 };
 #endif
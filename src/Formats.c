@@ -5,6 +5,7 @@
 #include "Block.h"
 #include "Entity.h"
 #include "Platform.h"
+#include "Jobs.h"
 #include "ExtMath.h"
 #include "Logger.h"
 #include "Game.h"
@@ -16,6 +17,7 @@
 #include "Chat.h"
 #include "Inventory.h"
 #include "TexturePack.h"
+#include "Utils.h"
 
 
 /*########################################################################################################################*
@@ -24,6 +26,7 @@
 static cc_result Map_ReadBlocks(struct Stream* stream) {
 	World.Volume = World.Width * World.Length * World.Height;
 	World.Blocks = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+	Mem_SetPlace(World.Blocks, "map blocks");
 
 	if (!World.Blocks) return ERR_OUT_OF_MEMORY;
 	return Stream_Read(stream, World.Blocks, World.Volume);
@@ -43,13 +46,14 @@ static cc_result Map_SkipGZipHeader(struct Stream* stream) {
 IMapImporter Map_FindImporter(const cc_string* path) {
 	static const cc_string cw   = String_FromConst(".cw"),  lvl = String_FromConst(".lvl");
 	static const cc_string fcm  = String_FromConst(".fcm"), dat = String_FromConst(".dat");
-	static const cc_string mine = String_FromConst(".mine");
+	static const cc_string mine = String_FromConst(".mine"), ccw = String_FromConst(".ccw");
 
 	if (String_CaselessEnds(path,   &cw))  return Cw_Load;
 	if (String_CaselessEnds(path,  &lvl)) return Lvl_Load;
 	if (String_CaselessEnds(path,  &fcm)) return Fcm_Load;
 	if (String_CaselessEnds(path,  &dat)) return Dat_Load;
 	if (String_CaselessEnds(path, &mine)) return Dat_Load;
+	if (String_CaselessEnds(path,  &ccw)) return Ccw_Load;
 
 	return NULL;
 }
@@ -1095,6 +1099,7 @@ static cc_result Dat_LoadFormat0(struct Stream* stream) {
 	#define PC_VOLUME (256 * 64 * 256)
 	World.Volume = PC_VOLUME;
 	World.Blocks = (BlockRaw*)Mem_TryAlloc(PC_VOLUME, 1);
+	Mem_SetPlace(World.Blocks, "map blocks");
 	if (!World.Blocks) return ERR_OUT_OF_MEMORY;
 
 	/* First 5 bytes already read earlier as .dat header */
@@ -1207,6 +1212,323 @@ cc_result Dat_Load(struct Stream* stream) {
 }
 
 
+/*########################################################################################################################*
+*-------------------------------------------------ClassiCube region format------------------------------------------------*
+*#########################################################################################################################*/
+/* ClassiCube region format is a binary map format, which stores the world as independently compressed regions.
+   This allows regions to be decompressed in parallel, and only changed regions to be rewritten when saving.
+	U32 "Identifier"   (must be 0x52574343, 'CCWR')
+	U8  "Version"      (must be 1)
+	U8  "RegionShift"  (log2 of region size, must be 5)
+	U8  "Flags"        (1 = regions also contain upper 8 bits of blocks)
+	U8  "Reserved"
+	U16 "Width", "Height", "Length"
+	U16 "Reserved"
+	U32 "MetaOffset", "MetaSize", "MetaCRC32"
+	U32 "RegionsCount"
+	REGION { U32 "Offset", "Size", "CRC32" } (ordered by Y, then Z, then X)
+	U8* "Data"
+	
+	Metadata is an uncompressed ClassicWorld NBT compound tag, without any BlockArray tags.
+	Regions with a size of 0 are entirely air, otherwise each region is DEFLATE compressed:
+	U8* "Blocks"  (lower 8 bits, ordered by Y, then Z, then X, clipped to map bounds)
+	U8* "Blocks2" (upper 8 bits, only present when Flags has 1 set)
+	CRC32s are of the uncompressed data, and are used to skip unchanged data when saving.
+}*/
+#define CCW_IDENTIFIER   0x52574343UL
+#define CCW_HEADER_SIZE  32
+#define CCW_ENTRY_SIZE   12
+/* Same as WORLD_REGION_SHIFT, so modified regions of the world map directly to regions in the file */
+#define CCW_REGION_SHIFT 5
+#define CCW_REGION_SIZE  (1 << CCW_REGION_SHIFT)
+#define CCW_REGION_MASK  (CCW_REGION_SIZE - 1)
+#define CCW_REGION_VOLUME (CCW_REGION_SIZE * CCW_REGION_SIZE * CCW_REGION_SIZE)
+/* Fixed huffman DEFLATE uses at most 9 bits per byte, plus a few bytes at the end */
+#define CCW_MAX_COMP_SIZE (CCW_REGION_VOLUME * 2 * 9 / 8 + 64)
+#define CCW_FLAG_UPPER 0x01
+
+struct CcwRegion { cc_uint32 offset, size, crc32; };
+struct CcwState {
+	int width, height, length;
+	int xCount, yCount, zCount, count;
+	cc_bool upper;
+	cc_uint32 metaOffset, metaSize, metaCRC;
+	struct CcwRegion* regions;
+	cc_uint32 end; /* Offset of end of all used data in the file (only used when saving) */
+};
+static struct CcwState ccw;
+
+static void Ccw_CalcRegions(struct CcwState* s) {
+	s->xCount = (s->width  + CCW_REGION_MASK) >> CCW_REGION_SHIFT;
+	s->yCount = (s->height + CCW_REGION_MASK) >> CCW_REGION_SHIFT;
+	s->zCount = (s->length + CCW_REGION_MASK) >> CCW_REGION_SHIFT;
+	s->count  = s->xCount * s->yCount * s->zCount;
+}
+
+/* Calculates the bounds of the given region, clipped to the map */
+static void Ccw_GetBounds(const struct CcwState* s, int i, int* x1, int* y1, int* z1, int* width, int* height, int* length) {
+	*x1 = (i % s->xCount) << CCW_REGION_SHIFT;
+	*z1 = ((i / s->xCount) % s->zCount) << CCW_REGION_SHIFT;
+	*y1 = ((i / s->xCount) / s->zCount) << CCW_REGION_SHIFT;
+
+	*width  = min(CCW_REGION_SIZE, s->width  - *x1);
+	*height = min(CCW_REGION_SIZE, s->height - *y1);
+	*length = min(CCW_REGION_SIZE, s->length - *z1);
+}
+
+/* Calculates the number of bytes of uncompressed data in the given region */
+static int Ccw_RegionSize(const struct CcwState* s, int i) {
+	int x1, y1, z1, width, height, length, size;
+	Ccw_GetBounds(s, i, &x1, &y1, &z1, &width, &height, &length);
+	size = width * height * length;
+	return s->upper ? size * 2 : size;
+}
+
+/* Copies the blocks in the given region into a contiguous array, returning number of bytes copied */
+static int Ccw_GatherRegion(const struct CcwState* s, int i, cc_uint8* dst) {
+	int x1, y1, z1, width, height, length;
+	int y, z, index, size;
+	cc_bool upper = s->upper;
+	Ccw_GetBounds(s, i, &x1, &y1, &z1, &width, &height, &length);
+	size = width * height * length;
+
+	for (y = y1; y < y1 + height; y++) {
+		for (z = z1; z < z1 + length; z++) {
+			index = World_Pack(x1, y, z);
+			Mem_Copy(dst, &World.Blocks[index], width);
+#ifdef EXTENDED_BLOCKS
+			if (upper) Mem_Copy(dst + size, &World.Blocks2[index], width);
+#endif
+			dst += width;
+		}
+	}
+	return upper ? size * 2 : size;
+}
+
+/* Copies a contiguous array of blocks into the given region */
+static void Ccw_ScatterRegion(const struct CcwState* s, int i, const cc_uint8* src) {
+	int x1, y1, z1, width, height, length;
+	int y, z, index, size;
+	cc_bool upper = s->upper;
+	Ccw_GetBounds(s, i, &x1, &y1, &z1, &width, &height, &length);
+	size = width * height * length;
+
+	for (y = y1; y < y1 + height; y++) {
+		for (z = z1; z < z1 + length; z++) {
+			index = World_Pack(x1, y, z);
+			Mem_Copy(&World.Blocks[index], src, width);
+#ifdef EXTENDED_BLOCKS
+			if (upper) Mem_Copy(&World.Blocks2[index], src + size, width);
+#endif
+			src += width;
+		}
+	}
+}
+
+static cc_result Ccw_ReadHeader(struct CcwState* s, struct Stream* stream) {
+	cc_uint8 header[CCW_HEADER_SIZE];
+	cc_result res;
+	if ((res = Stream_Read(stream, header, sizeof(header)))) return res;
+
+	if (Stream_GetU32_LE(&header[0]) != CCW_IDENTIFIER) return CCW_ERR_IDENTIFIER;
+	if (header[4] != 1 || header[5] != CCW_REGION_SHIFT) return CCW_ERR_VERSION;
+	s->upper = (header[6] & CCW_FLAG_UPPER) != 0;
+
+	s->width  = Stream_GetU16_LE(&header[8]);
+	s->height = Stream_GetU16_LE(&header[10]);
+	s->length = Stream_GetU16_LE(&header[12]);
+
+	s->metaOffset = Stream_GetU32_LE(&header[16]);
+	s->metaSize   = Stream_GetU32_LE(&header[20]);
+	s->metaCRC    = Stream_GetU32_LE(&header[24]);
+
+	Ccw_CalcRegions(s);
+	if (Stream_GetU32_LE(&header[28]) != s->count) return CCW_ERR_REGIONS;
+	return 0;
+}
+
+/* Reads the regions table that immediately follows the header */
+static cc_result Ccw_ReadRegions(struct CcwState* s, struct Stream* stream) {
+	cc_uint8* data;
+	cc_uint32 size;
+	cc_result res;
+	int i;
+
+	size = s->count * CCW_ENTRY_SIZE;
+	data = (cc_uint8*)Mem_TryAlloc(size, 1);
+	if (!data) return ERR_OUT_OF_MEMORY;
+
+	s->regions = (struct CcwRegion*)Mem_TryAlloc(s->count, sizeof(struct CcwRegion));
+	if (!s->regions) { Mem_Free(data); return ERR_OUT_OF_MEMORY; }
+
+	res = Stream_Read(stream, data, size);
+	for (i = 0; !res && i < s->count; i++) {
+		s->regions[i].offset = Stream_GetU32_LE(&data[i * CCW_ENTRY_SIZE + 0]);
+		s->regions[i].size   = Stream_GetU32_LE(&data[i * CCW_ENTRY_SIZE + 4]);
+		s->regions[i].crc32  = Stream_GetU32_LE(&data[i * CCW_ENTRY_SIZE + 8]);
+	}
+
+	Mem_Free(data);
+	return res;
+}
+
+static cc_result Ccw_ReadMetadata(struct Stream* stream) {
+	struct Stream src;
+	cc_uint8* data;
+	cc_uint8 tag;
+	cc_result res;
+	if (!ccw.metaSize) return 0;
+
+	data = (cc_uint8*)Mem_TryAlloc(ccw.metaSize, 1);
+	if (!data) return ERR_OUT_OF_MEMORY;
+
+	if (!(res = stream->Seek(stream, ccw.metaOffset)) && !(res = Stream_Read(stream, data, ccw.metaSize))) {
+		Stream_ReadonlyMemory(&src, data, ccw.metaSize);
+
+		if ((res = src.ReadU8(&src, &tag))) {
+		} else if (tag != NBT_DICT) {
+			res = CW_ERR_ROOT_TAG;
+		} else {
+			res = Nbt_ReadTag(NBT_DICT, true, &src, NULL, Cw_Callback);
+		}
+	}
+
+	Mem_Free(data);
+	return res;
+}
+
+static struct CcwDecoder {
+	void* mutex;
+	cc_result result;
+	/* Compressed data of all regions, starting at the given file offset */
+	cc_uint8* data;
+	cc_uint32 dataBeg, dataEnd;
+} ccw_dec;
+
+static cc_result Ccw_DecodeRegion(int i, struct InflateState* inflate, cc_uint8* buffer) {
+	struct CcwRegion* r = &ccw.regions[i];
+	struct Stream src, comp;
+	int size;
+	cc_result res;
+	/* All air regions are skipped, since blocks arrays are allocated cleared */
+	if (!r->size) return 0;
+
+	/* Written so that a huge size can't overflow past the end of the data */
+	if (r->offset < ccw_dec.dataBeg || r->offset > ccw_dec.dataEnd) return CCW_ERR_REGIONS;
+	if (r->size > ccw_dec.dataEnd - r->offset)                       return CCW_ERR_REGIONS;
+	Stream_ReadonlyMemory(&src, ccw_dec.data + (r->offset - ccw_dec.dataBeg), r->size);
+	Inflate_MakeStream2(&comp, inflate, &src);
+	size = Ccw_RegionSize(&ccw, i);
+
+	if ((res = Stream_Read(&comp, buffer, size))) return res;
+	if (Utils_CRC32(buffer, size) != r->crc32) return CCW_ERR_REGIONS;
+
+	Ccw_ScatterRegion(&ccw, i, buffer);
+	return 0;
+}
+
+/* Regions are decoded by the job workers in batches, to reduce the overhead of claiming work */
+#define CCW_DECODE_BATCH 8
+static void Ccw_DecodeBatch(void* obj, int beg, int end) {
+	struct InflateState* inflate;
+	cc_uint8* buffer;
+	cc_result res;
+	int i;
+
+	/* Remaining batches are skipped once any region has failed to decode */
+	Mutex_Lock(ccw_dec.mutex);
+	res = ccw_dec.result;
+	Mutex_Unlock(ccw_dec.mutex);
+	if (res) return;
+
+	inflate = (struct InflateState*)Mem_TryAlloc(1, sizeof(struct InflateState));
+	buffer  = (cc_uint8*)Mem_TryAlloc(CCW_REGION_VOLUME, 2);
+
+	if (!inflate || !buffer) {
+		res = ERR_OUT_OF_MEMORY;
+	} else {
+		for (i = beg; i < end && !res; i++) {
+			res = Ccw_DecodeRegion(i, inflate, buffer);
+		}
+	}
+
+	if (res) {
+		Mutex_Lock(ccw_dec.mutex);
+		if (!ccw_dec.result) ccw_dec.result = res;
+		Mutex_Unlock(ccw_dec.mutex);
+	}
+	Mem_Free(inflate);
+	Mem_Free(buffer);
+}
+
+static cc_result Ccw_DecodeRegions(struct Stream* stream) {
+	cc_uint32 length, size;
+	cc_result res;
+
+	/* Read all region data in one go, rather than seeking around the file for each region */
+	ccw_dec.dataBeg = CCW_HEADER_SIZE + ccw.count * CCW_ENTRY_SIZE;
+	if ((res = stream->Length(stream, &length))) return res;
+	if (length < ccw_dec.dataBeg) return ERR_END_OF_STREAM;
+
+	ccw_dec.dataEnd = length;
+	size = length - ccw_dec.dataBeg;
+	ccw_dec.data    = (cc_uint8*)Mem_TryAlloc(max(size, 1), 1);
+	if (!ccw_dec.data) return ERR_OUT_OF_MEMORY;
+
+	if ((res = stream->Seek(stream, ccw_dec.dataBeg)) || (res = Stream_Read(stream, ccw_dec.data, size))) {
+		Mem_Free(ccw_dec.data); return res;
+	}
+
+	ccw_dec.mutex  = Mutex_Create();
+	ccw_dec.result = 0;
+
+	/* Main thread decodes regions too */
+	Jobs_ParallelFor(ccw.count, CCW_DECODE_BATCH, Ccw_DecodeBatch, NULL);
+
+	Mutex_Free(ccw_dec.mutex);
+	Mem_Free(ccw_dec.data);
+	return ccw_dec.result;
+}
+
+static cc_result Ccw_LoadBlocks(struct Stream* stream) {
+	cc_result res;
+	if ((res = Ccw_ReadRegions(&ccw, stream))) return res;
+	if ((res = Ccw_ReadMetadata(stream)))      return res;
+
+	World.Blocks = (BlockRaw*)Mem_TryAllocCleared(World.Volume, 1);
+	Mem_SetPlace(World.Blocks, "map blocks");
+	if (!World.Blocks) return ERR_OUT_OF_MEMORY;
+
+	if (ccw.upper) {
+#ifdef EXTENDED_BLOCKS
+		BlockRaw* blocks2 = (BlockRaw*)Mem_TryAllocCleared(World.Volume, 1);
+		Mem_SetPlace(blocks2, "map blocks");
+		if (!blocks2) return ERR_OUT_OF_MEMORY;
+		World_SetMapUpper(blocks2);
+#else
+		return ERR_NOT_SUPPORTED;
+#endif
+	}
+	return Ccw_DecodeRegions(stream);
+}
+
+cc_result Ccw_Load(struct Stream* stream) {
+	cc_result res;
+	if ((res = Ccw_ReadHeader(&ccw, stream))) return res;
+
+	World.Width  = ccw.width;
+	World.Height = ccw.height;
+	World.Length = ccw.length;
+	World.Volume = World.Width * World.Height * World.Length;
+	if (!World.Volume) return CCW_ERR_REGIONS;
+
+	ccw.regions = NULL;
+	res = Ccw_LoadBlocks(stream);
+	Mem_Free(ccw.regions);
+	return res;
+}
+
+
 /*########################################################################################################################*
 *--------------------------------------------------ClassicWorld export----------------------------------------------------*
 *#########################################################################################################################*/
@@ -1361,12 +1683,10 @@ static cc_result Cw_WriteBockDef(struct Stream* stream, int b) {
 	return Stream_Write(stream, tmp, sizeof(cw_meta_def) + len);
 }
 
-cc_result Cw_Save(struct Stream* stream) {
-	cc_uint8 tmp[768];
-	PackedCol col;
+/* Writes the first 'len' bytes of the beginning of the ClassicWorld compound tag */
+static cc_result Cw_WriteBegin(struct Stream* stream, int len) {
+	cc_uint8 tmp[sizeof(cw_begin)];
 	struct LocalPlayer* p = &LocalPlayer_Instance;
-	cc_result res;
-	int b, len;
 
 	Mem_Copy(tmp, cw_begin, sizeof(cw_begin));
 	{
@@ -1383,18 +1703,15 @@ cc_result Cw_Save(struct Stream* stream) {
 		tmp[107] = Math_Deg2Packed(p->SpawnYaw);
 		tmp[112] = Math_Deg2Packed(p->SpawnPitch);
 	}
-	if ((res = Stream_Write(stream, tmp,      sizeof(cw_begin)))) return res;
-	if ((res = Stream_Write(stream, World.Blocks, World.Volume))) return res;
-
-#ifdef EXTENDED_BLOCKS
-	if (World.Blocks != World.Blocks2) {
-		Mem_Copy(tmp, cw_map2, sizeof(cw_map2));
-		Stream_SetU32_BE(&tmp[14], World.Volume);
+	return Stream_Write(stream, tmp, len);
+}
 
-		if ((res = Stream_Write(stream, tmp,        sizeof(cw_map2)))) return res;
-		if ((res = Stream_Write(stream, World.Blocks2, World.Volume))) return res;
-	}
-#endif
+/* Writes the metadata compound tag, then ends the ClassicWorld compound tag */
+static cc_result Cw_WriteMetadata(struct Stream* stream) {
+	cc_uint8 tmp[768];
+	PackedCol col;
+	cc_result res;
+	int b, len;
 
 	Mem_Copy(tmp, cw_meta_cpe, sizeof(cw_meta_cpe));
 	{
@@ -1424,6 +1741,399 @@ cc_result Cw_Save(struct Stream* stream) {
 	return Stream_Write(stream, cw_end, sizeof(cw_end));
 }
 
+cc_result Cw_Save(struct Stream* stream) {
+	cc_uint8 tmp[sizeof(cw_map2)];
+	cc_result res;
+
+	if ((res = Cw_WriteBegin(stream, sizeof(cw_begin))))      return res;
+	if ((res = Stream_Write(stream, World.Blocks, World.Volume))) return res;
+
+#ifdef EXTENDED_BLOCKS
+	if (World.Blocks != World.Blocks2) {
+		Mem_Copy(tmp, cw_map2, sizeof(cw_map2));
+		Stream_SetU32_BE(&tmp[14], World.Volume);
+
+		if ((res = Stream_Write(stream, tmp,        sizeof(cw_map2)))) return res;
+		if ((res = Stream_Write(stream, World.Blocks2, World.Volume))) return res;
+	}
+#endif
+	return Cw_WriteMetadata(stream);
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------ClassiCube region export--------------------------------------------------*
+*#########################################################################################################################*/
+/* Length of cw_begin, excluding the "BlockArray" tag at the end */
+#define CW_BEGIN_NO_BLOCKS 114
+#define CCW_META_MAX_SIZE (CW_BEGIN_NO_BLOCKS + sizeof(cw_meta_cpe) + sizeof(cw_meta_defs) + sizeof(cw_end) + \
+	(3 * STRING_SIZE + 1) + BLOCK_COUNT * (sizeof(cw_meta_def) + 3 * STRING_SIZE + 1))
+
+struct CcwEncoder {
+	struct CcwState* state;
+	struct Stream* stream;
+	struct DeflateState* deflate;
+	cc_uint8* comp; /* Compressed data of current region */
+};
+
+static cc_result Ccw_InitEncoder(struct CcwEncoder* e, struct CcwState* s, struct Stream* stream) {
+	e->state   = s;
+	e->stream  = stream;
+	e->deflate = (struct DeflateState*)Mem_TryAlloc(1, sizeof(struct DeflateState));
+	e->comp    = (cc_uint8*)Mem_TryAlloc(CCW_MAX_COMP_SIZE, 1);
+	return e->deflate && e->comp ? 0 : ERR_OUT_OF_MEMORY;
+}
+
+static void Ccw_FreeEncoder(struct CcwEncoder* e) {
+	Mem_Free(e->deflate);
+	Mem_Free(e->comp);
+}
+
+/* Regions and metadata are always appended to the end of the file, rather than overwriting */
+/*  existing data. So if saving is interrupted, the previous regions table is still valid */
+static cc_result Ccw_Append(struct CcwEncoder* e, cc_uint32* offset, const cc_uint8* data, cc_uint32 size) {
+	struct Stream* stream = e->stream;
+	cc_result res;
+	*offset = e->state->end;
+	e->state->end += size;
+
+	if ((res = stream->Seek(stream, *offset))) return res;
+	return Stream_Write(stream, data, size);
+}
+
+static cc_bool Ccw_AllAir(const cc_uint8* data, int size) {
+	int i;
+	for (i = 0; i < size; i++) {
+		if (data[i]) return false;
+	}
+	return true;
+}
+
+/* Compresses then writes the given uncompressed data of a region */
+static cc_result Ccw_EncodeRegion(struct CcwEncoder* e, int i, const cc_uint8* data, cc_uint32 size, cc_uint32 crc) {
+	struct CcwRegion* r = &e->state->regions[i];
+	struct Stream mem, comp;
+	cc_result res;
+
+	r->crc32  = crc;
+	r->size   = 0;
+	r->offset = 0;
+	if (Ccw_AllAir(data, size)) return 0;
+
+	Stream_WriteonlyMemory(&mem, e->comp, CCW_MAX_COMP_SIZE);
+	Deflate_MakeStream(&comp, e->deflate, &mem);
+	if ((res = Stream_Write(&comp, data, size))) return res;
+	if ((res = comp.Close(&comp)))               return res;
+
+	mem.Position(&mem, &size);
+	r->size = size;
+	return Ccw_Append(e, &r->offset, e->comp, size);
+}
+
+/* Writes the given metadata, if it differs from the metadata already in the file */
+static cc_result Ccw_EncodeMetadata(struct CcwEncoder* e, const cc_uint8* data, cc_uint32 size, cc_bool force) {
+	struct CcwState* s = e->state;
+	cc_uint32 crc = Utils_CRC32(data, size);
+	if (!force && crc == s->metaCRC && size == s->metaSize) return 0;
+
+	s->metaCRC  = crc;
+	s->metaSize = size;
+	return Ccw_Append(e, &s->metaOffset, data, size);
+}
+
+static cc_result Ccw_WriteHeader(struct CcwEncoder* e) {
+	cc_uint8 header[CCW_HEADER_SIZE] = { 0 };
+	struct CcwState* s    = e->state;
+	struct Stream* stream = e->stream;
+	cc_uint8* data;
+	cc_uint32 size;
+	cc_result res;
+	int i;
+
+	Stream_SetU32_LE(&header[0], CCW_IDENTIFIER);
+	header[4] = 1;
+	header[5] = CCW_REGION_SHIFT;
+	header[6] = s->upper ? CCW_FLAG_UPPER : 0;
+
+	Stream_SetU16_LE(&header[8],  s->width);
+	Stream_SetU16_LE(&header[10], s->height);
+	Stream_SetU16_LE(&header[12], s->length);
+
+	Stream_SetU32_LE(&header[16], s->metaOffset);
+	Stream_SetU32_LE(&header[20], s->metaSize);
+	Stream_SetU32_LE(&header[24], s->metaCRC);
+	Stream_SetU32_LE(&header[28], s->count);
+
+	size = s->count * CCW_ENTRY_SIZE;
+	data = (cc_uint8*)Mem_TryAlloc(size, 1);
+	if (!data) return ERR_OUT_OF_MEMORY;
+
+	for (i = 0; i < s->count; i++) {
+		Stream_SetU32_LE(&data[i * CCW_ENTRY_SIZE + 0], s->regions[i].offset);
+		Stream_SetU32_LE(&data[i * CCW_ENTRY_SIZE + 4], s->regions[i].size);
+		Stream_SetU32_LE(&data[i * CCW_ENTRY_SIZE + 8], s->regions[i].crc32);
+	}
+
+	if (!(res = stream->Seek(stream, 0)) && !(res = Stream_Write(stream, header, sizeof(header)))) {
+		res = Stream_Write(stream, data, size);
+	}
+	Mem_Free(data);
+	return res;
+}
+
+/* Serialises the metadata of the current world into the given buffer */
+static cc_result Ccw_MakeMetadata(cc_uint8* data, cc_uint32* size) {
+	struct Stream mem;
+	cc_result res;
+
+	Stream_WriteonlyMemory(&mem, data, CCW_META_MAX_SIZE);
+	if ((res = Cw_WriteBegin(&mem, CW_BEGIN_NO_BLOCKS))) return res;
+	if ((res = Cw_WriteMetadata(&mem)))                  return res;
+	return mem.Position(&mem, size);
+}
+
+/* Initialises state for the current world, with no regions or metadata in the file yet */
+static cc_result Ccw_InitState(struct CcwState* s) {
+	s->width  = World.Width;
+	s->height = World.Height;
+	s->length = World.Length;
+	Ccw_CalcRegions(s);
+#ifdef EXTENDED_BLOCKS
+	s->upper = World.Blocks != World.Blocks2;
+#else
+	s->upper = false;
+#endif
+
+	s->metaOffset = 0;
+	s->metaSize   = 0;
+	s->metaCRC    = 0;
+	s->end        = CCW_HEADER_SIZE + s->count * CCW_ENTRY_SIZE;
+
+	s->regions = (struct CcwRegion*)Mem_TryAllocCleared(s->count, sizeof(struct CcwRegion));
+	return s->regions ? 0 : ERR_OUT_OF_MEMORY;
+}
+
+/* Whether the regions in the file are compatible with the current world */
+static cc_bool Ccw_MatchesWorld(const struct CcwState* s) {
+	if (s->width != World.Width || s->height != World.Height || s->length != World.Length) return false;
+#ifdef EXTENDED_BLOCKS
+	return s->upper == (World.Blocks != World.Blocks2);
+#else
+	return !s->upper;
+#endif
+}
+
+/* Whether more space in the file is wasted by superseded data than is used by current data */
+static cc_bool Ccw_NeedsCompaction(const struct CcwState* s) {
+	cc_uint32 used = CCW_HEADER_SIZE + s->count * CCW_ENTRY_SIZE;
+	int i;
+
+	for (i = 0; i < s->count; i++) {
+		used += s->regions[i].size;
+	}
+	used += s->metaSize;
+	return s->end - used > used;
+}
+
+/* Writes all regions, then the metadata and header */
+static cc_result Ccw_WriteAll(struct CcwState* s, struct Stream* stream) {
+	struct CcwEncoder e;
+	cc_uint8* data;
+	cc_uint32 size, crc;
+	cc_result res;
+	int i;
+
+	res  = Ccw_InitEncoder(&e, s, stream);
+	data = (cc_uint8*)Mem_TryAlloc(max(CCW_REGION_VOLUME * 2, CCW_META_MAX_SIZE), 1);
+	if (!data) res = ERR_OUT_OF_MEMORY;
+
+	for (i = 0; !res && i < s->count; i++) {
+		size = Ccw_GatherRegion(s, i, data);
+		crc  = Utils_CRC32(data, size);
+		res  = Ccw_EncodeRegion(&e, i, data, size, crc);
+	}
+
+	if (!res) res = Ccw_MakeMetadata(data, &size);
+	if (!res) res = Ccw_EncodeMetadata(&e, data, size, true);
+	if (!res) res = Ccw_WriteHeader(&e);
+
+	Ccw_FreeEncoder(&e);
+	Mem_Free(data);
+	return res;
+}
+
+cc_result Ccw_Save(struct Stream* stream) {
+	struct CcwState s;
+	cc_result res;
+	if ((res = Ccw_InitState(&s))) return res;
+
+	res = Ccw_WriteAll(&s, stream);
+	Mem_Free(s.regions);
+	return res;
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------ClassiCube region snapshots------------------------------------------------*
+*#########################################################################################################################*/
+static struct CcwSnapshot {
+	struct CcwState state; /* State of the snapshot file, as of the last written snapshot */
+	cc_bool valid;         /* Whether state matches what is actually in the snapshot file */
+	cc_bool rewrite;       /* Whether this snapshot entirely rewrites the snapshot file */
+	int count;             /* Number of regions in this snapshot */
+	int* indices;          /* Indices of the regions in this snapshot */
+	cc_uint8* data;        /* Uncompressed data of all the regions in this snapshot */
+	cc_uint8* meta;        /* Uncompressed metadata */
+	cc_uint32 metaSize;
+	cc_string path; char pathBuffer[FILENAME_SIZE]; /* Path of the snapshot file */
+} ccw_snap;
+
+/* Reads the header and regions table of an existing .ccw file */
+static cc_result Ccw_ReadState(struct CcwState* s, const cc_string* path) {
+	struct Stream stream;
+	cc_uint32 length;
+	cc_result res;
+	int i;
+
+	s->regions = NULL;
+	if ((res = Stream_OpenFile(&stream, path))) return res;
+
+	if (!(res = stream.Length(&stream, &length)) && !(res = Ccw_ReadHeader(s, &stream))) {
+		res = Ccw_ReadRegions(s, &stream);
+	}
+	/* No point logging error for closing readonly file */
+	stream.Close(&stream);
+	if (res) return res;
+
+	/* Existing regions are kept as is, so they must actually be within the file */
+	for (i = 0; i < s->count; i++) {
+		if (s->regions[i].offset > length || s->regions[i].size > length - s->regions[i].offset) return CCW_ERR_REGIONS;
+	}
+	if (s->metaOffset > length || s->metaSize > length - s->metaOffset) return CCW_ERR_REGIONS;
+
+	s->end = length;
+	return 0;
+}
+
+static void Ccw_FreeSnapshot(void) {
+	Mem_Free(ccw_snap.indices);
+	Mem_Free(ccw_snap.data);
+	Mem_Free(ccw_snap.meta);
+
+	ccw_snap.indices = NULL;
+	ccw_snap.data    = NULL;
+	ccw_snap.meta    = NULL;
+	ccw_snap.count   = 0;
+}
+
+/* Takes a snapshot of the metadata and the regions of the world which differ from the given .ccw file */
+/* NOTE: Modified regions are only tracked relative to the file the last snapshot was written to. */
+/*  For any other existing file, all regions are included, but only changed regions get written */
+static cc_result Ccw_TakeSnapshot(const cc_string* path, cc_bool* changed) {
+	struct CcwState* s = &ccw_snap.state;
+	cc_uint32 total = 0;
+	cc_bool tracked;
+	cc_uint8* dst;
+	cc_result res;
+	int i, count = 0;
+
+	Ccw_FreeSnapshot();
+	*changed = false;
+
+	tracked = ccw_snap.valid && String_Equals(&ccw_snap.path, path);
+	if (!tracked) {
+		Mem_Free(s->regions);
+		String_InitArray(ccw_snap.path, ccw_snap.pathBuffer);
+		String_Copy(&ccw_snap.path, path);
+		ccw_snap.valid = !Ccw_ReadState(s, path);
+	}
+
+	ccw_snap.rewrite = !ccw_snap.valid || !Ccw_MatchesWorld(s) || Ccw_NeedsCompaction(s);
+	if (ccw_snap.rewrite) {
+		ccw_snap.valid = false;
+		Mem_Free(s->regions);
+		if ((res = Ccw_InitState(s))) return res;
+	}
+
+	ccw_snap.indices = (int*)Mem_TryAlloc(max(s->count, 1), sizeof(int));
+	ccw_snap.meta    = (cc_uint8*)Mem_TryAlloc(CCW_META_MAX_SIZE, 1);
+	if (!ccw_snap.indices || !ccw_snap.meta) return ERR_OUT_OF_MEMORY;
+
+	for (i = 0; i < s->count; i++) {
+		if (!ccw_snap.rewrite && tracked && !World_IsRegionDirty(i)) continue;
+
+		ccw_snap.indices[count++] = i;
+		total += Ccw_RegionSize(s, i);
+	}
+
+	if ((res = Ccw_MakeMetadata(ccw_snap.meta, &ccw_snap.metaSize))) return res;
+	if (!count && ccw_snap.metaSize == s->metaSize && Utils_CRC32(ccw_snap.meta, ccw_snap.metaSize) == s->metaCRC) return 0;
+
+	ccw_snap.data = (cc_uint8*)Mem_TryAlloc(max(total, 1), 1);
+	if (!ccw_snap.data) return ERR_OUT_OF_MEMORY;
+
+	dst = ccw_snap.data;
+	for (i = 0; i < count; i++) {
+		dst += Ccw_GatherRegion(s, ccw_snap.indices[i], dst);
+	}
+
+	ccw_snap.count = count;
+	World_ClearDirtyRegions();
+	*changed = true;
+	return 0;
+}
+
+/* Writes the last snapshot to its .ccw file, then updates state of the snapshot file */
+/* NOTE: Only reads from the snapshot (not the world), so can be called from a background thread. */
+static cc_result Ccw_WriteSnapshot(volatile float* progress) {
+	const cc_string* path = &ccw_snap.path;
+	cc_string tmpPath; char tmpBuffer[FILENAME_SIZE];
+	struct CcwState* s = &ccw_snap.state;
+	struct CcwEncoder e;
+	struct Stream stream;
+	cc_uint8* data = ccw_snap.data;
+	cc_uint32 size, crc;
+	cc_result res, closeRes;
+	cc_file file;
+	int i, region;
+
+	/* Rewritten file is written separately then renamed over the existing file, */
+	/*  so that the existing file isn't lost if the game crashes while saving */
+	String_InitArray(tmpPath, tmpBuffer);
+	String_Format1(&tmpPath, "%s.tmp", path);
+
+	/* Just in case saving is interrupted partway through */
+	ccw_snap.valid = false;
+	res = ccw_snap.rewrite ? File_Create(&file, &tmpPath) : File_OpenOrCreate(&file, path);
+	if (res) return res;
+	Stream_FromFile(&stream, file);
+
+	res = Ccw_InitEncoder(&e, s, &stream);
+	for (i = 0; !res && i < ccw_snap.count; i++) {
+		region = ccw_snap.indices[i];
+		size   = Ccw_RegionSize(s, region);
+		crc    = Utils_CRC32(data, size);
+
+		/* Blocks in the region may have been changed, then changed back again */
+		if (ccw_snap.rewrite || crc != s->regions[region].crc32) {
+			res = Ccw_EncodeRegion(&e, region, data, size, crc);
+		}
+		data += size;
+		*progress = (float)(i + 1) / ccw_snap.count;
+	}
+
+	if (!res) res = Ccw_EncodeMetadata(&e, ccw_snap.meta, ccw_snap.metaSize, ccw_snap.rewrite);
+	if (!res) res = Ccw_WriteHeader(&e);
+	Ccw_FreeEncoder(&e);
+
+	closeRes = stream.Close(&stream);
+	if (!res) res = closeRes;
+	if (!res && ccw_snap.rewrite) res = File_Rename(&tmpPath, path);
+
+	ccw_snap.valid = !res;
+	return res;
+}
+
 
 /*########################################################################################################################*
 *---------------------------------------------------Schematic export------------------------------------------------------*
@@ -1473,3 +2183,164 @@ cc_result Schematic_Save(struct Stream* stream) {
 	}
 	return Stream_Write(stream, sc_end, sizeof(sc_end));
 }
+
+
+/*########################################################################################################################*
+*--------------------------------------------------Background map saving--------------------------------------------------*
+*#########################################################################################################################*/
+/* Exported data may contain more than just the world's blocks (e.g. metadata, upper 8 bits of blocks) */
+#define MAP_SAVE_EXTRA_SIZE (CCW_META_MAX_SIZE + 1024)
+/* Data is compressed in chunks, so progress can be reported */
+#define MAP_SAVE_CHUNK_SIZE (64 * 1024)
+
+static struct MapSaver {
+	cc_bool active;
+	cc_bool ccw;    /* Whether writing a region snapshot instead of exported data */
+	cc_bool quiet;  /* Whether only errors are shown (e.g. autosaving) */
+	volatile cc_bool done;
+	volatile float progress;
+	int lastProgress;
+	cc_result result;
+	void* thread;
+	cc_uint8* data; /* Uncompressed exported data */
+	cc_uint32 size;
+	double time;    /* Point in time the snapshot was taken at */
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+} map_saver;
+
+static void Map_SaveWorker(void) {
+	struct Stream stream, compStream;
+	struct GZipState* state;
+	cc_uint32 i, count, size = map_saver.size;
+	cc_result res, closeRes;
+
+	if (map_saver.ccw) {
+		map_saver.result = Ccw_WriteSnapshot(&map_saver.progress);
+		map_saver.done   = true;
+		return;
+	}
+
+	state = (struct GZipState*)Mem_TryAlloc(1, sizeof(struct GZipState));
+	res   = state ? Stream_CreateFile(&stream, &map_saver.path) : ERR_OUT_OF_MEMORY;
+
+	if (!res) {
+		GZip_MakeStream(&compStream, state, &stream);
+		for (i = 0; !res && i < size; i += count) {
+			count = min(MAP_SAVE_CHUNK_SIZE, size - i);
+			res   = Stream_Write(&compStream, map_saver.data + i, count);
+			map_saver.progress = (float)(i + count) / size;
+		}
+		if (!res) res = compStream.Close(&compStream);
+
+		closeRes = stream.Close(&stream);
+		if (!res) res = closeRes;
+	}
+
+	Mem_Free(state);
+	map_saver.result = res;
+	map_saver.done   = true;
+}
+
+static void Map_EndSave(void) {
+	if (!map_saver.active) return;
+	Thread_Join(map_saver.thread);
+	map_saver.active = false;
+
+	Mem_Free(map_saver.data);
+	map_saver.data = NULL;
+	if (map_saver.ccw) Ccw_FreeSnapshot();
+	if (!map_saver.quiet) Chat_AddOf(&String_Empty, MSG_TYPE_EXTRASTATUS_3);
+
+	if (map_saver.result) {
+		Logger_SysWarn2(map_saver.result, "saving", &map_saver.path);
+	} else if (!map_saver.quiet) {
+		Chat_Add1("&eSaved map to: %s", &map_saver.path);
+		World.LastSave = map_saver.time;
+	}
+}
+
+static void Map_StartSave(const cc_string* path, cc_bool ccw, cc_bool quiet) {
+	String_InitArray(map_saver.path, map_saver.pathBuffer);
+	String_Copy(&map_saver.path, path);
+	map_saver.ccw          = ccw;
+	map_saver.quiet        = quiet;
+	map_saver.time         = Game.Time;
+	map_saver.progress     = 0.0f;
+	map_saver.lastProgress = -1;
+	map_saver.done         = false;
+	map_saver.active       = true;
+	map_saver.thread       = Thread_Start(Map_SaveWorker);
+}
+
+/* Only the regions which differ from the existing file need to be written to it, */
+/*  so resaving a .ccw map is usually much faster than exporting the whole world */
+static cc_result Map_SaveCcw(const cc_string* path, cc_bool quiet) {
+	cc_bool changed;
+	cc_result res;
+
+	if ((res = Ccw_TakeSnapshot(path, &changed))) { Ccw_FreeSnapshot(); return res; }
+	if (changed) { Map_StartSave(path, true, quiet); return 0; }
+
+	if (!quiet) {
+		Chat_Add1("&eSaved map to: %s", path);
+		World.LastSave = Game.Time;
+	}
+	return 0;
+}
+
+cc_result Map_SaveInBackground(const cc_string* path, IMapExporter exporter) {
+	struct Stream mem;
+	cc_uint32 capacity;
+	cc_result res;
+	/* Only one map is saved at a time */
+	Map_EndSave();
+	if (exporter == Ccw_Save) return Map_SaveCcw(path, false);
+
+	capacity = (cc_uint32)World.Volume * 2 + MAP_SAVE_EXTRA_SIZE;
+	map_saver.data = (cc_uint8*)Mem_TryAlloc(capacity, 1);
+	if (!map_saver.data) return ERR_OUT_OF_MEMORY;
+
+	/* Exporting uncompressed data mostly just copies the blocks arrays, */
+	/*  so is fast enough to do on the main thread as the snapshot */
+	Stream_WriteonlyMemory(&mem, map_saver.data, capacity);
+	if (!(res = exporter(&mem))) res = mem.Position(&mem, &map_saver.size);
+	if (res) {
+		Mem_Free(map_saver.data);
+		map_saver.data = NULL;
+		return res;
+	}
+
+	Map_StartSave(path, false, false);
+	return 0;
+}
+
+cc_result Map_AutosaveInBackground(const cc_string* path) {
+	/* Don't interrupt a map being saved by the user */
+	if (map_saver.active) return 0;
+	return Map_SaveCcw(path, true);
+}
+
+static void Map_SaveTick(struct ScheduledTask* task) {
+	cc_string msg; char msgBuffer[STRING_SIZE];
+	int progress;
+	if (!map_saver.active) return;
+	if (map_saver.done) { Map_EndSave(); return; }
+	if (map_saver.quiet) return;
+
+	progress = (int)(map_saver.progress * 100);
+	if (progress == map_saver.lastProgress) return;
+	map_saver.lastProgress = progress;
+
+	String_InitArray(msg, msgBuffer);
+	String_Format1(&msg, "&eSaving map (&7%i&e%%)", &progress);
+	Chat_AddOf(&msg, MSG_TYPE_EXTRASTATUS_3);
+}
+
+static void OnInit(void) {
+	ScheduledTask_AddEx("Map_SaveTick", GAME_DEF_TICKS, Map_SaveTick, TASK_PRIORITY_LOW, 1, 0);
+}
+
+struct IGameComponent Formats_Component = {
+	OnInit,     /* Init */
+	Map_EndSave /* Free */
+};
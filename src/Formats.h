@@ -6,8 +6,13 @@
 */
 
 struct Stream;
+struct IGameComponent;
+extern struct IGameComponent Formats_Component;
+
 /* Imports a world encoded in a particular map file format. */
 typedef cc_result (*IMapImporter)(struct Stream* stream);
+/* Exports a world encoded in a particular map file format. */
+typedef cc_result (*IMapExporter)(struct Stream* stream);
 /* Attempts to find a suitable importer based on filename. */
 /* Returns NULL if no match found. */
 CC_API IMapImporter Map_FindImporter(const cc_string* path);
@@ -27,11 +32,28 @@ cc_result Cw_Load(struct Stream* stream);
 /* Imports a world from a .dat classic map file. */
 /* Used by Minecraft Classic/WoM client. */
 cc_result Dat_Load(struct Stream* stream);
+/* Imports a world from a .ccw ClassiCube region map file. */
+/* NOTE: stream must support seeking and retrieving its length. */
+cc_result Ccw_Load(struct Stream* stream);
 
 /* Exports a world to a .cw ClassicWorld map file. */
 /* Compatible with ClassiCube/ClassicalSharp. */
 cc_result Cw_Save(struct Stream* stream);
+/* Exports a world to a .ccw ClassiCube region map file. */
+/* NOTE: stream must support seeking. */
+cc_result Ccw_Save(struct Stream* stream);
+
 /* Exports a world to a .schematic Schematic map file. */
 /* Used by MCEdit and other tools. */
 cc_result Schematic_Save(struct Stream* stream);
+
+/* Takes a snapshot of the world by exporting it uncompressed into memory, */
+/*  then GZip compresses and writes the snapshot to the given file on a background thread. */
+/* NOTE: Progress is shown in a status line, and a chat message is shown once saved. */
+/* NOTE: When exporter is Ccw_Save, only the regions which differ from the existing file are written. */
+cc_result Map_SaveInBackground(const cc_string* path, IMapExporter exporter);
+/* Saves only the regions of the world which differ from the given .ccw file on a background thread. */
+/* NOTE: Unlike Map_SaveInBackground, nothing is shown unless an error occurs. */
+/* NOTE: Does nothing if a map is already being saved. */
+cc_result Map_AutosaveInBackground(const cc_string* path);
 #endif
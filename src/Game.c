@@ -22,6 +22,7 @@
 #include "Inventory.h"
 #include "Input.h"
 #include "Server.h"
+#include "Formats.h"
 #include "TexturePack.h"
 #include "Screens.h"
 #include "SelectionBox.h"
@@ -36,6 +37,8 @@
 #include "Protocol.h"
 #include "Picking.h"
 #include "Animations.h"
+#include "Profiler.h"
+#include "Jobs.h"
 
 struct _GameData Game;
 cc_uint64 Game_FrameStart;
@@ -71,15 +74,36 @@ void Game_AddComponent(struct IGameComponent* comp) {
 }
 
 #define TASKS_DEF_ELEMS 6
+/* Default maximum time worth of missed ticks that is caught up on in one frame */
+#define TASKS_DEF_CATCHUP_TIME 0.25
+/* Maximum time spent catching up on missed ticks in one frame, before postponing the rest */
+#define TASKS_CATCHUP_BUDGET_US 8000
 static struct ScheduledTask defaultTasks[TASKS_DEF_ELEMS];
 static int tasksCapacity = TASKS_DEF_ELEMS, tasksCount, entTaskI;
 static struct ScheduledTask* tasks = defaultTasks;
 
 int ScheduledTask_Add(double interval, ScheduledTaskCallback callback) {
+	return ScheduledTask_AddEx("Unnamed", interval, callback, TASK_PRIORITY_NORMAL, 0, 0);
+}
+
+int ScheduledTask_AddEx(const char* name, double interval, ScheduledTaskCallback callback,
+						int priority, int maxCatchup, int flags) {
 	struct ScheduledTask task;
+	if (maxCatchup <= 0) maxCatchup = (int)(TASKS_DEF_CATCHUP_TIME / interval);
+	Math_Clamp(priority, TASK_PRIORITY_LOW, TASK_PRIORITY_HIGH);
+
 	task.accumulator = 0.0;
 	task.interval    = interval;
 	task.Callback    = callback;
+	task.name        = name;
+	task.priority    = priority;
+	task.flags       = flags;
+	task.maxCatchup  = max(1, maxCatchup);
+
+	task.ticks          = 0;
+	task.droppedTicks   = 0;
+	task.deferredFrames = 0;
+	task.maxMs          = 0.0f;
 
 	if (tasksCount == tasksCapacity) {
 		Utils_Resize((void**)&tasks, &tasksCapacity,
@@ -90,6 +114,9 @@ int ScheduledTask_Add(double interval, ScheduledTaskCallback callback) {
 	return tasksCount - 1;
 }
 
+struct ScheduledTask* ScheduledTask_Get(int i) { return &tasks[i]; }
+int ScheduledTask_Count(void) { return tasksCount; }
+
 
 void Game_ToggleFullscreen(void) {
 	int state = Window_GetWindowState();
@@ -192,6 +219,7 @@ void Game_UpdateBlock(int x, int y, int z, BlockID block) {
 	}
 	Lighting_OnBlockChanged(x, y, z, old, block);
 	MapRenderer_OnBlockChanged(x, y, z, block);
+	Searcher_OnBlockChanged(x, y, z, old, block);
 }
 
 void Game_ChangeBlock(int x, int y, int z, BlockID block) {
@@ -310,6 +338,8 @@ static void LoadOptions(void) {
 	Game_UserViewDistance = Game_ViewDistance;
 	Game_BreakableLiquids = !Game_ClassicMode && Options_GetBool(OPT_MODIFIABLE_LIQUIDS, false);
 	Game_AllowServerTextures = Options_GetBool(OPT_SERVER_TEXTURES, true);
+	/* Start tracking before components are initialised, so their allocations are counted too */
+	Mem_SetTracking(Options_GetBool(OPT_MEM_TRACKING, false));
 	/* TODO: Do we need to support option to skip SSL */
 	/*cc_bool skipSsl = Options_GetBool("skip-ssl-check", false);
 	if (skipSsl) {
@@ -364,6 +394,7 @@ static void LoadPlugins(void) {
 #endif
 
 void Game_Free(void* obj);
+static void TickThread_Init(void);
 static void Game_Load(void) {
 	struct IGameComponent* comp;
 	Game_UpdateDimensions();
@@ -379,12 +410,15 @@ static void Game_Load(void) {
 	Event_Register_(&WindowEvents.Closing,         NULL, Game_Free);
 	Event_Register_(&WindowEvents.InactiveChanged, NULL, HandleInactiveChanged);
 
+	/* Started first, so other components can submit jobs while loading */
+	Game_AddComponent(&Jobs_Component);
 	Game_AddComponent(&World_Component);
 	Game_AddComponent(&Textures_Component);
 	Game_AddComponent(&Input_Component);
 	Game_AddComponent(&Camera_Component);
 	Game_AddComponent(&Gfx_Component);
 	Game_AddComponent(&Blocks_Component);
+	Game_AddComponent(&Searcher_Component);
 	Game_AddComponent(&Drawer2D_Component);
 
 	Game_AddComponent(&Chat_Component);
@@ -401,6 +435,7 @@ static void Game_Load(void) {
 	Game_AddComponent(&MapRenderer_Component);
 	Game_AddComponent(&EnvRenderer_Component);
 	Game_AddComponent(&Server_Component);
+	Game_AddComponent(&Formats_Component);
 	Game_AddComponent(&Protocol_Component);
 
 	Game_AddComponent(&Gui_Component);
@@ -410,6 +445,7 @@ static void Game_Load(void) {
 	Game_AddComponent(&PickedPosRenderer_Component);
 	Game_AddComponent(&Audio_Component);
 	Game_AddComponent(&AxisLinesRenderer_Component);
+	Game_AddComponent(&Profiler_Component);
 
 	LoadPlugins();
 	for (comp = comps_head; comp; comp = comp->next) {
@@ -423,7 +459,9 @@ static void Game_Load(void) {
 			"default.zip is missing, try downloading resources first.\n\nThe game will still run, but without any textures");
 	}
 
-	entTaskI = ScheduledTask_Add(GAME_DEF_TICKS, Entities_Tick);
+	entTaskI = ScheduledTask_AddEx("Entities_Tick", GAME_DEF_TICKS, Entities_Tick,
+									TASK_PRIORITY_HIGH, 0, TASK_FLAG_TICK_THREAD);
+	TickThread_Init();
 	if (Gfx_WarnIfNecessary()) EnvRenderer_SetMode(EnvRenderer_Minimal | ENV_LEGACY);
 	Server.BeginConnect();
 }
@@ -451,16 +489,16 @@ static void Game_Render3D(double delta, float t) {
 	if (EnvRenderer_ShouldRenderSkybox()) EnvRenderer_RenderSkybox();
 
 	AxisLinesRenderer_Render();
-	Entities_RenderModels(delta, t);
+	Profiler_Zone("Entities_RenderModels", Entities_RenderModels(delta, t));
 	Entities_RenderNames();
 
-	Particles_Render(t);
+	Profiler_Zone("Particles_Render", Particles_Render(t));
 	Camera.Active->GetPickedBlock(&Game_SelectedPos); /* TODO: only pick when necessary */
 	EnvRenderer_RenderSky();
 	EnvRenderer_RenderClouds();
 
-	MapRenderer_Update(delta);
-	MapRenderer_RenderNormal(delta);
+	Profiler_Zone("MapRenderer_Update",       MapRenderer_Update(delta));
+	Profiler_Zone("MapRenderer_RenderNormal", MapRenderer_RenderNormal(delta));
 	EnvRenderer_RenderMapSides();
 
 	Entities_DrawShadows();
@@ -471,11 +509,11 @@ static void Game_Render3D(double delta, float t) {
 	/* Render water over translucent blocks when under the water outside the map for proper alpha blending */
 	pos = Camera.CurrentPos;
 	if (pos.Y < Env.EdgeHeight && (pos.X < 0 || pos.Z < 0 || pos.X > World.Width || pos.Z > World.Length)) {
-		MapRenderer_RenderTranslucent(delta);
+		Profiler_Zone("MapRenderer_RenderTranslucent", MapRenderer_RenderTranslucent(delta));
 		EnvRenderer_RenderMapEdges();
 	} else {
 		EnvRenderer_RenderMapEdges();
-		MapRenderer_RenderTranslucent(delta);
+		Profiler_Zone("MapRenderer_RenderTranslucent", MapRenderer_RenderTranslucent(delta));
 	}
 
 	/* Need to render again over top of translucent block, as the selection outline */
@@ -490,18 +528,140 @@ static void Game_Render3D(double delta, float t) {
 	if (!Game_HideGui) HeldBlockRenderer_Render(delta);
 }
 
+static void PerformScheduledTask(struct ScheduledTask* task, cc_uint64 frameBeg) {
+	cc_uint64 beg, end;
+	double owed;
+	int dropped, runs;
+
+	/* Drop ticks beyond the catch-up limit, otherwise a long frame (e.g. loading a map) */
+	/* results in many ticks being run next frame, making that frame even longer */
+	owed = task->accumulator / task->interval;
+	if (owed >= task->maxCatchup + 1) {
+		dropped = (int)owed - task->maxCatchup;
+		task->droppedTicks += dropped;
+		task->accumulator  -= dropped * task->interval;
+	}
+
+	for (runs = 0, end = frameBeg; task->accumulator >= task->interval; runs++) {
+		/* Always run at least one tick, but postpone catching up once over budget */
+		if (runs && Stopwatch_ElapsedMicroseconds(frameBeg, end) >= TASKS_CATCHUP_BUDGET_US) {
+			task->deferredFrames++; return;
+		}
+
+		beg = Stopwatch_Measure();
+		task->Callback(task);
+		end = Stopwatch_Measure();
+
+		task->maxMs = max(task->maxMs, Stopwatch_ElapsedMicroseconds(beg, end) / 1000.0f);
+		task->ticks++;
+		task->accumulator -= task->interval;
+	}
+}
+
+/* Runs all tasks whose TASK_FLAG_TICK_THREAD flag matches the given flags */
+static void PerformTasksWithFlags(int flags) {
+	cc_uint64 beg = Stopwatch_Measure();
+	int i, priority;
+
+	for (priority = TASK_PRIORITY_HIGH; priority >= TASK_PRIORITY_LOW; priority--) {
+		for (i = 0; i < tasksCount; i++) {
+			if (tasks[i].priority != priority) continue;
+			if ((tasks[i].flags & TASK_FLAG_TICK_THREAD) != flags) continue;
+			PerformScheduledTask(&tasks[i], beg);
+		}
+	}
+}
+
+/* Entity tick thread runs tasks flagged TASK_FLAG_TICK_THREAD in lock-step with the main thread. */
+/* Main thread runs other tasks (network, physics, etc) itself first, then builds chunk meshes */
+/*  while tick thread ticks entities/particles, then waits for tick thread to finish. */
+/* So the only work overlapped is MapRenderer_BuildChunks - server/physics ticks and rendering */
+/*  still run serially on the main thread, hence entities/particles don't need double buffering. */
+static void* tick_thread;
+static void* tick_mutex;
+static void* tick_startWait;
+static void* tick_doneWait;
+static int tick_requested, tick_completed;
+static cc_bool tick_quit;
+
+static void TickThread_Run(void) {
+	cc_bool quit;
+	int request;
+	for (;;) {
+		Mutex_Lock(tick_mutex);
+		request = tick_requested;
+		quit    = tick_quit;
+		Mutex_Unlock(tick_mutex);
+
+		if (quit) return;
+		/* Waitable_Wait may return spuriously, so always recheck whether there is work */
+		if (request == tick_completed) { Waitable_Wait(tick_startWait); continue; }
+
+		PerformTasksWithFlags(TASK_FLAG_TICK_THREAD);
+		Mutex_Lock(tick_mutex);
+		tick_completed = request;
+		Mutex_Unlock(tick_mutex);
+		Waitable_Signal(tick_doneWait);
+	}
+}
+
+static void TickThread_Begin(void) {
+	Mutex_Lock(tick_mutex);
+	tick_requested++;
+	Mutex_Unlock(tick_mutex);
+	Waitable_Signal(tick_startWait);
+}
+
+static void TickThread_End(void) {
+	cc_bool done;
+	for (;;) {
+		Mutex_Lock(tick_mutex);
+		done = tick_completed == tick_requested;
+		Mutex_Unlock(tick_mutex);
+
+		if (done) return;
+		Waitable_Wait(tick_doneWait);
+	}
+}
+
+static void TickThread_Init(void) {
+#ifndef CC_BUILD_WEB
+	if (!Options_GetBool(OPT_ENTITY_TICK_THREAD, false)) return;
+	tick_mutex     = Mutex_Create();
+	tick_startWait = Waitable_Create();
+	tick_doneWait  = Waitable_Create();
+	tick_quit      = false;
+	tick_thread    = Thread_Start(TickThread_Run);
+#endif
+}
+
+static void TickThread_Free(void) {
+	if (!tick_thread) return;
+	Mutex_Lock(tick_mutex);
+	tick_quit = true;
+	Mutex_Unlock(tick_mutex);
+
+	Waitable_Signal(tick_startWait);
+	Thread_Join(tick_thread);
+
+	Mutex_Free(tick_mutex);
+	Waitable_Free(tick_startWait);
+	Waitable_Free(tick_doneWait);
+	tick_thread = NULL;
+}
+
 static void PerformScheduledTasks(double time) {
-	struct ScheduledTask* task;
 	int i;
-
 	for (i = 0; i < tasksCount; i++) {
-		task = &tasks[i];
-		task->accumulator += time;
+		tasks[i].accumulator += time;
+	}
 
-		while (task->accumulator >= task->interval) {
-			task->Callback(task);
-			task->accumulator -= task->interval;
-		}
+	/* Tick thread tasks are always run after other tasks, so order is the same either way */
+	PerformTasksWithFlags(0);
+	if (tick_thread) {
+		TickThread_Begin();
+	} else {
+		PerformTasksWithFlags(TASK_FLAG_TICK_THREAD);
 	}
 }
 
@@ -552,6 +712,7 @@ void Game_TakeScreenshot(void) {
 static void Game_RenderFrame(double delta) {
 	struct ScheduledTask entTask;
 	float t;
+	Profiler_NextFrame();
 
 	/* TODO: Should other tasks get called back too? */
 	/* Might not be such a good idea for the http_clearcache, */
@@ -579,9 +740,19 @@ static void Game_RenderFrame(double delta) {
 		InputHandler_SetFOV(Camera.ZoomFov);
 	}
 
-	PerformScheduledTasks(delta);
+	Jobs_RunCompleted();
+	Profiler_Zone("PerformScheduledTasks", PerformScheduledTasks(delta));
+	if (tick_thread) {
+		/* Build chunks while tick thread is ticking entities and particles */
+		if (!WindowInfo.Inactive && !Gui_GetBlocksWorld()) {
+			Profiler_Zone("MapRenderer_BuildChunks", MapRenderer_BuildChunks());
+		}
+		Profiler_Zone("TickThread_End", TickThread_End());
+	}
 	entTask = tasks[entTaskI];
+	/* Entity ticks may have been postponed, so don't extrapolate past next tick */
 	t = (float)(entTask.accumulator / entTask.interval);
+	t = min(t, 1.0f);
 	LocalPlayer_SetInterpPosition(t);
 
 	Camera.CurrentPos = Camera.Active->GetPosition(t);
@@ -597,17 +768,17 @@ static void Game_RenderFrame(double delta) {
 	Gfx_LoadMatrix(MATRIX_VIEW,       &Gfx.View);
 
 	if (!Gui_GetBlocksWorld()) {
-		Game_Render3D(delta, t);
+		Profiler_Zone("Game_Render3D", Game_Render3D(delta, t));
 	} else {
 		RayTracer_SetInvalid(&Game_SelectedPos);
 	}
 
 	Gfx_Begin2D(Game.Width, Game.Height);
-	Gui_RenderGui(delta);
+	Profiler_Zone("Gui_RenderGui", Gui_RenderGui(delta));
 	Gfx_End2D();
 
 	if (Game_ScreenshotRequested) Game_TakeScreenshot();
-	Gfx_EndFrame();
+	Profiler_Zone("Gfx_EndFrame", Gfx_EndFrame());
 }
 
 void Game_Free(void* obj) {
@@ -616,6 +787,7 @@ void Game_Free(void* obj) {
 	/* Set to false so components will always free managed textures too */
 	Gfx.ManagedTextures = false;
 	Event_UnregisterAll();
+	TickThread_Free();
 	tasksCount = 0;
 
 	for (comp = comps_head; comp; comp = comp->next) {
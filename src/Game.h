@@ -22,7 +22,7 @@ extern struct RayTracer Game_SelectedPos;
 extern cc_bool Game_UseCPEBlocks;
 
 extern cc_string Game_Username;
-extern cc_string Game_Mppass;
+extern cc_string Game_Mppass;
 
 #define DEFAULT_MAX_VIEWDIST 32768
 extern int Game_ViewDistance;
@@ -107,6 +107,13 @@ struct IGameComponent {
 /* Adds a component to linked list of components. (always at end) */
 CC_NOINLINE void Game_AddComponent(struct IGameComponent* comp);
 
+/* Order in which scheduled tasks are run each frame. (higher priority tasks run first) */
+enum TaskPriority { TASK_PRIORITY_LOW, TASK_PRIORITY_NORMAL, TASK_PRIORITY_HIGH };
+/* Task may be run on the entity tick thread (see OPT_ENTITY_TICK_THREAD), while the main thread builds chunks. */
+/* NOTE: Such tasks never overlap with other tasks (e.g. Server.Tick, Physics_Tick) or rendering. */
+/* Such tasks must not call graphics functions, raise events, or modify the world/GUI. */
+#define TASK_FLAG_TICK_THREAD 0x01
+
 /* Represents a task that periodically runs on the main thread every specified interval. */
 struct ScheduledTask;
 struct ScheduledTask {
@@ -116,9 +123,34 @@ struct ScheduledTask {
 	double interval;
 	/* Callback function that is periodically invoked */
 	void (*Callback)(struct ScheduledTask* task);
+	/* Name of this task, displayed in /client tasks */
+	const char* name;
+	/* Priority of this task, see TaskPriority enum */
+	int priority;
+	/* Flags for this task, see TASK_FLAG_ defines */
+	int flags;
+	/* Maximum times callback is invoked in one frame to catch up. */
+	/* Any time still owed beyond this is dropped. (to avoid a spiral of ever longer frames) */
+	int maxCatchup;
+	/* Total number of times callback has been invoked */
+	int ticks;
+	/* Total number of ticks dropped due to exceeding maxCatchup */
+	int droppedTicks;
+	/* Number of frames where ticks were postponed due to exceeding the frame's time budget */
+	int deferredFrames;
+	/* Longest time (in milliseconds) a single invocation of callback has taken */
+	float maxMs;
 };
 
 typedef void (*ScheduledTaskCallback)(struct ScheduledTask* task);
-/* Adds a task to list of scheduled tasks. (always at end) */
+/* Adds a task to list of scheduled tasks, with normal priority. (always at end) */
 CC_API int ScheduledTask_Add(double interval, ScheduledTaskCallback callback);
+/* Adds a task to list of scheduled tasks, with the given priority. (always at end) */
+/* maxCatchup of 0 means at most 0.25 seconds worth of ticks are run to catch up */
+CC_API int ScheduledTask_AddEx(const char* name, double interval, ScheduledTaskCallback callback,
+								int priority, int maxCatchup, int flags);
+/* Returns the scheduled task at the given index. (as returned by ScheduledTask_Add) */
+CC_API struct ScheduledTask* ScheduledTask_Get(int i);
+/* Returns the number of scheduled tasks. */
+CC_API int ScheduledTask_Count(void);
 #endif
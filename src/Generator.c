@@ -1,10 +1,24 @@
+#if defined __x86_64__ || defined _M_X64
+/* Included first, since C++ standard headers may #undef the min/max macros from Funcs.h */
+#include <emmintrin.h>
+#define NOISE_SSE2
+#endif
 #include "Generator.h"
 #include "BlockID.h"
 #include "ExtMath.h"
 #include "Funcs.h"
 #include "Platform.h"
+#include "Jobs.h"
 #include "World.h"
 #include "Utils.h"
+#include "String.h"
+#include "Block.h"
+#include "Game.h"
+#include "Formats.h"
+#include "Logger.h"
+#include "Stream.h"
+#include "Errors.h"
+#include "Options.h"
 
 volatile float Gen_CurrentProgress;
 volatile const char* Gen_CurrentState;
@@ -111,6 +125,75 @@ static float ImprovedNoise_Calc(const cc_uint8* p, float x, float y) {
 	return c1 + v * (c2 - c1);
 }
 
+/* Noise is calculated for 4 samples at once where possible, which is much faster when SIMD is available */
+#define NOISE_BATCH 4
+/* SSE2 results are identical to the scalar version, as on x86_64 scalar float maths also uses SSE registers */
+/* (other architectures may contract the scalar version into FMA instructions, so just use the scalar version) */
+
+#ifdef NOISE_SSE2
+/* Computes (gx * x + gy * y) for each gradient, identical to the scalar version */
+#define ImprovedNoise_Grad4(gx, gy, x, y) _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(gx), x), _mm_mul_ps(_mm_loadu_ps(gy), y))
+
+static void ImprovedNoise_Calc4(const cc_uint8* p, const float* xs, const float* ys, float* out) {
+	float gx22[NOISE_BATCH], gx12[NOISE_BATCH], gx21[NOISE_BATCH], gx11[NOISE_BATCH];
+	float gy22[NOISE_BATCH], gy12[NOISE_BATCH], gy21[NOISE_BATCH], gy11[NOISE_BATCH];
+	int xFloor[NOISE_BATCH], yFloor[NOISE_BATCH];
+	int i, X, Y, A, B, hash;
+	__m128 x, y, u, v, one, g22, g12, g21, g11, c1, c2;
+	__m128i xi, yi;
+
+	x  = _mm_loadu_ps(xs);
+	y  = _mm_loadu_ps(ys);
+	/* Same as (int)x for positive, (int)x - 1 for negative */
+	xi = _mm_add_epi32(_mm_cvttps_epi32(x), _mm_castps_si128(_mm_cmplt_ps(x, _mm_setzero_ps())));
+	yi = _mm_add_epi32(_mm_cvttps_epi32(y), _mm_castps_si128(_mm_cmplt_ps(y, _mm_setzero_ps())));
+	_mm_storeu_si128((__m128i*)xFloor, xi);
+	_mm_storeu_si128((__m128i*)yFloor, yi);
+
+	/* Looking up permutation table can't be vectorised with SSE2 */
+	for (i = 0; i < NOISE_BATCH; i++) {
+		X = xFloor[i] & 0xFF; Y = yFloor[i] & 0xFF;
+		A = p[X] + Y; B = p[X + 1] + Y;
+
+		hash = (p[p[A]] & 0xF) << 1;
+		gx22[i] = (float)(((xFlags >> hash) & 3) - 1); gy22[i] = (float)(((yFlags >> hash) & 3) - 1);
+		hash = (p[p[B]] & 0xF) << 1;
+		gx12[i] = (float)(((xFlags >> hash) & 3) - 1); gy12[i] = (float)(((yFlags >> hash) & 3) - 1);
+		hash = (p[p[A + 1]] & 0xF) << 1;
+		gx21[i] = (float)(((xFlags >> hash) & 3) - 1); gy21[i] = (float)(((yFlags >> hash) & 3) - 1);
+		hash = (p[p[B + 1]] & 0xF) << 1;
+		gx11[i] = (float)(((xFlags >> hash) & 3) - 1); gy11[i] = (float)(((yFlags >> hash) & 3) - 1);
+	}
+
+	x = _mm_sub_ps(x, _mm_cvtepi32_ps(xi));
+	y = _mm_sub_ps(y, _mm_cvtepi32_ps(yi));
+	one = _mm_set1_ps(1.0f);
+
+	/* x * x * x * (x * (x * 6 - 15) + 10) */
+	u = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(x, x), x),
+		_mm_add_ps(_mm_mul_ps(x, _mm_sub_ps(_mm_mul_ps(x, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))), _mm_set1_ps(10.0f)));
+	v = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(y, y), y),
+		_mm_add_ps(_mm_mul_ps(y, _mm_sub_ps(_mm_mul_ps(y, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))), _mm_set1_ps(10.0f)));
+
+	g22 = ImprovedNoise_Grad4(gx22, gy22, x,                   y);
+	g12 = ImprovedNoise_Grad4(gx12, gy12, _mm_sub_ps(x, one), y);
+	c1  = _mm_add_ps(g22, _mm_mul_ps(u, _mm_sub_ps(g12, g22)));
+
+	g21 = ImprovedNoise_Grad4(gx21, gy21, x,                   _mm_sub_ps(y, one));
+	g11 = ImprovedNoise_Grad4(gx11, gy11, _mm_sub_ps(x, one), _mm_sub_ps(y, one));
+	c2  = _mm_add_ps(g21, _mm_mul_ps(u, _mm_sub_ps(g11, g21)));
+
+	_mm_storeu_ps(out, _mm_add_ps(c1, _mm_mul_ps(v, _mm_sub_ps(c2, c1))));
+}
+#else
+static void ImprovedNoise_Calc4(const cc_uint8* p, const float* xs, const float* ys, float* out) {
+	int i;
+	for (i = 0; i < NOISE_BATCH; i++) {
+		out[i] = ImprovedNoise_Calc(p, xs[i], ys[i]);
+	}
+}
+#endif
+
 
 struct OctaveNoise { cc_uint8 p[8][NOISE_TABLE_SIZE]; int octaves; };
 static void OctaveNoise_Init(struct OctaveNoise* n, RNGState* rnd, int octaves) {
@@ -135,6 +218,26 @@ static float OctaveNoise_Calc(const struct OctaveNoise* n, float x, float y) {
 	return sum;
 }
 
+static void OctaveNoise_Calc4(const struct OctaveNoise* n, const float* xs, const float* ys, float* out) {
+	float amplitude = 1, freq = 1;
+	float x[NOISE_BATCH], y[NOISE_BATCH], value[NOISE_BATCH];
+	int i, j;
+	for (j = 0; j < NOISE_BATCH; j++) { out[j] = 0; }
+
+	for (i = 0; i < n->octaves; i++) {
+		for (j = 0; j < NOISE_BATCH; j++) {
+			x[j] = xs[j] * freq; y[j] = ys[j] * freq;
+		}
+		ImprovedNoise_Calc4(n->p[i], x, y, value);
+
+		for (j = 0; j < NOISE_BATCH; j++) {
+			out[j] += value[j] * amplitude;
+		}
+		amplitude *= 2.0f;
+		freq *= 0.5f;
+	}
+}
+
 
 struct CombinedNoise { struct OctaveNoise noise1, noise2; };
 static void CombinedNoise_Init(struct CombinedNoise* n, RNGState* rnd, int octaves1, int octaves2) {
@@ -142,9 +245,13 @@ static void CombinedNoise_Init(struct CombinedNoise* n, RNGState* rnd, int octav
 	OctaveNoise_Init(&n->noise2, rnd, octaves2);
 }
 
-static float CombinedNoise_Calc(const struct CombinedNoise* n, float x, float y) {
-	float offset = OctaveNoise_Calc(&n->noise2, x, y);
-	return OctaveNoise_Calc(&n->noise1, x + offset, y);
+static void CombinedNoise_Calc4(const struct CombinedNoise* n, const float* xs, const float* ys, float* out) {
+	float offset[NOISE_BATCH];
+	int j;
+	OctaveNoise_Calc4(&n->noise2, xs, ys, offset);
+
+	for (j = 0; j < NOISE_BATCH; j++) { offset[j] += xs[j]; }
+	OctaveNoise_Calc4(&n->noise1, offset, ys, out);
 }
 
 
@@ -155,6 +262,40 @@ static int waterLevel, minHeight;
 static cc_int16* Heightmap;
 static RNGState rnd;
 
+/* Stages that only depend on the blocks in each column can be split across the job workers */
+/*  (Output is identical to generating on one thread, as random state isn't used by these stages) */
+/* Rows of the map are processed in batches to reduce the overhead of claiming work */
+#define GEN_ROWS_BATCH 8
+typedef void (*NotchyGen_RowsFunc)(int zBeg, int zEnd);
+
+static struct NotchyGenRows {
+	NotchyGen_RowsFunc func;
+	void* mutex;
+	int done;
+} gen_rows;
+
+static void NotchyGen_RowsBatch(void* obj, int zBeg, int zEnd) {
+	gen_rows.func(zBeg, zEnd);
+
+	Mutex_Lock(gen_rows.mutex);
+	{
+		gen_rows.done += zEnd - zBeg;
+		Gen_CurrentProgress = (float)gen_rows.done / World.Length;
+	}
+	Mutex_Unlock(gen_rows.mutex);
+}
+
+/* Calls the given function on all rows of the map, using the job workers */
+static void NotchyGen_ForEachRow(NotchyGen_RowsFunc func) {
+	gen_rows.func  = func;
+	gen_rows.mutex = Mutex_Create();
+	gen_rows.done  = 0;
+
+	/* Generating thread processes rows too */
+	Jobs_ParallelFor(World.Length, GEN_ROWS_BATCH, NotchyGen_RowsBatch, NULL);
+	Mutex_Free(gen_rows.mutex);
+}
+
 static void NotchyGen_FillOblateSpheroid(int x, int y, int z, float radius, BlockRaw block) {
 	int xBeg = Math_Floor(max(x - radius, 0));
 	int xEnd = Math_Floor(min(x + radius, World.MaxX));
@@ -217,38 +358,65 @@ static void NotchyGen_FloodFill(int index, BlockRaw block) {
 }
 
 
-static void NotchyGen_CreateHeightmap(void) {
-	float hLow, hHigh, height;
-	int hIndex = 0, adjHeight;
-	int x, z;
-	struct CombinedNoise n1, n2;
-	struct OctaveNoise n3;
+static struct CombinedNoise heightmap_n1, heightmap_n2;
+static struct OctaveNoise heightmap_n3;
 
-	CombinedNoise_Init(&n1, &rnd, 8, 8);
-	CombinedNoise_Init(&n2, &rnd, 8, 8);	
-	OctaveNoise_Init(&n3, &rnd, 6);
+static void NotchyGen_HeightmapRows(int zBeg, int zEnd) {
+	float xs[NOISE_BATCH], zs[NOISE_BATCH], xs2[NOISE_BATCH], zs2[NOISE_BATCH];
+	float low[NOISE_BATCH], high[NOISE_BATCH], sel[NOISE_BATCH];
+	float hLow, hHigh, height;
+	int hIndex = zBeg * World.Width, adjHeight;
+	int rowsMin = World.Height;
+	int i, x, z, count;
+
+	for (z = zBeg; z < zEnd; z++) {
+		for (x = 0; x < World.Width; x += NOISE_BATCH) {
+			/* Samples past the end of the row are just discarded */
+			count = min(NOISE_BATCH, World.Width - x);
+			for (i = 0; i < NOISE_BATCH; i++) {
+				xs[i]  = (x + i) * 1.3f; zs[i]  = z * 1.3f;
+				xs2[i] = (float)(x + i); zs2[i] = (float)z;
+			}
 
-	Gen_CurrentState = "Building heightmap";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
+			CombinedNoise_Calc4(&heightmap_n1, xs, zs, low);
+			OctaveNoise_Calc4(&heightmap_n3,  xs2, zs2, sel);
+			for (i = 0; i < count; i++) {
+				if (sel[i] <= 0) break;
+			}
+			if (i < count) CombinedNoise_Calc4(&heightmap_n2, xs, zs, high);
 
-		for (x = 0; x < World.Width; x++) {
-			hLow   = CombinedNoise_Calc(&n1, x * 1.3f, z * 1.3f) / 6 - 4;
-			height = hLow;
+			for (i = 0; i < count; i++) {
+				hLow   = low[i] / 6 - 4;
+				height = hLow;
 
-			if (OctaveNoise_Calc(&n3, (float)x, (float)z) <= 0) {
-				hHigh = CombinedNoise_Calc(&n2, x * 1.3f, z * 1.3f) / 5 + 6;
-				height = max(hLow, hHigh);
-			}
+				if (sel[i] <= 0) {
+					hHigh  = high[i] / 5 + 6;
+					height = max(hLow, hHigh);
+				}
 
-			height *= 0.5f;
-			if (height < 0) height *= 0.8f;
+				height *= 0.5f;
+				if (height < 0) height *= 0.8f;
 
-			adjHeight = (int)(height + waterLevel);
-			minHeight = min(adjHeight, minHeight);
-			Heightmap[hIndex++] = adjHeight;
+				adjHeight = (int)(height + waterLevel);
+				rowsMin   = min(adjHeight, rowsMin);
+				Heightmap[hIndex++] = adjHeight;
+			}
 		}
 	}
+
+	Mutex_Lock(gen_rows.mutex);
+	minHeight = min(rowsMin, minHeight);
+	Mutex_Unlock(gen_rows.mutex);
+}
+
+static void NotchyGen_CreateHeightmap(void) {
+	CombinedNoise_Init(&heightmap_n1, &rnd, 8, 8);
+	CombinedNoise_Init(&heightmap_n2, &rnd, 8, 8);	
+	OctaveNoise_Init(&heightmap_n3,   &rnd, 6);
+
+	Gen_CurrentState    = "Building heightmap";
+	Gen_CurrentProgress = 0.0f;
+	NotchyGen_ForEachRow(NotchyGen_HeightmapRows);
 }
 
 static int NotchyGen_CreateStrataFast(void) {
@@ -280,23 +448,26 @@ static int NotchyGen_CreateStrataFast(void) {
 	return max(stoneHeight, 1);
 }
 
-static void NotchyGen_CreateStrata(void) {
-	int dirtThickness, dirtHeight;
-	int minStoneY, stoneHeight;
-	int hIndex = 0, maxY = World.MaxY, index = 0;
-	int x, y, z;
-	struct OctaveNoise n;
-
-	/* Try to bulk fill bottom of the map if possible */
-	minStoneY = NotchyGen_CreateStrataFast();
-	OctaveNoise_Init(&n, &rnd, 8);
+static struct OctaveNoise strata_n;
+static int strata_minStoneY;
 
-	Gen_CurrentState = "Creating strata";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
+static void NotchyGen_StrataRows(int zBeg, int zEnd) {
+	float xs[NOISE_BATCH], zs[NOISE_BATCH], thickness[NOISE_BATCH];
+	int dirtThickness, dirtHeight;
+	int minStoneY = strata_minStoneY, stoneHeight;
+	int hIndex = zBeg * World.Width, maxY = World.MaxY, index = 0;
+	int x, y, z, i;
 
+	for (z = zBeg; z < zEnd; z++) {
 		for (x = 0; x < World.Width; x++) {
-			dirtThickness = (int)(OctaveNoise_Calc(&n, (float)x, (float)z) / 24 - 4);
+			i = x % NOISE_BATCH;
+			if (!i) {
+				for (i = 0; i < NOISE_BATCH; i++) { xs[i] = (float)(x + i); zs[i] = (float)z; }
+				OctaveNoise_Calc4(&strata_n, xs, zs, thickness);
+				i = 0;
+			}
+
+			dirtThickness = (int)(thickness[i] / 24 - 4);
 			dirtHeight    = Heightmap[hIndex++];
 			stoneHeight   = dirtHeight + dirtThickness;
 
@@ -317,6 +488,16 @@ static void NotchyGen_CreateStrata(void) {
 	}
 }
 
+static void NotchyGen_CreateStrata(void) {
+	/* Try to bulk fill bottom of the map if possible */
+	strata_minStoneY = NotchyGen_CreateStrataFast();
+	OctaveNoise_Init(&strata_n, &rnd, 8);
+
+	Gen_CurrentState    = "Creating strata";
+	Gen_CurrentProgress = 0.0f;
+	NotchyGen_ForEachRow(NotchyGen_StrataRows);
+}
+
 static void NotchyGen_CarveCaves(void) {
 	int cavesCount, caveLen;
 	float caveX, caveY, caveZ;
@@ -457,19 +638,14 @@ static void NotchyGen_FloodFillLava(void) {
 	}
 }
 
-static void NotchyGen_CreateSurfaceLayer(void) {	
-	int hIndex = 0, index;
+static struct OctaveNoise surface_n1, surface_n2;
+
+static void NotchyGen_SurfaceRows(int zBeg, int zEnd) {
+	int hIndex = zBeg * World.Width, index;
 	BlockRaw above;
 	int x, y, z;
-	struct OctaveNoise n1, n2;
-
-	OctaveNoise_Init(&n1, &rnd, 8);
-	OctaveNoise_Init(&n2, &rnd, 8);
-
-	Gen_CurrentState = "Creating surface";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
 
+	for (z = zBeg; z < zEnd; z++) {
 		for (x = 0; x < World.Width; x++) {
 			y = Heightmap[hIndex++];
 			if (y < 0 || y >= World.Height) continue;
@@ -478,15 +654,24 @@ static void NotchyGen_CreateSurfaceLayer(void) {
 			above = y >= World.MaxY ? BLOCK_AIR : Gen_Blocks[index + World.OneY];
 
 			/* TODO: update heightmap */
-			if (above == BLOCK_STILL_WATER && (OctaveNoise_Calc(&n2, (float)x, (float)z) > 12)) {
+			if (above == BLOCK_STILL_WATER && (OctaveNoise_Calc(&surface_n2, (float)x, (float)z) > 12)) {
 				Gen_Blocks[index] = BLOCK_GRAVEL;
 			} else if (above == BLOCK_AIR) {
-				Gen_Blocks[index] = (y <= waterLevel && (OctaveNoise_Calc(&n1, (float)x, (float)z) > 8)) ? BLOCK_SAND : BLOCK_GRASS;
+				Gen_Blocks[index] = (y <= waterLevel && (OctaveNoise_Calc(&surface_n1, (float)x, (float)z) > 8)) ? BLOCK_SAND : BLOCK_GRASS;
 			}
 		}
 	}
 }
 
+static void NotchyGen_CreateSurfaceLayer(void) {
+	OctaveNoise_Init(&surface_n1, &rnd, 8);
+	OctaveNoise_Init(&surface_n2, &rnd, 8);
+
+	Gen_CurrentState    = "Creating surface";
+	Gen_CurrentProgress = 0.0f;
+	NotchyGen_ForEachRow(NotchyGen_SurfaceRows);
+}
+
 static void NotchyGen_PlantFlowers(void) {
 	int numPatches;
 	BlockRaw block;
@@ -635,6 +820,224 @@ void NotchyGen_Generate(void) {
 }
 
 
+/*########################################################################################################################*
+*------------------------------------------------Generator test/benchmark------------------------------------------------*
+*#########################################################################################################################*/
+/* Headless regression test and benchmark, so generator and map format changes can be */
+/*  checked for identical output, and generator changes can be timed */
+static const struct GenTestCase { int seed, width, height, length; cc_uint32 crc; } gen_testCases[] = {
+	/* Checksums of the blocks generated by the original single threaded NotchyGen */
+	{     12345, 256,  64, 256, 0x25D16B22UL },
+	{         0, 128,  64, 128, 0x572ED8B0UL },
+	{        -7,  64, 128,  96, 0x0B2A1174UL },
+	{ 987654321, 200,  96, 136, 0xC41DE966UL },
+	{        42, 512,  64, 512, 0x20748949UL },
+};
+/* Threaded generation must always be checked, even on single core machines */
+#define GEN_TEST_MIN_WORKERS 2
+
+static void Gen_TestWarn(const cc_string* msg) {
+	Platform_Log(msg->buffer, msg->length);
+}
+
+/* Generates the map for the given test case, checking the blocks match the original generator's */
+static cc_result Gen_TestGenerate(const struct GenTestCase* tc) {
+	cc_string str; char strBuffer[STRING_SIZE * 2];
+	cc_uint32 crc;
+
+	World_SetDimensions(tc->width, tc->height, tc->length);
+	Gen_Seed   = tc->seed;
+	Gen_Blocks = (BlockRaw*)Mem_Alloc(World.Volume, 1, "map blocks");
+	NotchyGen_Generate();
+	crc = Utils_CRC32(Gen_Blocks, World.Volume);
+
+	String_InitArray(str, strBuffer);
+	String_Format4(&str, "Seed %i, %ix%ix%i", &tc->seed, &tc->width, &tc->height, &tc->length);
+	String_Format3(&str, " with %i workers: %h (expected %h)", &Jobs_WorkerCount, &crc, &tc->crc);
+	Platform_Log(str.buffer, str.length);
+	return crc == tc->crc ? 0 : ERR_CHECKSUM_MISMATCH;
+}
+
+/* Generates all the test cases, returning the first error */
+/* If first is not NULL, it is set to the blocks of the first test case instead of freeing them */
+static cc_result Gen_TestGenerateAll(BlockRaw** first) {
+	cc_result res = 0, caseRes;
+	int i;
+
+	for (i = 0; i < Array_Elems(gen_testCases); i++) {
+		caseRes = Gen_TestGenerate(&gen_testCases[i]);
+		if (!res) res = caseRes;
+
+		if (i == 0 && first) {
+			*first = Gen_Blocks;
+		} else {
+			Mem_Free(Gen_Blocks);
+		}
+		Gen_Blocks = NULL;
+	}
+	return res;
+}
+
+static void Gen_TestStartWorkers(void) {
+	Jobs_Component.Init();
+	if (Jobs_WorkerCount >= GEN_TEST_MIN_WORKERS) return;
+
+	/* NOTE: Options are never saved when running the test, so this doesn't change job-threads */
+	Jobs_Component.Free();
+	Options_SetInt(OPT_JOB_THREADS, GEN_TEST_MIN_WORKERS);
+	Jobs_Component.Init();
+}
+
+static cc_result Gen_TestSaveLoad(const cc_string* path, cc_uint32* crc) {
+	struct Stream stream;
+	cc_result res, closeRes;
+
+	res = Stream_CreateFile(&stream, path);
+	if (res) { Logger_SysWarn2(res, "creating", path); return res; }
+	res      = Ccw_Save(&stream);
+	closeRes = stream.Close(&stream);
+	if (!res) res = closeRes;
+	if (res) { Logger_SysWarn2(res, "encoding", path); return res; }
+
+	World_Reset();
+	res = Stream_OpenFile(&stream, path);
+	if (res) { Logger_SysWarn2(res, "opening", path); return res; }
+	res = Ccw_Load(&stream);
+
+	/* No point logging error for closing readonly file */
+	stream.Close(&stream);
+	if (res) { Logger_SysWarn2(res, "decoding", path); return res; }
+
+	*crc = Utils_CRC32(World.Blocks, World.Volume);
+	return 0;
+}
+
+/* Loads a copy of the given map with a byte in the middle changed, which should fail */
+static cc_result Gen_TestCorrupted(const cc_string* path, cc_result* loadRes) {
+	struct Stream stream;
+	cc_uint8* data;
+	cc_uint32 size;
+	cc_result res;
+
+	res = Stream_OpenFile(&stream, path);
+	if (res) { Logger_SysWarn2(res, "opening", path); return res; }
+	res = stream.Length(&stream, &size);
+
+	data = (cc_uint8*)Mem_Alloc(size, 1, "corrupted map");
+	if (!res) res = Stream_Read(&stream, data, size);
+	stream.Close(&stream);
+	if (res) { Logger_SysWarn2(res, "reading", path); Mem_Free(data); return res; }
+
+	/* Most of the file is compressed region data, which is protected by each region's checksum */
+	data[size / 2] ^= 0xFF;
+	World_Reset();
+	Stream_ReadonlyMemory(&stream, data, size);
+	*loadRes = Ccw_Load(&stream);
+
+	Mem_Free(data);
+	return 0;
+}
+
+cc_result Gen_RunTest(const cc_string* path) {
+	cc_string str; char strBuffer[STRING_SIZE];
+	const struct GenTestCase* tc = &gen_testCases[0];
+	BlockRaw* blocks = NULL;
+	cc_uint32 loadedCRC;
+	cc_result res, loadRes;
+
+	Logger_WarnFunc = Gen_TestWarn;
+	Blocks_Component.Init();
+	World_Reset();
+
+	/* Without any workers, all rows are generated on the calling thread */
+	res = Gen_TestGenerateAll(NULL);
+	Gen_TestStartWorkers();
+	if (!res) res = Gen_TestGenerateAll(&blocks);
+
+	if (!res) {
+		World_SetNewMap(blocks, tc->width, tc->height, tc->length);
+		res = Gen_TestSaveLoad(path, &loadedCRC);
+	} else {
+		Mem_Free(blocks);
+	}
+
+	if (!res) {
+		String_InitArray(str, strBuffer);
+		String_Format1(&str, "Saved then loaded: %h", &loadedCRC);
+		Platform_Log(str.buffer, str.length);
+		if (loadedCRC != tc->crc) res = ERR_CHECKSUM_MISMATCH;
+	}
+
+	/* Loading corrupted data must fail, rather than silently giving a different world */
+	if (!res && !(res = Gen_TestCorrupted(path, &loadRes))) {
+		if (loadRes) {
+			Logger_SysWarn2(loadRes, "loading corrupted copy of", path);
+		} else {
+			Platform_LogConst("Corrupted copy of map loaded without any error");
+			res = ERR_CHECKSUM_MISMATCH;
+		}
+	}
+
+	Jobs_Component.Free();
+	World_Reset();
+	Platform_LogConst(res ? "Generator test FAILED" : "Generator test passed");
+	return res;
+}
+
+static void Gen_BenchSize(int width, int height, int length) {
+	cc_string str; char strBuffer[STRING_SIZE];
+	cc_uint64 beg, end;
+	cc_uint32 crc;
+	float elapsed;
+
+	World_SetDimensions(width, height, length);
+	Gen_Blocks = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+	if (!Gen_Blocks) { Logger_SysWarn(ERR_OUT_OF_MEMORY, "allocating map blocks"); return; }
+
+	beg = Stopwatch_Measure();
+	NotchyGen_Generate();
+	end = Stopwatch_Measure();
+
+	elapsed = Stopwatch_ElapsedMicroseconds(beg, end) / 1000.0f;
+	crc     = Utils_CRC32(Gen_Blocks, World.Volume);
+	Mem_Free(Gen_Blocks);
+	Gen_Blocks = NULL;
+
+	String_InitArray(str, strBuffer);
+	String_Format3(&str, "%ix%ix%i: ", &width, &height, &length);
+	String_Format2(&str, "%f2 ms, checksum %h", &elapsed, &crc);
+	Platform_Log(str.buffer, str.length);
+}
+
+cc_result Gen_RunBenchmark(int seed, int width, int height, int length) {
+	static const int sizes[][3] = { { 128, 64, 128 }, { 256, 64, 256 }, { 512, 64, 512 }, { 1024, 64, 1024 } };
+	cc_string str; char strBuffer[STRING_SIZE];
+	int i;
+
+	Logger_WarnFunc = Gen_TestWarn;
+	Blocks_Component.Init();
+	Jobs_Component.Init();
+	World_Reset();
+	Gen_Seed = seed;
+
+	String_InitArray(str, strBuffer);
+	String_Format2(&str, "Generating seed %i with %i workers", &seed, &Jobs_WorkerCount);
+	Platform_Log(str.buffer, str.length);
+
+	if (width) {
+		Gen_BenchSize(width, height, length);
+	} else {
+		for (i = 0; i < Array_Elems(sizes); i++) {
+			Gen_BenchSize(sizes[i][0], sizes[i][1], sizes[i][2]);
+		}
+	}
+
+	Jobs_Component.Free();
+	World_Reset();
+	return 0;
+}
+
+
 /*########################################################################################################################*
 *----------------------------------------------------Tree generation------------------------------------------------------*
 *#########################################################################################################################*/
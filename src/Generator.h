@@ -20,6 +20,16 @@ extern BlockRaw* Gen_Blocks;
 
 void FlatgrassGen_Generate(void);
 void NotchyGen_Generate(void);
+/* Checks that generating maps for several seeds and sizes gives the same blocks as the original */
+/*  generator, both on just one thread and with at least 2 job workers. Also checks that saving */
+/*  then loading a map to the given .ccw file keeps the same blocks, and that loading a corrupted */
+/*  copy of the map fails. Results are logged. */
+/* NOTE: Runs without a window or the rest of the game initialised. (see --gen-test) */
+cc_result Gen_RunTest(const cc_string* path);
+/* Times generating maps of several sizes (or just the given size if width is not 0) with the given seed. */
+/* Results (including a checksum of each generated map) are logged. */
+/* NOTE: Runs without a window or the rest of the game initialised. (see --gen-bench) */
+cc_result Gen_RunBenchmark(int seed, int width, int height, int length);
 
 extern BlockRaw* Tree_Blocks;
 extern RNGState* Tree_Rnd;
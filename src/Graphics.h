@@ -48,6 +48,20 @@ CC_VAR extern struct _GfxData {
 	struct Matrix View, Projection;
 } Gfx;
 
+#ifdef CC_BUILD_NULLGFX
+/* Counters kept by the null backend in place of actually rendering anything */
+CC_VAR extern struct _GfxNullStats {
+	/* Number of textures and vertex/index buffers currently alive */
+	int Textures, VertexBuffers, IndexBuffers;
+	/* Memory that alive textures and buffers would occupy on a GPU */
+	cc_uint64 TextureBytes, BufferBytes;
+	/* Number of draw calls and vertices drawn in the most recent frame */
+	int FrameDrawCalls, FrameVertices;
+	/* Totals since the game started */
+	cc_uint64 Frames, DrawCalls, Vertices, TextureUploads;
+} GfxNullStats;
+#endif
+
 extern GfxResourceID Gfx_defaultIb;
 extern GfxResourceID Gfx_quadVb, Gfx_texVb;
 extern const cc_string Gfx_LowPerfMessage;
@@ -531,6 +531,7 @@ static void APIENTRY fake_bufferData(GLenum target, cc_uintptr size, const GLvoi
 	Mem_Free(buffer->data);
 
 	buffer->data = Mem_TryAlloc(size, 1);
+	Mem_SetPlace(buffer->data, "vertex buffer data");
 	if (data) Mem_Copy(buffer->data, data, size);
 }
 static void APIENTRY fake_bufferSubData(GLenum target, cc_uintptr offset, cc_uintptr size, const GLvoid* data) {
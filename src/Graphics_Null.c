@@ -0,0 +1,291 @@
+#include "Core.h"
+#if defined CC_BUILD_NULLGFX
+#include "_GraphicsBase.h"
+#include "Errors.h"
+#include "Logger.h"
+#include "Window.h"
+/* Null backend: performs no rendering at all, but keeps track of */
+/*  how many resources would have been created and drawn instead. */
+/* Lets the render path be run and profiled on machines without a GPU */
+
+struct _GfxNullStats GfxNullStats;
+/* Only resource memory that callers write into is actually allocated */
+struct NullTexture { cc_uint32 size; };
+struct NullBuffer  { cc_uint32 size; cc_uint8* data; };
+static int gfx_stride, gfx_format = -1;
+static cc_uint32 frameDrawCalls, frameVertices;
+
+void Gfx_Create(void) {
+	Gfx.MaxTexWidth  = 8192;
+	Gfx.MaxTexHeight = 8192;
+	Gfx.Created      = true;
+	Gfx.LostContext  = false;
+	Gfx_RestoreState();
+}
+
+cc_bool Gfx_TryRestoreContext(void) { return true; }
+void Gfx_Free(void) { Gfx_FreeState(); }
+
+static void Gfx_FreeState(void)    { FreeDefaultResources(); }
+static void Gfx_RestoreState(void) { 
+	InitDefaultResources();
+	gfx_format = -1;
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------------Textures--------------------------------------------------------*
+*#########################################################################################################################*/
+static cc_uint32 CalcTextureSize(int width, int height, cc_bool mipmaps) {
+	cc_uint32 size = width * height * 4;
+	int lvl, lvls;
+	if (!mipmaps) return size;
+
+	lvls = CalcMipmapsLevels(width, height);
+	for (lvl = 1; lvl <= lvls; lvl++) {
+		if (width  > 1) width  /= 2;
+		if (height > 1) height /= 2;
+		size += width * height * 4;
+	}
+	return size;
+}
+
+GfxResourceID Gfx_CreateTexture(struct Bitmap* bmp, cc_uint8 flags, cc_bool mipmaps) {
+	struct NullTexture* tex;
+	if (!Math_IsPowOf2(bmp->width) || !Math_IsPowOf2(bmp->height)) {
+		Logger_Abort("Textures must have power of two dimensions");
+	}
+	if (Gfx.LostContext) return 0;
+
+	tex = (struct NullTexture*)Mem_Alloc(1, sizeof(struct NullTexture), "null texture");
+	tex->size = CalcTextureSize(bmp->width, bmp->height, mipmaps);
+
+	GfxNullStats.Textures++;
+	GfxNullStats.TextureBytes += tex->size;
+	return (GfxResourceID)tex;
+}
+
+void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, int rowWidth, cc_bool mipmaps) {
+	GfxNullStats.TextureUploads++;
+}
+
+void Gfx_UpdateTexturePart(GfxResourceID texId, int x, int y, struct Bitmap* part, cc_bool mipmaps) {
+	Gfx_UpdateTexture(texId, x, y, part, part->width, mipmaps);
+}
+
+void Gfx_DeleteTexture(GfxResourceID* texId) {
+	struct NullTexture* tex = (struct NullTexture*)(*texId);
+	if (!tex) return;
+
+	GfxNullStats.Textures--;
+	GfxNullStats.TextureBytes -= tex->size;
+	Mem_Free(tex);
+	*texId = 0;
+}
+
+void Gfx_BindTexture(GfxResourceID texId) { }
+void Gfx_SetTexturing(cc_bool enabled) { }
+void Gfx_EnableMipmaps(void)  { }
+void Gfx_DisableMipmaps(void) { }
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------State management----------------------------------------------------*
+*#########################################################################################################################*/
+void Gfx_SetFog(cc_bool enabled)     { gfx_fogEnabled = enabled; }
+void Gfx_SetFogCol(PackedCol color)  { }
+void Gfx_SetFogDensity(float value)  { }
+void Gfx_SetFogEnd(float value)      { }
+void Gfx_SetFogMode(FogFunc func)    { }
+
+void Gfx_SetFaceCulling(cc_bool enabled)   { }
+void Gfx_SetAlphaTest(cc_bool enabled)     { }
+void Gfx_SetAlphaBlending(cc_bool enabled) { }
+void Gfx_SetAlphaArgBlend(cc_bool enabled) { }
+
+void Gfx_ClearCol(PackedCol color)     { }
+void Gfx_SetDepthTest(cc_bool enabled)  { }
+void Gfx_SetDepthWrite(cc_bool enabled) { }
+void Gfx_SetColWriteMask(cc_bool r, cc_bool g, cc_bool b, cc_bool a) { }
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Index buffers-----------------------------------------------------*
+*#########################################################################################################################*/
+GfxResourceID Gfx_CreateIb(void* indices, int indicesCount) {
+	struct NullBuffer* ib = (struct NullBuffer*)Mem_Alloc(1, sizeof(struct NullBuffer), "null index buffer");
+	ib->size = indicesCount * 2;
+	ib->data = NULL;
+
+	GfxNullStats.IndexBuffers++;
+	GfxNullStats.BufferBytes += ib->size;
+	return (GfxResourceID)ib;
+}
+
+void Gfx_BindIb(GfxResourceID ib) { }
+
+void Gfx_DeleteIb(GfxResourceID* ib) {
+	struct NullBuffer* buffer = (struct NullBuffer*)(*ib);
+	if (!buffer) return;
+
+	GfxNullStats.IndexBuffers--;
+	GfxNullStats.BufferBytes -= buffer->size;
+	Mem_Free(buffer);
+	*ib = 0;
+}
+
+
+/*########################################################################################################################*
+*------------------------------------------------------Vertex buffers-----------------------------------------------------*
+*#########################################################################################################################*/
+static GfxResourceID CreateVertexBuffer(VertexFormat fmt, int count) {
+	struct NullBuffer* vb = (struct NullBuffer*)Mem_Alloc(1, sizeof(struct NullBuffer), "null vertex buffer");
+	vb->size = count * strideSizes[fmt];
+	/* Callers write vertices into the locked buffer, so memory must really exist */
+	vb->data = (cc_uint8*)Mem_Alloc(count, strideSizes[fmt], "null vertex buffer data");
+
+	GfxNullStats.VertexBuffers++;
+	GfxNullStats.BufferBytes += vb->size;
+	return (GfxResourceID)vb;
+}
+
+GfxResourceID Gfx_CreateVb(VertexFormat fmt, int count) { return CreateVertexBuffer(fmt, count); }
+void Gfx_BindVb(GfxResourceID vb) { }
+
+void Gfx_DeleteVb(GfxResourceID* vb) {
+	struct NullBuffer* buffer = (struct NullBuffer*)(*vb);
+	if (!buffer) return;
+
+	GfxNullStats.VertexBuffers--;
+	GfxNullStats.BufferBytes -= buffer->size;
+	Mem_Free(buffer->data);
+	Mem_Free(buffer);
+	*vb = 0;
+}
+
+static void* LockVertexBuffer(GfxResourceID vb, int size) {
+	struct NullBuffer* buffer = (struct NullBuffer*)vb;
+	if ((cc_uint32)size > buffer->size) {
+		Logger_Abort("Tried to lock more vertices than the vertex buffer holds");
+	}
+	return buffer->data;
+}
+
+void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	return LockVertexBuffer(vb, count * strideSizes[fmt]);
+}
+void Gfx_UnlockVb(GfxResourceID vb) { }
+
+
+/*########################################################################################################################*
+*--------------------------------------------------Dynamic vertex buffers-------------------------------------------------*
+*#########################################################################################################################*/
+GfxResourceID Gfx_CreateDynamicVb(VertexFormat fmt, int maxVertices) {
+	return CreateVertexBuffer(fmt, maxVertices);
+}
+
+void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	return LockVertexBuffer(vb, count * strideSizes[fmt]);
+}
+void Gfx_UnlockDynamicVb(GfxResourceID vb) { }
+
+void Gfx_SetDynamicVbData(GfxResourceID vb, void* vertices, int vCount) {
+	void* data = LockVertexBuffer(vb, vCount * gfx_stride);
+	Mem_Copy(data, vertices, vCount * gfx_stride);
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------------Drawing-------------------------------------------------------*
+*#########################################################################################################################*/
+void Gfx_SetVertexFormat(VertexFormat fmt) {
+	gfx_format = fmt;
+	gfx_stride = strideSizes[fmt];
+}
+
+static void CountDrawCall(int verticesCount) {
+	frameDrawCalls++;
+	frameVertices += verticesCount;
+}
+
+void Gfx_DrawVb_Lines(int verticesCount) { CountDrawCall(verticesCount); }
+void Gfx_DrawVb_IndexedTris(int verticesCount) { CountDrawCall(verticesCount); }
+
+void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	CountDrawCall(verticesCount);
+}
+void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	CountDrawCall(verticesCount);
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------------Matrices--------------------------------------------------------*
+*#########################################################################################################################*/
+void Gfx_LoadMatrix(MatrixType type, const struct Matrix* matrix) { }
+void Gfx_LoadIdentityMatrix(MatrixType type) { }
+void Gfx_EnableTextureOffset(float x, float y) { }
+void Gfx_DisableTextureOffset(void) { }
+
+void Gfx_CalcOrthoMatrix(float width, float height, struct Matrix* matrix) {
+	Matrix_Orthographic(matrix, 0.0f, width, 0.0f, height, ORTHO_NEAR, ORTHO_FAR);
+}
+void Gfx_CalcPerspectiveMatrix(float fov, float aspect, float zFar, struct Matrix* matrix) {
+	float zNear = 0.1f;
+	Matrix_PerspectiveFieldOfView(matrix, fov, aspect, zNear, zFar);
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------------Misc----------------------------------------------------------*
+*#########################################################################################################################*/
+cc_result Gfx_TakeScreenshot(struct Stream* output) {
+	struct Bitmap bmp;
+	cc_result res;
+	/* There is no backbuffer, so just save a blank image of the right size */
+	bmp.width  = Game.Width;
+	bmp.height = Game.Height;
+
+	bmp.scan0  = (BitmapCol*)Mem_TryAllocCleared(bmp.width * bmp.height, 4);
+	if (!bmp.scan0) return ERR_OUT_OF_MEMORY;
+
+	res = Png_Encode(&bmp, output, NULL, false);
+	Mem_Free(bmp.scan0);
+	return res;
+}
+
+cc_bool Gfx_WarnIfNecessary(void) { return false; }
+
+void Gfx_GetApiInfo(cc_string* info) {
+	int pointerSize = sizeof(void*) * 8;
+	float texMem = GfxNullStats.TextureBytes / (1024.0f * 1024.0f);
+	float bufMem = GfxNullStats.BufferBytes  / (1024.0f * 1024.0f);
+
+	String_Format1(info, "-- Using Null graphics (%i bit) --\n", &pointerSize);
+	String_Format2(info, "Textures: %i (%f2 MB)\n",   &GfxNullStats.Textures, &texMem);
+	String_Format3(info, "Buffers: %i vertex, %i index (%f2 MB)\n",
+		&GfxNullStats.VertexBuffers, &GfxNullStats.IndexBuffers, &bufMem);
+	String_Format2(info, "Last frame: %i draw calls, %i vertices\n",
+		&GfxNullStats.FrameDrawCalls, &GfxNullStats.FrameVertices);
+	String_Format2(info, "Max texture size: (%i, %i)\n", &Gfx.MaxTexWidth, &Gfx.MaxTexHeight);
+}
+
+void Gfx_SetFpsLimit(cc_bool vsync, float minFrameMs) {
+	gfx_minFrameMs = minFrameMs;
+	gfx_vsync      = vsync;
+}
+
+void Gfx_BeginFrame(void) { frameDrawCalls = 0; frameVertices = 0; }
+void Gfx_Clear(void) { }
+
+void Gfx_EndFrame(void) {
+	GfxNullStats.Frames++;
+	GfxNullStats.DrawCalls      += frameDrawCalls;
+	GfxNullStats.Vertices       += frameVertices;
+	GfxNullStats.FrameDrawCalls  = frameDrawCalls;
+	GfxNullStats.FrameVertices   = frameVertices;
+	if (gfx_minFrameMs) LimitFPS();
+}
+
+void Gfx_OnWindowResize(void) { }
+#endif
@@ -0,0 +1,877 @@
+#if defined __x86_64__ || defined _M_X64
+/* Included first, since C++ standard headers may #undef the min/max macros from Funcs.h */
+#include <emmintrin.h>
+#define SOFTGPU_SSE2
+#endif
+#include "Core.h"
+#if defined CC_BUILD_SOFTGPU
+#include "_GraphicsBase.h"
+#include "Errors.h"
+#include "Logger.h"
+#include "Window.h"
+#include "Jobs.h"
+/* Software rasterizer backend: renders triangles on the CPU into the window's framebuffer. */
+/* Draw calls are transformed and set up immediately, then binned into screen tiles. */
+/* When the frame is finished (or a texture in use changes), the tiles are rasterized on */
+/*  the job workers at once. Each tile draws its triangles in submission order, so the */
+/*  output does not depend on how many threads were used. */
+
+#define SOFTGPU_TILE_SHIFT 6
+#define SOFTGPU_TILE_SIZE  (1 << SOFTGPU_TILE_SHIFT)
+/* Pending triangles are flushed once this many have been queued */
+#define SOFTGPU_MAX_TRIS 65536
+
+#define STATE_ALPHA_TEST  0x01
+#define STATE_BLENDING    0x02
+#define STATE_DEPTH_TEST  0x04
+#define STATE_DEPTH_WRITE 0x08
+#define STATE_FOG         0x10
+
+struct SoftTexture { int width, height; BitmapCol* pixels; cc_bool pending; };
+struct SoftBuffer  { cc_uint32 size; cc_uint8* data; };
+
+/* Render state that triangles were drawn with */
+struct SoftState {
+	struct SoftTexture* tex; /* NULL when texturing is disabled */
+	int flags;
+	BitmapCol colMask;
+	float texOffsetX, texOffsetY;
+	int fogMode; float fogEnd, fogDensity;
+	int fogR, fogG, fogB;
+};
+
+/* Edge function of a triangle, calculated relative to the lower of its two vertices. */
+/* This ensures triangles sharing an edge calculate exactly negated values along it, */
+/*  so that pixels on the edge are never drawn twice or skipped. */
+struct SoftEdge { float x, y, dx, dy, sign; int inclusive; };
+/* value = c + dx * (px - x0) + dy * (py - y0) */
+struct SoftPlane { float c, dx, dy; };
+
+struct SoftTri {
+	int minX, minY, maxX, maxY, state;
+	float x0, y0;
+	struct SoftEdge edges[3];
+	struct SoftPlane z, invW, u, v, r, g, b, a;
+};
+
+struct SoftTile { int* tris; int count, capacity; };
+struct ClipVertex { float x, y, z, w, u, v, r, g, b, a; };
+struct ScreenVertex { float x, y, z, invW, u, v, r, g, b, a; };
+
+static struct Bitmap fb_bmp;
+static float* fb_depth;
+static struct SoftTile* tiles;
+static int tilesX, tilesY;
+
+static struct SoftTri* tris;
+static int trisCount, trisCapacity;
+static struct SoftState* states;
+static int statesCount, statesCapacity;
+
+static struct SoftState curState;
+static cc_bool stateDirty = true, texturing, depthTest, depthWrite = true;
+static cc_bool faceCulling, alphaTest, alphaBlend;
+static BitmapCol clearColor;
+static struct SoftTexture* boundTex;
+static struct SoftBuffer* boundVb;
+static struct SoftBuffer* boundIb;
+static int gfx_format = -1, gfx_stride;
+static struct Matrix _view, _proj, _mvp;
+
+static void InitFramebuffer(void);
+static void FreeFramebuffer(void);
+static void SoftGPU_Flush(void);
+
+void Gfx_Create(void) {
+	Gfx.MaxTexWidth  = 4096;
+	Gfx.MaxTexHeight = 4096;
+	Gfx.Created      = true;
+	Gfx.LostContext  = false;
+
+	curState.colMask = BITMAPCOL_RGB_MASK | BITMAPCOL_A_MASK;
+
+	InitFramebuffer();
+	Gfx_RestoreState();
+}
+
+cc_bool Gfx_TryRestoreContext(void) { return true; }
+
+void Gfx_Free(void) {
+	Gfx_FreeState();
+	FreeFramebuffer();
+}
+
+static void Gfx_FreeState(void) {
+	SoftGPU_Flush();
+	FreeDefaultResources();
+}
+static void Gfx_RestoreState(void) {
+	InitDefaultResources();
+	gfx_format = -1;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Framebuffer-------------------------------------------------------*
+*#########################################################################################################################*/
+static void InitFramebuffer(void) {
+	int width  = max(WindowInfo.Width,  1);
+	int height = max(WindowInfo.Height, 1);
+
+	fb_bmp.width  = width;
+	fb_bmp.height = height;
+	Window_AllocFramebuffer(&fb_bmp);
+	/* Rasterizer may read depth values just past the end of a row */
+	fb_depth = (float*)Mem_Alloc(width * height + 4, 4, "depth buffer");
+
+	tilesX = (width  + SOFTGPU_TILE_SIZE - 1) >> SOFTGPU_TILE_SHIFT;
+	tilesY = (height + SOFTGPU_TILE_SIZE - 1) >> SOFTGPU_TILE_SHIFT;
+	tiles  = (struct SoftTile*)Mem_AllocCleared(tilesX * tilesY, sizeof(struct SoftTile), "softgpu tiles");
+}
+
+static void FreeFramebuffer(void) {
+	int i;
+	for (i = 0; i < tilesX * tilesY; i++) { Mem_Free(tiles[i].tris); }
+	Mem_Free(tiles);
+	Mem_Free(fb_depth);
+	Window_FreeFramebuffer(&fb_bmp);
+
+	tiles    = NULL;
+	fb_depth = NULL;
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------------Textures--------------------------------------------------------*
+*#########################################################################################################################*/
+/* Flushes pending triangles if any of them are textured with the given texture */
+static void FlushTexture(struct SoftTexture* tex) {
+	if (tex->pending) SoftGPU_Flush();
+}
+
+static void CopyTexturePixels(struct SoftTexture* tex, int x, int y, struct Bitmap* part, int rowWidth) {
+	int row;
+	for (row = 0; row < part->height; row++) {
+		Mem_Copy(tex->pixels + (y + row) * tex->width + x, part->scan0 + row * rowWidth, part->width * 4);
+	}
+}
+
+GfxResourceID Gfx_CreateTexture(struct Bitmap* bmp, cc_uint8 flags, cc_bool mipmaps) {
+	struct SoftTexture* tex;
+	if (!Math_IsPowOf2(bmp->width) || !Math_IsPowOf2(bmp->height)) {
+		Logger_Abort("Textures must have power of two dimensions");
+	}
+	if (Gfx.LostContext) return 0;
+
+	/* Mipmaps are ignored, textures are always point sampled from the full size image */
+	tex = (struct SoftTexture*)Mem_Alloc(1, sizeof(struct SoftTexture), "softgpu texture");
+	tex->width   = bmp->width;
+	tex->height  = bmp->height;
+	tex->pending = false;
+	tex->pixels  = (BitmapCol*)Mem_Alloc(bmp->width * bmp->height, 4, "softgpu texture pixels");
+
+	CopyTexturePixels(tex, 0, 0, bmp, bmp->width);
+	return (GfxResourceID)tex;
+}
+
+void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, int rowWidth, cc_bool mipmaps) {
+	struct SoftTexture* tex = (struct SoftTexture*)texId;
+	if (!tex) return;
+	FlushTexture(tex);
+	CopyTexturePixels(tex, x, y, part, rowWidth);
+}
+
+void Gfx_UpdateTexturePart(GfxResourceID texId, int x, int y, struct Bitmap* part, cc_bool mipmaps) {
+	Gfx_UpdateTexture(texId, x, y, part, part->width, mipmaps);
+}
+
+void Gfx_DeleteTexture(GfxResourceID* texId) {
+	struct SoftTexture* tex = (struct SoftTexture*)(*texId);
+	if (!tex) return;
+
+	FlushTexture(tex);
+	if (boundTex == tex) { boundTex = NULL; stateDirty = true; }
+	Mem_Free(tex->pixels);
+	Mem_Free(tex);
+	*texId = 0;
+}
+
+void Gfx_BindTexture(GfxResourceID texId) {
+	boundTex   = (struct SoftTexture*)texId;
+	stateDirty = true;
+}
+void Gfx_SetTexturing(cc_bool enabled) { texturing = enabled; stateDirty = true; }
+void Gfx_EnableMipmaps(void)  { }
+void Gfx_DisableMipmaps(void) { }
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------State management----------------------------------------------------*
+*#########################################################################################################################*/
+#define SoftGPU_Toggle(var, value) var = value; stateDirty = true;
+
+void Gfx_SetFog(cc_bool enabled) { gfx_fogEnabled = enabled; stateDirty = true; }
+void Gfx_SetFogCol(PackedCol color) {
+	curState.fogR = PackedCol_R(color);
+	curState.fogG = PackedCol_G(color);
+	curState.fogB = PackedCol_B(color);
+	stateDirty = true;
+}
+void Gfx_SetFogDensity(float value) { SoftGPU_Toggle(curState.fogDensity, value); }
+void Gfx_SetFogEnd(float value)     { SoftGPU_Toggle(curState.fogEnd, value); }
+void Gfx_SetFogMode(FogFunc func)   { SoftGPU_Toggle(curState.fogMode, func); }
+
+void Gfx_SetFaceCulling(cc_bool enabled)   { faceCulling = enabled; }
+void Gfx_SetAlphaTest(cc_bool enabled)     { SoftGPU_Toggle(alphaTest, enabled); }
+void Gfx_SetAlphaBlending(cc_bool enabled) { SoftGPU_Toggle(alphaBlend, enabled); }
+void Gfx_SetAlphaArgBlend(cc_bool enabled) { }
+
+void Gfx_ClearCol(PackedCol color) {
+	clearColor = BitmapCol_Make(PackedCol_R(color), PackedCol_G(color), PackedCol_B(color), 255);
+}
+
+void Gfx_SetDepthTest(cc_bool enabled)  { SoftGPU_Toggle(depthTest,  enabled); }
+void Gfx_SetDepthWrite(cc_bool enabled) { SoftGPU_Toggle(depthWrite, enabled); }
+
+void Gfx_SetColWriteMask(cc_bool r, cc_bool g, cc_bool b, cc_bool a) {
+	curState.colMask = (r ? BITMAPCOL_R_MASK : 0) | (g ? BITMAPCOL_G_MASK : 0)
+					 | (b ? BITMAPCOL_B_MASK : 0) | (a ? BITMAPCOL_A_MASK : 0);
+	stateDirty = true;
+}
+
+/* Returns the index of the state that triangles are currently being drawn with */
+static int SoftGPU_CurrentState(void) {
+	struct SoftState* state;
+	if (!stateDirty && statesCount) return statesCount - 1;
+
+	if (statesCount == statesCapacity) {
+		statesCapacity = max(64, statesCapacity * 2);
+		states = (struct SoftState*)Mem_Realloc(states, statesCapacity, sizeof(struct SoftState), "softgpu states");
+	}
+	state  = &states[statesCount++];
+	*state = curState;
+
+	state->tex   = texturing ? boundTex : NULL;
+	state->flags = 0;
+	if (alphaTest)      state->flags |= STATE_ALPHA_TEST;
+	if (alphaBlend)     state->flags |= STATE_BLENDING;
+	if (depthTest)      state->flags |= STATE_DEPTH_TEST;
+	if (depthWrite)     state->flags |= STATE_DEPTH_WRITE;
+	if (gfx_fogEnabled) state->flags |= STATE_FOG;
+
+	if (state->tex) state->tex->pending = true;
+	stateDirty = false;
+	return statesCount - 1;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Index buffers-----------------------------------------------------*
+*#########################################################################################################################*/
+static struct SoftBuffer* CreateBuffer(int size, const char* place) {
+	struct SoftBuffer* buffer = (struct SoftBuffer*)Mem_Alloc(1, sizeof(struct SoftBuffer), place);
+	buffer->size = size;
+	buffer->data = (cc_uint8*)Mem_Alloc(size, 1, place);
+	return buffer;
+}
+
+static void DeleteBuffer(GfxResourceID* id) {
+	struct SoftBuffer* buffer = (struct SoftBuffer*)(*id);
+	if (!buffer) return;
+
+	if (boundVb == buffer) boundVb = NULL;
+	if (boundIb == buffer) boundIb = NULL;
+	Mem_Free(buffer->data);
+	Mem_Free(buffer);
+	*id = 0;
+}
+
+GfxResourceID Gfx_CreateIb(void* indices, int indicesCount) {
+	struct SoftBuffer* ib = CreateBuffer(indicesCount * 2, "softgpu index buffer");
+	Mem_Copy(ib->data, indices, indicesCount * 2);
+	return (GfxResourceID)ib;
+}
+
+void Gfx_BindIb(GfxResourceID ib)    { boundIb = (struct SoftBuffer*)ib; }
+void Gfx_DeleteIb(GfxResourceID* ib) { DeleteBuffer(ib); }
+
+
+/*########################################################################################################################*
+*------------------------------------------------------Vertex buffers-----------------------------------------------------*
+*#########################################################################################################################*/
+GfxResourceID Gfx_CreateVb(VertexFormat fmt, int count) {
+	return (GfxResourceID)CreateBuffer(count * strideSizes[fmt], "softgpu vertex buffer");
+}
+
+void Gfx_BindVb(GfxResourceID vb)    { boundVb = (struct SoftBuffer*)vb; }
+void Gfx_DeleteVb(GfxResourceID* vb) { DeleteBuffer(vb); }
+
+/* Triangles are set up when drawn, so buffers can always be modified immediately */
+void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	return ((struct SoftBuffer*)vb)->data;
+}
+void Gfx_UnlockVb(GfxResourceID vb) { }
+
+
+/*########################################################################################################################*
+*--------------------------------------------------Dynamic vertex buffers-------------------------------------------------*
+*#########################################################################################################################*/
+GfxResourceID Gfx_CreateDynamicVb(VertexFormat fmt, int maxVertices) {
+	return Gfx_CreateVb(fmt, maxVertices);
+}
+
+void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	return ((struct SoftBuffer*)vb)->data;
+}
+
+void Gfx_UnlockDynamicVb(GfxResourceID vb) { Gfx_BindVb(vb); }
+
+void Gfx_SetDynamicVbData(GfxResourceID vb, void* vertices, int vCount) {
+	Mem_Copy(((struct SoftBuffer*)vb)->data, vertices, vCount * gfx_stride);
+	Gfx_BindVb(vb);
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------------Matrices--------------------------------------------------------*
+*#########################################################################################################################*/
+void Gfx_LoadMatrix(MatrixType type, const struct Matrix* matrix) {
+	if (type == MATRIX_VIEW)       _view = *matrix;
+	if (type == MATRIX_PROJECTION) _proj = *matrix;
+	Matrix_Mul(&_mvp, &_view, &_proj);
+}
+
+void Gfx_LoadIdentityMatrix(MatrixType type) {
+	Gfx_LoadMatrix(type, &Matrix_Identity);
+}
+
+void Gfx_EnableTextureOffset(float x, float y) {
+	curState.texOffsetX = x;
+	curState.texOffsetY = y;
+	stateDirty = true;
+}
+void Gfx_DisableTextureOffset(void) { Gfx_EnableTextureOffset(0, 0); }
+
+void Gfx_CalcOrthoMatrix(float width, float height, struct Matrix* matrix) {
+	Matrix_Orthographic(matrix, 0.0f, width, 0.0f, height, ORTHO_NEAR, ORTHO_FAR);
+}
+void Gfx_CalcPerspectiveMatrix(float fov, float aspect, float zFar, struct Matrix* matrix) {
+	float zNear = 0.1f;
+	Matrix_PerspectiveFieldOfView(matrix, fov, aspect, zNear, zFar);
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Triangle setup-------------------------------------------------------*
+*#########################################################################################################################*/
+static struct ClipVertex* clipVertices;
+static int clipVerticesCapacity;
+
+static void TransformVertices(int startVertex, int count) {
+	const struct Matrix* m = &_mvp;
+	struct ClipVertex* dst;
+	cc_uint8* src;
+	PackedCol col;
+	float x, y, z;
+	int i;
+
+	if (count > clipVerticesCapacity) {
+		clipVerticesCapacity = count;
+		clipVertices = (struct ClipVertex*)Mem_Realloc(clipVertices, count, sizeof(struct ClipVertex), "softgpu vertices");
+	}
+	src = boundVb->data + startVertex * gfx_stride;
+	dst = clipVertices;
+
+	for (i = 0; i < count; i++, src += gfx_stride, dst++) {
+		/* Both vertex formats start with position, then colour */
+		const struct VertexColoured* v = (const struct VertexColoured*)src;
+		x = v->X; y = v->Y; z = v->Z; col = v->Col;
+
+		dst->x = x * m->row1.X + y * m->row2.X + z * m->row3.X + m->row4.X;
+		dst->y = x * m->row1.Y + y * m->row2.Y + z * m->row3.Y + m->row4.Y;
+		dst->z = x * m->row1.Z + y * m->row2.Z + z * m->row3.Z + m->row4.Z;
+		dst->w = x * m->row1.W + y * m->row2.W + z * m->row3.W + m->row4.W;
+
+		dst->r = PackedCol_R(col); dst->g = PackedCol_G(col);
+		dst->b = PackedCol_B(col); dst->a = PackedCol_A(col);
+
+		if (gfx_format == VERTEX_FORMAT_TEXTURED) {
+			const struct VertexTextured* vt = (const struct VertexTextured*)src;
+			dst->u = vt->U; dst->v = vt->V;
+		} else {
+			dst->u = 0; dst->v = 0;
+		}
+	}
+}
+
+static void Project(const struct ClipVertex* src, struct ScreenVertex* dst) {
+	float invW = 1.0f / src->w;
+	dst->x    = (src->x * invW + 1.0f) * 0.5f * fb_bmp.width;
+	dst->y    = (1.0f - src->y * invW) * 0.5f * fb_bmp.height;
+	dst->z    = src->z * invW * 0.5f + 0.5f;
+	dst->invW = invW;
+	dst->u    = src->u * invW;
+	dst->v    = src->v * invW;
+
+	dst->r = src->r; dst->g = src->g; dst->b = src->b; dst->a = src->a;
+}
+
+/* Orders vertices by Y, then by X */
+#define Vertex_Less(a, b) ((a)->y < (b)->y || ((a)->y == (b)->y && (a)->x < (b)->x))
+
+static void SetupEdge(struct SoftEdge* e, const struct ScreenVertex* a, const struct ScreenVertex* b) {
+	const struct ScreenVertex* ref   = a;
+	const struct ScreenVertex* other = b;
+	e->sign = 1.0f;
+	if (!Vertex_Less(a, b)) { ref = b; other = a; e->sign = -1.0f; }
+
+	e->x  = ref->x;            e->y  = ref->y;
+	e->dx = other->x - ref->x; e->dy = other->y - ref->y;
+	/* Only one of the two triangles sharing this edge should draw pixels exactly on it */
+	e->inclusive = b->y > a->y || (b->y == a->y && b->x < a->x);
+}
+
+static void SetupPlane(struct SoftPlane* p, float a0, float a1, float a2,
+						const struct ScreenVertex* v0, const struct ScreenVertex* v1, const struct ScreenVertex* v2, float invArea) {
+	p->c  = a0;
+	p->dx = ((a1 - a0) * (v2->y - v0->y) - (a2 - a0) * (v1->y - v0->y)) * invArea;
+	p->dy = ((a2 - a0) * (v1->x - v0->x) - (a1 - a0) * (v2->x - v0->x)) * invArea;
+}
+#define SetupPlaneOf(plane, attr) SetupPlane(&t->plane, v0->attr, v1->attr, v2->attr, v0, v1, v2, invArea)
+
+static void BinTriangle(int index) {
+	struct SoftTri* t = &tris[index];
+	struct SoftTile* tile;
+	int x1 = t->minX >> SOFTGPU_TILE_SHIFT, x2 = t->maxX >> SOFTGPU_TILE_SHIFT;
+	int y1 = t->minY >> SOFTGPU_TILE_SHIFT, y2 = t->maxY >> SOFTGPU_TILE_SHIFT;
+	int x, y;
+
+	for (y = y1; y <= y2; y++) {
+		for (x = x1; x <= x2; x++) {
+			tile = &tiles[y * tilesX + x];
+			if (tile->count == tile->capacity) {
+				tile->capacity = max(256, tile->capacity * 2);
+				tile->tris = (int*)Mem_Realloc(tile->tris, tile->capacity, 4, "softgpu tile");
+			}
+			tile->tris[tile->count++] = index;
+		}
+	}
+}
+
+static void SetupTriangle(const struct ScreenVertex* v0, const struct ScreenVertex* v1, const struct ScreenVertex* v2, cc_bool cull) {
+	const struct ScreenVertex* tmp;
+	struct SoftTri* t;
+	float area, invArea;
+	float minX, minY, maxX, maxY;
+
+	area = (v1->x - v0->x) * (v2->y - v0->y) - (v2->x - v0->x) * (v1->y - v0->y);
+	if (area == 0.0f || area != area) return;
+	/* Screen Y is flipped compared to OpenGL, so front (anticlockwise) faces have negative area */
+	if (area > 0.0f && cull) return;
+	if (area < 0.0f) { tmp = v1; v1 = v2; v2 = tmp; area = -area; }
+
+	minX = min(v0->x, min(v1->x, v2->x)); maxX = max(v0->x, max(v1->x, v2->x));
+	minY = min(v0->y, min(v1->y, v2->y)); maxY = max(v0->y, max(v1->y, v2->y));
+	/* Pixels are sampled at their centres */
+	minX = max(minX - 0.5f, 0.0f); maxX = min(maxX - 0.5f, (float)(fb_bmp.width  - 1));
+	minY = max(minY - 0.5f, 0.0f); maxY = min(maxY - 0.5f, (float)(fb_bmp.height - 1));
+	if (minX > maxX || minY > maxY) return;
+
+	if (trisCount == SOFTGPU_MAX_TRIS) SoftGPU_Flush();
+	if (trisCount == trisCapacity) {
+		trisCapacity = min(SOFTGPU_MAX_TRIS, max(1024, trisCapacity * 2));
+		tris = (struct SoftTri*)Mem_Realloc(tris, trisCapacity, sizeof(struct SoftTri), "softgpu triangles");
+	}
+	t = &tris[trisCount];
+
+	t->minX  = (int)Math_Ceil(minX);  t->maxX = (int)maxX;
+	t->minY  = (int)Math_Ceil(minY);  t->maxY = (int)maxY;
+	if (t->minX > t->maxX || t->minY > t->maxY) return;
+	t->state = SoftGPU_CurrentState();
+
+	SetupEdge(&t->edges[0], v0, v1);
+	SetupEdge(&t->edges[1], v1, v2);
+	SetupEdge(&t->edges[2], v2, v0);
+
+	invArea = 1.0f / area;
+	t->x0   = v0->x; t->y0 = v0->y;
+	SetupPlaneOf(z, z);    SetupPlaneOf(invW, invW);
+	SetupPlaneOf(u, u);    SetupPlaneOf(v, v);
+	SetupPlaneOf(r, r);    SetupPlaneOf(g, g);
+	SetupPlaneOf(b, b);    SetupPlaneOf(a, a);
+
+	BinTriangle(trisCount++);
+}
+
+/* Returns signed distance of a vertex to the near clipping plane (z = -w) */
+#define NearDist(v) ((v)->z + (v)->w)
+#define CLIP_MAX_VERTICES 4
+
+static void ClipIntersect(const struct ClipVertex* in, const struct ClipVertex* out, struct ClipVertex* dst) {
+	/* Always interpolate from inside to outside vertex, so the new vertex does not */
+	/*  depend on which of the two triangles sharing the edge is being clipped */
+	float dIn = NearDist(in), dOut = NearDist(out);
+	float t   = dIn / (dIn - dOut);
+
+	dst->x = in->x + (out->x - in->x) * t; dst->y = in->y + (out->y - in->y) * t;
+	dst->z = in->z + (out->z - in->z) * t; dst->w = in->w + (out->w - in->w) * t;
+	dst->u = in->u + (out->u - in->u) * t; dst->v = in->v + (out->v - in->v) * t;
+	dst->r = in->r + (out->r - in->r) * t; dst->g = in->g + (out->g - in->g) * t;
+	dst->b = in->b + (out->b - in->b) * t; dst->a = in->a + (out->a - in->a) * t;
+}
+
+/* Clips the polygon against the near plane, returning number of vertices left */
+static int ClipNear(const struct ClipVertex** src, int count, struct ClipVertex* dst) {
+	const struct ClipVertex* cur;
+	const struct ClipVertex* next;
+	int i, n = 0;
+
+	for (i = 0; i < count; i++) {
+		cur  = src[i];
+		next = src[(i + 1) % count];
+
+		if (NearDist(cur) >= 0.0f) dst[n++] = *cur;
+		if ((NearDist(cur) >= 0.0f) != (NearDist(next) >= 0.0f)) {
+			if (NearDist(cur) >= 0.0f) ClipIntersect(cur, next, &dst[n++]);
+			else                       ClipIntersect(next, cur, &dst[n++]);
+		}
+	}
+	return n;
+}
+
+/* Whether all the vertices are outside the same side of the view frustum */
+static cc_bool TriangleOffscreen(const struct ClipVertex* a, const struct ClipVertex* b, const struct ClipVertex* c) {
+	if (a->x >  a->w && b->x >  b->w && c->x >  c->w) return true;
+	if (a->x < -a->w && b->x < -b->w && c->x < -c->w) return true;
+	if (a->y >  a->w && b->y >  b->w && c->y >  c->w) return true;
+	if (a->y < -a->w && b->y < -b->w && c->y < -c->w) return true;
+	if (a->z >  a->w && b->z >  b->w && c->z >  c->w) return true;
+	return NearDist(a) < 0.0f && NearDist(b) < 0.0f && NearDist(c) < 0.0f;
+}
+
+static void DrawTriangle(const struct ClipVertex* a, const struct ClipVertex* b, const struct ClipVertex* c) {
+	struct ClipVertex clipped[CLIP_MAX_VERTICES];
+	struct ScreenVertex screen[CLIP_MAX_VERTICES];
+	const struct ClipVertex* verts[3];
+	int i, count;
+
+	if (TriangleOffscreen(a, b, c)) return;
+	verts[0] = a; verts[1] = b; verts[2] = c;
+
+	if (NearDist(a) >= 0.0f && NearDist(b) >= 0.0f && NearDist(c) >= 0.0f) {
+		for (i = 0; i < 3; i++) Project(verts[i], &screen[i]);
+		count = 3;
+	} else {
+		count = ClipNear(verts, 3, clipped);
+		for (i = 0; i < count; i++) Project(&clipped[i], &screen[i]);
+	}
+
+	for (i = 2; i < count; i++) {
+		SetupTriangle(&screen[0], &screen[i - 1], &screen[i], faceCulling);
+	}
+}
+
+static void DrawLine(const struct ClipVertex* a, const struct ClipVertex* b) {
+	struct ScreenVertex quad[4];
+	float dx, dy, len;
+	int i;
+	/* Lines are only used for debugging/selection outlines, so simply skip any that cross near plane */
+	if (NearDist(a) < 0.0f || NearDist(b) < 0.0f) return;
+
+	Project(a, &quad[0]); Project(a, &quad[1]);
+	Project(b, &quad[2]); Project(b, &quad[3]);
+
+	dx  = quad[2].x - quad[0].x; dy = quad[2].y - quad[0].y;
+	len = Math_SqrtF(dx * dx + dy * dy);
+	if (len == 0.0f) return;
+	/* Expand line into a 1 pixel wide quad */
+	dx *= 0.5f / len; dy *= 0.5f / len;
+
+	for (i = 0; i < 4; i++) {
+		float side = (i == 0 || i == 3) ? 1.0f : -1.0f;
+		quad[i].x -= dy * side;
+		quad[i].y += dx * side;
+	}
+	SetupTriangle(&quad[0], &quad[1], &quad[2], false);
+	SetupTriangle(&quad[2], &quad[3], &quad[0], false);
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Rasterizing-------------------------------------------------------*
+*#########################################################################################################################*/
+#define SoftGPU_Floor(v) ((int)(v) - ((v) < (float)(int)(v)))
+#define SoftGPU_Clamp255(v) ((v) <= 0.0f ? 0 : ((v) >= 255.0f ? 255 : (int)(v)))
+#define PlaneAt(p, ex, ey) ((p).c + (p).dx * (ex) + (p).dy * (ey))
+
+/* Shades a pixel that is inside the triangle, and passed the depth test */
+static void ShadePixel(const struct SoftTri* t, const struct SoftState* s, int x, int y, float z) {
+	int index = y * fb_bmp.width + x;
+	float ex  = (x + 0.5f) - t->x0, ey = (y + 0.5f) - t->y0;
+	float invW, w, f;
+	int r, g, b, a, tx, ty;
+	BitmapCol src, dst;
+
+	r = SoftGPU_Clamp255(PlaneAt(t->r, ex, ey));
+	g = SoftGPU_Clamp255(PlaneAt(t->g, ex, ey));
+	b = SoftGPU_Clamp255(PlaneAt(t->b, ex, ey));
+	a = SoftGPU_Clamp255(PlaneAt(t->a, ex, ey));
+	invW = PlaneAt(t->invW, ex, ey);
+	w    = 1.0f / invW;
+
+	if (s->tex) {
+		float u = PlaneAt(t->u, ex, ey) * w + s->texOffsetX;
+		float v = PlaneAt(t->v, ex, ey) * w + s->texOffsetY;
+		u *= s->tex->width; v *= s->tex->height;
+
+		tx  = SoftGPU_Floor(u) & (s->tex->width  - 1);
+		ty  = SoftGPU_Floor(v) & (s->tex->height - 1);
+		src = s->tex->pixels[ty * s->tex->width + tx];
+
+		r = r * BitmapCol_R(src) / 255; g = g * BitmapCol_G(src) / 255;
+		b = b * BitmapCol_B(src) / 255; a = a * BitmapCol_A(src) / 255;
+	}
+	if ((s->flags & STATE_ALPHA_TEST) && a < 128) return;
+
+	if (s->flags & STATE_FOG) {
+		/* Same fog calculation as the OpenGL modern backend */
+		float depth = z * w;
+		if (s->fogMode == FOG_LINEAR) {
+			f = (s->fogEnd - depth) / s->fogEnd;
+		} else {
+			f = (float)Math_Exp(-s->fogDensity * depth);
+		}
+		Math_Clamp(f, 0.0f, 1.0f);
+
+		r = (int)(s->fogR + (r - s->fogR) * f);
+		g = (int)(s->fogG + (g - s->fogG) * f);
+		b = (int)(s->fogB + (b - s->fogB) * f);
+	}
+
+	dst = fb_bmp.scan0[index];
+	if (s->flags & STATE_BLENDING) {
+		r = (r * a + BitmapCol_R(dst) * (255 - a)) / 255;
+		g = (g * a + BitmapCol_G(dst) * (255 - a)) / 255;
+		b = (b * a + BitmapCol_B(dst) * (255 - a)) / 255;
+		a = (a * a + BitmapCol_A(dst) * (255 - a)) / 255;
+	}
+
+	src = BitmapCol_Make(r, g, b, a);
+	fb_bmp.scan0[index] = (src & s->colMask) | (dst & ~s->colMask);
+	if ((s->flags & (STATE_DEPTH_TEST | STATE_DEPTH_WRITE)) == (STATE_DEPTH_TEST | STATE_DEPTH_WRITE)) {
+		fb_depth[index] = z;
+	}
+}
+
+#ifdef SOFTGPU_SSE2
+/* Evaluates edges and depth for 4 pixels at a time */
+static void RasterTriangle(const struct SoftTri* t, const struct SoftState* s, int x1, int y1, int x2, int y2) {
+	float zs[4];
+	int x, y, i, mask, lanes;
+	__m128 px, py, ex, ey, e, z, inside;
+	__m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+	__m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+	cc_bool depthTest = s->flags & STATE_DEPTH_TEST;
+
+	for (y = y1; y <= y2; y++) {
+		py = _mm_set1_ps(y + 0.5f);
+		ey = _mm_set1_ps((y + 0.5f) - t->y0);
+
+		for (x = x1; x <= x2; x += 4) {
+			px = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+			inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+			for (i = 0; i < 3; i++) {
+				const struct SoftEdge* edge = &t->edges[i];
+				e = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(edge->dx), _mm_sub_ps(py, _mm_set1_ps(edge->y))),
+							   _mm_mul_ps(_mm_set1_ps(edge->dy), _mm_sub_ps(px, _mm_set1_ps(edge->x))));
+				e = _mm_mul_ps(e, _mm_set1_ps(edge->sign));
+				inside = _mm_and_ps(inside, edge->inclusive ? _mm_cmpge_ps(e, zero) : _mm_cmpgt_ps(e, zero));
+			}
+
+			ex = _mm_sub_ps(px, _mm_set1_ps(t->x0));
+			z  = _mm_add_ps(_mm_add_ps(_mm_set1_ps(t->z.c), _mm_mul_ps(_mm_set1_ps(t->z.dx), ex)),
+							_mm_mul_ps(_mm_set1_ps(t->z.dy), ey));
+			inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(z, zero), _mm_cmple_ps(z, one)));
+			if (depthTest) {
+				inside = _mm_and_ps(inside, _mm_cmple_ps(z, _mm_loadu_ps(&fb_depth[y * fb_bmp.width + x])));
+			}
+
+			lanes = min(4, x2 - x + 1);
+			mask  = _mm_movemask_ps(inside) & ((1 << lanes) - 1);
+			if (!mask) continue;
+
+			_mm_storeu_ps(zs, z);
+			for (i = 0; i < 4; i++) {
+				if (mask & (1 << i)) ShadePixel(t, s, x + i, y, zs[i]);
+			}
+		}
+	}
+}
+#else
+static void RasterTriangle(const struct SoftTri* t, const struct SoftState* s, int x1, int y1, int x2, int y2) {
+	float px, py, e, z;
+	int x, y, i;
+	cc_bool depthTest = s->flags & STATE_DEPTH_TEST;
+
+	for (y = y1; y <= y2; y++) {
+		py = y + 0.5f;
+		for (x = x1; x <= x2; x++) {
+			px = x + 0.5f;
+
+			for (i = 0; i < 3; i++) {
+				const struct SoftEdge* edge = &t->edges[i];
+				e = (edge->dx * (py - edge->y) - edge->dy * (px - edge->x)) * edge->sign;
+				if (edge->inclusive ? e < 0.0f : e <= 0.0f) break;
+			}
+			if (i < 3) continue;
+
+			z = t->z.c + t->z.dx * (px - t->x0) + t->z.dy * (py - t->y0);
+			if (z < 0.0f || z > 1.0f) continue;
+			if (depthTest && z > fb_depth[y * fb_bmp.width + x]) continue;
+			ShadePixel(t, s, x, y, z);
+		}
+	}
+}
+#endif
+
+static void RasterTile(int index) {
+	struct SoftTile* tile = &tiles[index];
+	const struct SoftTri* t;
+	int x1 = (index % tilesX) << SOFTGPU_TILE_SHIFT;
+	int y1 = (index / tilesX) << SOFTGPU_TILE_SHIFT;
+	int x2 = min(x1 + SOFTGPU_TILE_SIZE, fb_bmp.width)  - 1;
+	int y2 = min(y1 + SOFTGPU_TILE_SIZE, fb_bmp.height) - 1;
+	int i;
+
+	for (i = 0; i < tile->count; i++) {
+		t = &tris[tile->tris[i]];
+		RasterTriangle(t, &states[t->state], max(x1, t->minX), max(y1, t->minY),
+												min(x2, t->maxX), min(y2, t->maxY));
+	}
+	tile->count = 0;
+}
+
+static void RasterTiles(void* obj, int beg, int end) {
+	int i;
+	for (i = beg; i < end; i++) RasterTile(i);
+}
+
+/* Rasterizes all the pending triangles */
+static void SoftGPU_Flush(void) {
+	int i;
+	if (!trisCount) return;
+
+	/* Main thread rasterizes tiles too */
+	Jobs_ParallelFor(tilesX * tilesY, 1, RasterTiles, NULL);
+
+	for (i = 0; i < statesCount; i++) {
+		if (states[i].tex) states[i].tex->pending = false;
+	}
+	trisCount   = 0;
+	statesCount = 0;
+	stateDirty  = true;
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------------Drawing-------------------------------------------------------*
+*#########################################################################################################################*/
+void Gfx_SetVertexFormat(VertexFormat fmt) {
+	if (fmt == gfx_format) return;
+	gfx_format = fmt;
+	gfx_stride = strideSizes[fmt];
+}
+
+void Gfx_DrawVb_Lines(int verticesCount) {
+	int i;
+	if (!boundVb) return;
+	TransformVertices(0, verticesCount);
+
+	for (i = 0; i + 1 < verticesCount; i += 2) {
+		DrawLine(&clipVertices[i], &clipVertices[i + 1]);
+	}
+}
+
+void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	cc_uint16* indices;
+	int i, i0, i1, i2, count = ICOUNT(verticesCount);
+	if (!boundVb || !boundIb) return;
+
+	TransformVertices(startVertex, verticesCount);
+	indices = (cc_uint16*)boundIb->data;
+
+	for (i = 0; i + 2 < count; i += 3) {
+		i0 = indices[i + 0]; i1 = indices[i + 1]; i2 = indices[i + 2];
+		if (i0 >= verticesCount || i1 >= verticesCount || i2 >= verticesCount) continue;
+		DrawTriangle(&clipVertices[i0], &clipVertices[i1], &clipVertices[i2]);
+	}
+}
+
+void Gfx_DrawVb_IndexedTris(int verticesCount) {
+	Gfx_DrawVb_IndexedTris_Range(verticesCount, 0);
+}
+
+void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	Gfx_DrawVb_IndexedTris_Range(verticesCount, startVertex);
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------------Misc----------------------------------------------------------*
+*#########################################################################################################################*/
+cc_result Gfx_TakeScreenshot(struct Stream* output) {
+	SoftGPU_Flush();
+	return Png_Encode(&fb_bmp, output, NULL, false);
+}
+
+cc_bool Gfx_WarnIfNecessary(void) { return false; }
+
+void Gfx_GetApiInfo(cc_string* info) {
+	int pointerSize = sizeof(void*) * 8, threads;
+	String_Format1(info, "-- Using software rasterizer (%i bit) --\n", &pointerSize);
+	threads = Jobs_WorkerCount + 1;
+	String_Format1(info, "Threads: %i\n", &threads);
+	String_Format2(info, "Framebuffer size: (%i, %i)\n", &fb_bmp.width, &fb_bmp.height);
+	String_Format2(info, "Max texture size: (%i, %i)\n", &Gfx.MaxTexWidth, &Gfx.MaxTexHeight);
+}
+
+void Gfx_SetFpsLimit(cc_bool vsync, float minFrameMs) {
+	gfx_minFrameMs = minFrameMs;
+	gfx_vsync      = vsync;
+}
+
+void Gfx_BeginFrame(void) { }
+
+void Gfx_Clear(void) {
+	int i, count = fb_bmp.width * fb_bmp.height;
+	SoftGPU_Flush();
+
+	for (i = 0; i < count; i++) {
+		fb_bmp.scan0[i] = clearColor;
+		fb_depth[i]     = 1.0f;
+	}
+}
+
+void Gfx_EndFrame(void) {
+	Rect2D r;
+	SoftGPU_Flush();
+
+	r.X = 0; r.Width  = fb_bmp.width;
+	r.Y = 0; r.Height = fb_bmp.height;
+	Window_DrawFramebuffer(r);
+
+	if (Window_IsObscured()) {
+		TickReducedPerformance();
+	} else {
+		EndReducedPerformance();
+	}
+	if (gfx_minFrameMs) LimitFPS();
+}
+
+void Gfx_OnWindowResize(void) {
+	SoftGPU_Flush();
+	FreeFramebuffer();
+	InitFramebuffer();
+}
+#endif
@@ -227,6 +227,9 @@ void HeldBlockRenderer_Render(double delta) {
 	Gfx_LoadMatrix(MATRIX_PROJECTION, &Gfx.Projection);
 }
 
+/* Cached vertices of held block depend on block definitions and the terrain atlas */
+static void FreeHeldCache(void* obj) { Model_FreeCache(&held_entity); }
+
 static const struct EntityVTABLE heldEntity_VTABLE = {
 	NULL, NULL, NULL, HeldBlockRenderer_GetCol,
 	NULL, NULL
@@ -242,8 +245,13 @@ static void OnInit(void) {
 	Event_Register_(&GfxEvents.ProjectionChanged, NULL, OnProjectionChanged);
 	Event_Register_(&UserEvents.HeldBlockChanged, NULL, DoSwitchBlockAnim);
 	Event_Register_(&UserEvents.BlockChanged,     NULL, OnBlockChanged);
+	Event_Register_(&BlockEvents.BlockDefChanged, NULL, FreeHeldCache);
+	Event_Register_(&TextureEvents.AtlasChanged,  NULL, FreeHeldCache);
 }
 
+static void OnFree(void) { Model_FreeCache(&held_entity); }
+
 struct IGameComponent HeldBlockRenderer_Component = {
-	OnInit /* Init  */
+	OnInit, /* Init  */
+	OnFree  /* Free  */
 };
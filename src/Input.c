@@ -659,17 +659,18 @@ static cc_bool PushbackPlace(struct AABB* blockBB) {
 
 static cc_bool IntersectsOthers(Vec3 pos, BlockID block) {
 	struct AABB blockBB, entityBB;
-	struct Entity* e;
-	int id;
+	EntityID ids[ENTITIES_MAX_COUNT];
+	int i, slot, count;
 
 	Vec3_Add(&blockBB.Min, &pos, &Blocks.MinBB[block]);
 	Vec3_Add(&blockBB.Max, &pos, &Blocks.MaxBB[block]);
+	count = Entities_QueryBox(&blockBB, ids);
 	
-	for (id = 0; id < ENTITIES_SELF_ID; id++) {
-		e = Entities.List[id];
-		if (!e) continue;
+	for (i = 0; i < count; i++) {
+		slot = EntityTable.Slots[ids[i]];
+		if (ids[i] == ENTITIES_SELF_ID || slot < 0) continue;
 
-		Entity_GetBounds(e, &entityBB);
+		entityBB = EntityTable.Bounds[slot];
 		entityBB.Min.Y += 1.0f / 32.0f; /* when player is exactly standing on top of ground */
 		if (AABB_Intersects(&entityBB, &blockBB)) return true;
 	}
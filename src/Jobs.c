@@ -0,0 +1,343 @@
+#include "Jobs.h"
+#include "Platform.h"
+#include "Funcs.h"
+#include "Game.h"
+#include "Options.h"
+#include "Logger.h"
+
+#define JOBS_MAX_WORKERS 16
+#define JOBS_DEF_QUEUE_CAPACITY 64
+int Jobs_WorkerCount;
+
+/* Ring buffer of jobs. The owning worker takes the newest job from the end of its queue, */
+/*  while other workers steal the oldest job from the start of the queue. */
+struct JobQueue {
+	void* mutex;
+	struct Job** jobs;
+	int head, count, capacity;
+};
+/* One queue per worker, followed by a shared queue for jobs submitted from non-worker threads */
+static struct JobQueue jobs_queues[JOBS_MAX_WORKERS + 1];
+#define JOBS_SHARED_QUEUE Jobs_WorkerCount
+static void* jobs_threads[JOBS_MAX_WORKERS];
+
+/* Number of jobs across all of the queues */
+static volatile int jobs_queued;
+static volatile int jobs_nextWorker, jobs_quit;
+/* Signalled when a job is queued, and when a job has finished */
+static void* jobs_workWaitable;
+static void* jobs_doneWaitable;
+
+/* Jobs which have finished running, but still need Completed called on the main thread */
+static void* completed_mutex;
+static struct Job* completed_head;
+static struct Job* completed_tail;
+
+
+/*########################################################################################################################*
+*---------------------------------------------------------Job queue-------------------------------------------------------*
+*#########################################################################################################################*/
+static void JobQueue_Resize(struct JobQueue* q) {
+	struct Job** jobs;
+	int i, capacity = max(JOBS_DEF_QUEUE_CAPACITY, q->capacity * 2);
+
+	jobs = (struct Job**)Mem_Alloc(capacity, sizeof(struct Job*), "job queue");
+	for (i = 0; i < q->count; i++) {
+		jobs[i] = q->jobs[(q->head + i) & (q->capacity - 1)];
+	}
+
+	Mem_Free(q->jobs);
+	q->jobs     = jobs;
+	q->head     = 0;
+	q->capacity = capacity;
+}
+
+static void JobQueue_Push(struct JobQueue* q, struct Job* job) {
+	Mutex_Lock(q->mutex);
+	{
+		if (q->count == q->capacity) JobQueue_Resize(q);
+		q->jobs[(q->head + q->count) & (q->capacity - 1)] = job;
+		q->count++;
+	}
+	Mutex_Unlock(q->mutex);
+}
+
+static struct Job* JobQueue_Take(struct JobQueue* q, cc_bool newest) {
+	struct Job* job = NULL;
+	Mutex_Lock(q->mutex);
+
+	if (q->count && newest) {
+		q->count--;
+		job = q->jobs[(q->head + q->count) & (q->capacity - 1)];
+	} else if (q->count) {
+		q->count--;
+		job     = q->jobs[q->head];
+		q->head = (q->head + 1) & (q->capacity - 1);
+	}
+
+	Mutex_Unlock(q->mutex);
+	return job;
+}
+
+static void JobQueue_Free(struct JobQueue* q) {
+	Mutex_Free(q->mutex);
+	Mem_Free(q->jobs);
+
+	q->mutex = NULL;
+	q->jobs  = NULL;
+	q->head  = 0; q->count = 0; q->capacity = 0;
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------Job running------------------------------------------------------*
+*#########################################################################################################################*/
+static void Jobs_Execute(struct Job* job, int queue);
+
+static void Jobs_Enqueue(struct Job* job, int queue) {
+	if (!Jobs_WorkerCount) { Jobs_Execute(job, 0); return; }
+
+	JobQueue_Push(&jobs_queues[queue], job);
+	Atomic_Add(&jobs_queued, 1);
+	Waitable_Signal(jobs_workWaitable);
+}
+
+/* Queues the job once the last thing it is waiting on has been released */
+static void Jobs_Release(struct Job* job, int queue) {
+	if (Atomic_Add(&job->_waiting, -1) == 1) Jobs_Enqueue(job, queue);
+}
+
+static void Jobs_Execute(struct Job* job, int queue) {
+	struct Job* dependents[JOB_MAX_DEPENDENTS];
+	int i, count = job->_dependentsCount;
+	job->Run(job);
+
+	/* The job may be reused or freed as soon as it has finished, so copy what is still needed */
+	for (i = 0; i < count; i++) {
+		dependents[i] = job->_dependents[i];
+	}
+
+	if (job->Completed) {
+		Mutex_Lock(completed_mutex);
+		{
+			job->_next = NULL;
+			if (completed_tail) { completed_tail->_next = job; } else { completed_head = job; }
+			completed_tail = job;
+		}
+		Mutex_Unlock(completed_mutex);
+	} else {
+		Atomic_Add(&job->_finished, 1);
+	}
+
+	/* Dependent jobs are queued onto this thread's queue, since they likely use the same data */
+	for (i = 0; i < count; i++) {
+		Jobs_Release(dependents[i], queue);
+	}
+	Waitable_Signal(jobs_doneWaitable);
+}
+
+/* Takes a job from the given queue, or steals a job from another queue if that is empty */
+static struct Job* Jobs_Find(int self) {
+	struct Job* job;
+	int i, queues = Jobs_WorkerCount + 1;
+	if (Atomic_Add(&jobs_queued, 0) <= 0) return NULL;
+
+	job = JobQueue_Take(&jobs_queues[self], true);
+	for (i = 1; !job && i < queues; i++) {
+		job = JobQueue_Take(&jobs_queues[(self + i) % queues], false);
+	}
+
+	if (job) Atomic_Add(&jobs_queued, -1);
+	return job;
+}
+
+static void Jobs_WorkerLoop(void) {
+	int self = Atomic_Add(&jobs_nextWorker, 1);
+	struct Job* job;
+
+	while (!Atomic_Add(&jobs_quit, 0)) {
+		job = Jobs_Find(self);
+		if (!job) { Waitable_Wait(jobs_workWaitable); continue; }
+
+		/* Only one worker is woken up per signal, so pass the wakeup on if there's more work */
+		if (Atomic_Add(&jobs_queued, 0) > 0) Waitable_Signal(jobs_workWaitable);
+		Jobs_Execute(job, self);
+	}
+	/* Wake up the next worker, so that it also sees the quit flag */
+	Waitable_Signal(jobs_workWaitable);
+}
+
+
+/*########################################################################################################################*
+*------------------------------------------------------------Jobs---------------------------------------------------------*
+*#########################################################################################################################*/
+void Job_Init(struct Job* job, JobFunc run, void* obj) {
+	job->Run       = run;
+	job->Completed = NULL;
+	job->Obj       = obj;
+
+	/* Job_Submit releases this */
+	job->_waiting  = 1;
+	job->_finished = 0;
+	job->_dependentsCount = 0;
+	job->_next     = NULL;
+}
+
+void Job_AddDependency(struct Job* job, struct Job* dependency) {
+	if (dependency->_dependentsCount == JOB_MAX_DEPENDENTS) {
+		Logger_Abort("Job has too many dependent jobs");
+	}
+
+	dependency->_dependents[dependency->_dependentsCount++] = job;
+	job->_waiting++;
+}
+
+void Job_Submit(struct Job* job) { Jobs_Release(job, JOBS_SHARED_QUEUE); }
+
+cc_bool Job_IsFinished(struct Job* job) {
+	return Atomic_Add(&job->_finished, 0) != 0;
+}
+
+void Job_Wait(struct Job* job) {
+	struct Job* other;
+
+	while (!Job_IsFinished(job)) {
+		/* Help out with other jobs rather than just idly waiting */
+		other = Jobs_Find(JOBS_SHARED_QUEUE);
+
+		if (other) {
+			Jobs_Execute(other, JOBS_SHARED_QUEUE);
+		} else {
+			/* Job is still being run by another thread */
+			Waitable_WaitFor(jobs_doneWaitable, 1);
+		}
+	}
+}
+
+struct ParallelFor {
+	JobRangeFunc func;
+	void* obj;
+	int count, batchSize;
+	volatile int next;
+};
+
+static void ParallelFor_Run(struct ParallelFor* pf) {
+	int beg;
+	for (;;) {
+		beg = Atomic_Add(&pf->next, pf->batchSize);
+		if (beg >= pf->count) return;
+		pf->func(pf->obj, beg, min(beg + pf->batchSize, pf->count));
+	}
+}
+
+static void ParallelFor_RunJob(struct Job* job) {
+	ParallelFor_Run((struct ParallelFor*)job->Obj);
+}
+
+void Jobs_ParallelFor(int count, int batchSize, JobRangeFunc func, void* obj) {
+	struct Job helpers[JOBS_MAX_WORKERS];
+	struct ParallelFor pf;
+	int i, batches, helpersCount;
+
+	pf.func  = func;  pf.obj       = obj;
+	pf.count = count; pf.batchSize = batchSize;
+	pf.next  = 0;
+
+	/* Calling thread also runs batches, so one less helper is needed */
+	batches      = (count + batchSize - 1) / batchSize;
+	helpersCount = min(Jobs_WorkerCount, batches - 1);
+
+	for (i = 0; i < helpersCount; i++) {
+		Job_Init(&helpers[i], ParallelFor_RunJob, &pf);
+		Job_Submit(&helpers[i]);
+	}
+
+	ParallelFor_Run(&pf);
+	for (i = 0; i < helpersCount; i++) {
+		Job_Wait(&helpers[i]);
+	}
+}
+
+void Jobs_RunCompleted(void) {
+	struct Job* job;
+	struct Job* next;
+
+	Mutex_Lock(completed_mutex);
+	{
+		job = completed_head;
+		completed_head = NULL;
+		completed_tail = NULL;
+	}
+	Mutex_Unlock(completed_mutex);
+
+	for (; job; job = next) {
+		/* Completed may free the job */
+		next = job->_next;
+		Atomic_Add(&job->_finished, 1);
+		job->Completed(job);
+	}
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Jobs component------------------------------------------------------*
+*#########################################################################################################################*/
+static int Jobs_DefaultWorkers(void) {
+	int threads;
+	/* Older versions had separate thread count options instead, which also counted the calling thread */
+	threads = max(Options_GetInt(OPT_PHYSICS_THREADS, 0, JOBS_MAX_WORKERS + 1, 0),
+				  Options_GetInt(OPT_SOFTGPU_THREADS, 0, JOBS_MAX_WORKERS + 1, 0));
+	if (!threads) threads = Platform_ProcessorCount();
+	return min(max(threads - 1, 0), JOBS_MAX_WORKERS);
+}
+
+static void OnInit(void) {
+	int i, workers = Options_GetInt(OPT_JOB_THREADS, 0, JOBS_MAX_WORKERS, Jobs_DefaultWorkers());
+#ifdef CC_BUILD_WEB
+	/* Web backend doesn't support threads */
+	workers = 0;
+#endif
+
+	completed_mutex   = Mutex_Create();
+	jobs_workWaitable = Waitable_Create();
+	jobs_doneWaitable = Waitable_Create();
+	for (i = 0; i <= workers; i++) {
+		jobs_queues[i].mutex = Mutex_Create();
+	}
+
+	jobs_quit        = false;
+	jobs_nextWorker  = 0;
+	Jobs_WorkerCount = workers;
+	for (i = 0; i < workers; i++) {
+		jobs_threads[i] = Thread_Start(Jobs_WorkerLoop);
+	}
+}
+
+static void OnFree(void) {
+	int i, workers = Jobs_WorkerCount;
+	Atomic_Add(&jobs_quit, 1);
+	Waitable_Signal(jobs_workWaitable);
+
+	for (i = 0; i < workers; i++) {
+		Thread_Join(jobs_threads[i]);
+	}
+	/* Any later jobs are run immediately on the calling thread */
+	Jobs_WorkerCount = 0;
+	jobs_queued      = 0;
+
+	for (i = 0; i <= workers; i++) {
+		JobQueue_Free(&jobs_queues[i]);
+	}
+	Mutex_Free(completed_mutex);
+	Waitable_Free(jobs_workWaitable);
+	Waitable_Free(jobs_doneWaitable);
+
+	completed_mutex = NULL;
+	completed_head  = NULL;
+	completed_tail  = NULL;
+}
+
+struct IGameComponent Jobs_Component = {
+	OnInit, /* Init  */
+	OnFree, /* Free  */
+};
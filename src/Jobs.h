@@ -0,0 +1,58 @@
+#ifndef CC_JOBS_H
+#define CC_JOBS_H
+#include "Core.h"
+/* Runs jobs on a fixed number of worker threads, shared by all subsystems that do work in parallel.
+   Each worker has its own queue of jobs, and steals jobs from other queues once its own is empty.
+   Copyright 2014-2021 ClassiCube | Licensed under BSD-3
+*/
+struct IGameComponent;
+extern struct IGameComponent Jobs_Component;
+
+#define JOB_MAX_DEPENDENTS 4
+struct Job;
+typedef void (*JobFunc)(struct Job* job);
+
+/* Represents some work that is run on a worker thread. */
+/* NOTE: Jobs are allocated by the caller, and must stay valid until they have finished. */
+struct Job {
+	/* Function called on a worker thread to perform the work. */
+	JobFunc Run;
+	/* Function called on the main thread after Run has finished. (see Jobs_RunCompleted) Can be NULL. */
+	/* NOTE: The job system no longer uses the job once this is called, so it may be freed in here. */
+	JobFunc Completed;
+	/* Arbitrary data for use by Run and Completed. */
+	void* Obj;
+
+	volatile int _waiting, _finished;
+	int _dependentsCount;
+	struct Job* _dependents[JOB_MAX_DEPENDENTS];
+	struct Job* _next;
+};
+
+/* Initialises a job, with no dependencies and no Completed callback. */
+CC_API void Job_Init(struct Job* job, JobFunc run, void* obj);
+/* Makes the given job not start until the dependency job has finished running. */
+/* NOTE: Must be called before either job is submitted. */
+CC_API void Job_AddDependency(struct Job* job, struct Job* dependency);
+/* Queues the given job to be run, once all of its dependencies have finished. */
+/* NOTE: Without any worker threads, the job is instead run immediately on the calling thread. */
+CC_API void Job_Submit(struct Job* job);
+/* Returns whether the given job has finished. */
+/* NOTE: For jobs with a Completed callback, this only becomes true just before Completed is called. */
+CC_API cc_bool Job_IsFinished(struct Job* job);
+/* Blocks until the given job has finished, running other queued jobs on the calling thread meanwhile. */
+/* NOTE: Must not be used on jobs with a Completed callback. */
+CC_API void Job_Wait(struct Job* job);
+
+typedef void (*JobRangeFunc)(void* obj, int beg, int end);
+/* Calls func on all of the range 0 to count, split into batches of at most batchSize. */
+/* The batches are spread across the calling thread and all idle workers. */
+/* NOTE: Blocks until func has been called on all of the batches. */
+CC_API void Jobs_ParallelFor(int count, int batchSize, JobRangeFunc func, void* obj);
+/* Calls Completed on all jobs that have finished since this was last called. */
+/* NOTE: Must only be called from the main thread. (the game calls this every frame) */
+void Jobs_RunCompleted(void);
+
+/* Number of worker threads. (0 means jobs are always run on the thread that submits them) */
+CC_VAR extern int Jobs_WorkerCount;
+#endif
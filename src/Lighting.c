@@ -365,6 +365,7 @@ static void OnReset(void) {
 
 static void OnNewMapLoaded(void) {
 	light_heightmap = (cc_int16*)Mem_TryAlloc(World.Width * World.Length, 2);
+	Mem_SetPlace(light_heightmap, "lighting heightmap");
 	if (light_heightmap) {
 		Lighting_Refresh();
 	} else {
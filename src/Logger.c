@@ -80,6 +80,11 @@ static const char* GetCCErrorDesc(cc_result res) {
 	case CW_ERR_ROOT_TAG:   return "Invalid root NBT tag";
 	case CW_ERR_STRING_LEN: return "NBT string too long";
 
+	case CCW_ERR_IDENTIFIER: return "Not a .ccw map file";
+	case CCW_ERR_VERSION:    return "Unsupported .ccw map version";
+	case CCW_ERR_REGIONS:    return "Corrupted .ccw map regions";
+	case ERR_CHECKSUM_MISMATCH: return "Checksum mismatch";
+
 	case ERR_DOWNLOAD_INVALID: return "Website denied download or doesn't exist";
 	case ERR_NO_AUDIO_OUTPUT:  return "No audio output devices plugged in";
 	case ERR_INVALID_DATA_URL: return "Cannot download from invalid URL";
@@ -966,6 +971,10 @@ static void CloseLogFile(void) {
 	#define GFX_BACKEND " (ModernGL)"
 #elif defined CC_BUILD_GL
 	#define GFX_BACKEND " (OpenGL)"
+#elif defined CC_BUILD_SOFTGPU
+	#define GFX_BACKEND " (Software)"
+#elif defined CC_BUILD_NULLGFX
+	#define GFX_BACKEND " (Null)"
 #else
 	#define GFX_BACKEND " (Unknown)"
 #endif
@@ -514,7 +514,7 @@ static void RefreshBorderChunks(int maxHeight) {
 *--------------------------------------------------Chunks updating/sorting------------------------------------------------*
 *#########################################################################################################################*/
 #define CHUNK_TARGET_TIME ((1.0/30) + 0.01)
-static int chunksTarget = 12;
+static int chunksTarget = 12, prebuiltChunks;
 static Vec3 lastCamPos;
 static float lastYaw, lastPitch;
 /* Max distance from camera that chunks are rendered within */
@@ -607,7 +607,8 @@ static int UpdateChunksStill(int* chunkUpdates) {
 static void UpdateChunks(double delta) {
 	struct LocalPlayer* p;
 	cc_bool samePos;
-	int chunkUpdates = 0;
+	int chunkUpdates = prebuiltChunks;
+	prebuiltChunks   = 0;
 
 	/* Build more chunks if 30 FPS or over, otherwise slowdown */
 	chunksTarget += delta < CHUNK_TARGET_TIME ? 1 : -1; 
@@ -693,6 +694,25 @@ void MapRenderer_Update(double delta) {
 	UpdateChunks(delta);
 }
 
+void MapRenderer_BuildChunks(void) {
+	struct ChunkInfo* info;
+	cc_bool noData;
+	int i;
+	if (!mapChunks) return;
+
+	/* Uses sort order from last MapRenderer_Update, so nearest chunks are still built first */
+	for (i = 0; i < MapRenderer_ChunksCount && prebuiltChunks < chunksTarget; i++) {
+		info = sortedChunks[i];
+		if (info->Empty || (int)distances[i] > buildDistSquared) continue;
+
+		noData = !info->NormalParts && !info->TranslucentParts;
+		if (!noData && !info->PendingDelete) continue;
+
+		DeleteChunk(info);
+		BuildChunk(info, &prebuiltChunks);
+	}
+}
+
 
 /*########################################################################################################################*
 *---------------------------------------------------------General---------------------------------------------------------*
@@ -711,6 +731,7 @@ void MapRenderer_RefreshChunk(int cx, int cy, int cz) {
 void MapRenderer_OnBlockChanged(int x, int y, int z, BlockID block) {
 	int cx = x >> CHUNK_SHIFT, cy = y >> CHUNK_SHIFT, cz = z >> CHUNK_SHIFT;
 	struct ChunkInfo* chunk;
+	if (!mapChunks) return;
 
 	chunk = &mapChunks[MapRenderer_Pack(cx, cy, cz)];
 	chunk->AllAir &= Blocks.Draw[block] == DRAW_GAS;
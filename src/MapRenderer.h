@@ -72,6 +72,9 @@ void MapRenderer_RenderTranslucent(double delta);
 /* Potentially builds meshes for several nearby chunks. */
 /* NOTE: This should be called once per frame. */
 void MapRenderer_Update(double delta);
+/* Builds meshes for several nearby chunks, without touching the camera or entities. */
+/* Chunks built this way count towards the chunks built by the next MapRenderer_Update. */
+void MapRenderer_BuildChunks(void);
 
 /* Marks the given chunk as needing to be rebuilt/redrawn. */
 /* NOTE: Coordinates outside the map are simply ignored. */
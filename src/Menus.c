@@ -1281,17 +1281,18 @@ void ClassicGenScreen_Show(void) {
 static struct SaveLevelScreen {
 	Screen_Body
 	struct FontDesc titleFont, textFont;
-	struct ButtonWidget save, alt, cancel;
+	struct ButtonWidget save, alt, ccw, cancel;
 	struct TextInputWidget input;
-	struct TextWidget mcEdit, desc;
+	struct TextWidget mcEdit, ccwDesc, desc;
 } SaveLevelScreen;
 
-static struct Widget* save_widgets[6] = {
-	(struct Widget*)&SaveLevelScreen.save,   (struct Widget*)&SaveLevelScreen.alt,
-	(struct Widget*)&SaveLevelScreen.mcEdit, (struct Widget*)&SaveLevelScreen.cancel,
-	(struct Widget*)&SaveLevelScreen.input,  (struct Widget*)&SaveLevelScreen.desc,
+static struct Widget* save_widgets[8] = {
+	(struct Widget*)&SaveLevelScreen.save,    (struct Widget*)&SaveLevelScreen.alt,
+	(struct Widget*)&SaveLevelScreen.mcEdit,  (struct Widget*)&SaveLevelScreen.ccw,
+	(struct Widget*)&SaveLevelScreen.ccwDesc, (struct Widget*)&SaveLevelScreen.cancel,
+	(struct Widget*)&SaveLevelScreen.input,   (struct Widget*)&SaveLevelScreen.desc,
 };
-#define SAVE_MAX_VERTICES (3 * BUTTONWIDGET_MAX + MENUINPUTWIDGET_MAX + 2 * TEXTWIDGET_MAX)
+#define SAVE_MAX_VERTICES (4 * BUTTONWIDGET_MAX + MENUINPUTWIDGET_MAX + 3 * TEXTWIDGET_MAX)
 
 static void SaveLevelScreen_UpdateSave(struct SaveLevelScreen* s) {
 	ButtonWidget_SetConst(&s->save, 
@@ -1307,6 +1308,13 @@ static void SaveLevelScreen_UpdateAlt(struct SaveLevelScreen* s) {
 #endif
 }
 
+static void SaveLevelScreen_UpdateCcw(struct SaveLevelScreen* s) {
+#ifndef CC_BUILD_WEB
+	ButtonWidget_SetConst(&s->ccw,
+		s->ccw.optName ? "&cOverwrite existing?" : "Save region map", &s->titleFont);
+#endif
+}
+
 static void SaveLevelScreen_RemoveOverwrites(struct SaveLevelScreen* s) {
 	if (s->save.optName) {
 		s->save.optName = NULL;
@@ -1316,6 +1324,10 @@ static void SaveLevelScreen_RemoveOverwrites(struct SaveLevelScreen* s) {
 		s->alt.optName = NULL;
 		SaveLevelScreen_UpdateAlt(s);
 	}
+	if (s->ccw.optName) {
+		s->ccw.optName = NULL;
+		SaveLevelScreen_UpdateCcw(s);
+	}
 }
 
 #ifdef CC_BUILD_WEB
@@ -1342,6 +1354,7 @@ static void DownloadMap(const cc_string* path) {
 }
 #endif
 
+#ifdef CC_BUILD_WEB
 static void SaveLevelScreen_SaveMap(struct SaveLevelScreen* s, const cc_string* path) {
 	static const cc_string cw = String_FromConst(".cw");
 	struct Stream stream, compStream;
@@ -1351,16 +1364,7 @@ static void SaveLevelScreen_SaveMap(struct SaveLevelScreen* s, const cc_string*
 	res = Stream_CreateFile(&stream, path);
 	if (res) { Logger_SysWarn2(res, "creating", path); return; }
 	GZip_MakeStream(&compStream, &state, &stream);
-
-#ifdef CC_BUILD_WEB
 	res = Cw_Save(&compStream);
-#else
-	if (String_CaselessEnds(path, &cw)) {
-		res = Cw_Save(&compStream);
-	} else {
-		res = Schematic_Save(&compStream);
-	}
-#endif
 
 	if (res) {
 		stream.Close(&stream);
@@ -1375,18 +1379,34 @@ static void SaveLevelScreen_SaveMap(struct SaveLevelScreen* s, const cc_string*
 	res = stream.Close(&stream);
 	if (res) { Logger_SysWarn2(res, "closing", path); return; }
 
-#ifdef CC_BUILD_WEB
 	if (String_CaselessEnds(path, &cw)) {
 		Chat_Add1("&eSaved map to: %s", path);
 	} else {
 		DownloadMap(path);
 	}
-#else
-	Chat_Add1("&eSaved map to: %s", path);
-#endif
 	World.LastSave = Game.Time;
 	Gui_ShowPauseMenu();
 }
+#else
+static void SaveLevelScreen_SaveMap(struct SaveLevelScreen* s, const cc_string* path) {
+	static const cc_string cw  = String_FromConst(".cw");
+	static const cc_string ccw = String_FromConst(".ccw");
+	cc_result res;
+
+	if (String_CaselessEnds(path, &cw)) {
+		res = Map_SaveInBackground(path, Cw_Save);
+	} else if (String_CaselessEnds(path, &ccw)) {
+		/* Only regions which differ from the existing file get rewritten */
+		res = Map_SaveInBackground(path, Ccw_Save);
+	} else {
+		res = Map_SaveInBackground(path, Schematic_Save);
+	}
+
+	if (res) { Logger_SysWarn2(res, "encoding", path); return; }
+	/* Saving continues in the background, so player can keep playing */
+	Gui_ShowPauseMenu();
+}
+#endif
 
 static void SaveLevelScreen_Save(void* screen, void* widget, const char* fmt) {
 	cc_string path; char pathBuffer[FILENAME_SIZE];
@@ -1406,6 +1426,7 @@ static void SaveLevelScreen_Save(void* screen, void* widget, const char* fmt) {
 		btn->optName = "";
 		SaveLevelScreen_UpdateSave(s);
 		SaveLevelScreen_UpdateAlt(s);
+		SaveLevelScreen_UpdateCcw(s);
 	} else {
 		SaveLevelScreen_RemoveOverwrites(s);
 		SaveLevelScreen_SaveMap(s, &path);
@@ -1417,6 +1438,7 @@ static void SaveLevelScreen_Main(void* a, void* b) { SaveLevelScreen_Save(a, b,
 static void SaveLevelScreen_Alt(void* a, void* b)  { SaveLevelScreen_Save(a, b, "/%s.tmpmap"); }
 #else
 static void SaveLevelScreen_Alt(void* a, void* b)  { SaveLevelScreen_Save(a, b, "maps/%s.schematic"); }
+static void SaveLevelScreen_Ccw(void* a, void* b)  { SaveLevelScreen_Save(a, b, "maps/%s.ccw"); }
 #endif
 
 static void SaveLevelScreen_Render(void* screen, double delta) {
@@ -1426,7 +1448,7 @@ static void SaveLevelScreen_Render(void* screen, double delta) {
 
 #ifndef CC_BUILD_WEB
 	x = WindowInfo.Width / 2; y = WindowInfo.Height / 2;
-	Gfx_Draw2DFlat(x - 250, y + 90, 500, 2, grey);
+	Gfx_Draw2DFlat(x - 250, y + 80, 500, 2, grey);
 #endif
 }
 
@@ -1470,9 +1492,11 @@ static void SaveLevelScreen_ContextRecreated(void* screen) {
 	Screen_UpdateVb(screen);
 	SaveLevelScreen_UpdateSave(s);
 	SaveLevelScreen_UpdateAlt(s);
+	SaveLevelScreen_UpdateCcw(s);
 
 #ifndef CC_BUILD_WEB
 	TextWidget_SetConst(&s->mcEdit,   "&eCan be imported into MCEdit", &s->textFont);
+	TextWidget_SetConst(&s->ccwDesc,  "&eFaster to save again",        &s->textFont);
 #endif
 	TextInputWidget_SetFont(&s->input, &s->textFont);
 	ButtonWidget_SetConst(&s->cancel, "Cancel",                        &s->titleFont);
@@ -1489,8 +1513,10 @@ static void SaveLevelScreen_Layout(void* screen) {
 #ifdef CC_BUILD_WEB
 	Widget_SetLocation(&s->alt,    ANCHOR_CENTRE, ANCHOR_CENTRE,    0,  70);
 #else
-	Widget_SetLocation(&s->alt,    ANCHOR_CENTRE, ANCHOR_CENTRE, -150, 120);
-	Widget_SetLocation(&s->mcEdit, ANCHOR_CENTRE, ANCHOR_CENTRE,  110, 120);
+	Widget_SetLocation(&s->alt,     ANCHOR_CENTRE, ANCHOR_CENTRE, -150, 105);
+	Widget_SetLocation(&s->mcEdit,  ANCHOR_CENTRE, ANCHOR_CENTRE,  110, 105);
+	Widget_SetLocation(&s->ccw,     ANCHOR_CENTRE, ANCHOR_CENTRE, -150, 150);
+	Widget_SetLocation(&s->ccwDesc, ANCHOR_CENTRE, ANCHOR_CENTRE,  110, 150);
 #endif
 
 	Menu_LayoutBack(&s->cancel);
@@ -1498,7 +1524,7 @@ static void SaveLevelScreen_Layout(void* screen) {
 #ifdef CC_BUILD_WEB
 	Widget_SetLocation(&s->desc,   ANCHOR_CENTRE, ANCHOR_CENTRE,    0, 115);
 #else
-	Widget_SetLocation(&s->desc,   ANCHOR_CENTRE, ANCHOR_CENTRE,    0,  65);
+	Widget_SetLocation(&s->desc,   ANCHOR_CENTRE, ANCHOR_CENTRE,    0,  60);
 #endif
 }
 
@@ -1515,9 +1541,13 @@ static void SaveLevelScreen_Init(void* screen) {
 #ifdef CC_BUILD_WEB
 	ButtonWidget_Init(&s->alt,  300, SaveLevelScreen_Alt);
 	s->widgets[2] = NULL; /* null mcEdit widget */
+	s->widgets[3] = NULL; /* null ccw widget */
+	s->widgets[4] = NULL; /* null ccwDesc widget */
 #else
 	ButtonWidget_Init(&s->alt,  200, SaveLevelScreen_Alt);
+	ButtonWidget_Init(&s->ccw,  200, SaveLevelScreen_Ccw);
 	TextWidget_Init(&s->mcEdit);
+	TextWidget_Init(&s->ccwDesc);
 #endif
 
 	ButtonWidget_Init(&s->cancel, 400, Menu_SwitchPause);
@@ -1774,7 +1804,7 @@ static void LoadLevelScreen_LoadEntries(struct ListScreen* s) {
 static void LoadLevelScreen_UploadCallback(const cc_string* path) { Map_LoadFrom(path); }
 static void LoadLevelScreen_UploadFunc(void* s, void* w) {
 	static const char* const filters[] = { 
-		".cw", ".dat", ".lvl", ".mine", ".fcm", NULL 
+		".cw", ".dat", ".lvl", ".mine", ".fcm", ".ccw", NULL 
 	};
 	cc_result res = Window_OpenFileDialog(filters, LoadLevelScreen_UploadCallback);
 	if (res) Logger_SimpleWarn(res, "showing open file dialog");
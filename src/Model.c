@@ -1,3 +1,8 @@
+#if defined __x86_64__ || defined _M_X64
+/* Included first, since C++ standard headers may #undef the min/max macros from Funcs.h */
+#include <emmintrin.h>
+#define MODEL_SSE2
+#endif
 #include "Model.h"
 #include "ExtMath.h"
 #include "Funcs.h"
@@ -51,6 +56,8 @@ void Model_Init(struct Model* model) {
 
 	model->GetTransform = Model_GetTransform;
 	model->DrawArm      = Model_NullFunc;
+	model->cacheable    = false;
+	model->batchable    = false;
 }
 
 cc_bool Model_ShouldRender(struct Entity* e) {
@@ -93,6 +100,319 @@ float Model_RenderDistance(struct Entity* e) {
 	return dx * dx + dy * dy + dz * dz;
 }
 
+/*########################################################################################################################*
+*---------------------------------------------------------Model cache-----------------------------------------------------*
+*#########################################################################################################################*/
+/* Animation angles differing by less than this from when vertices were cached are ignored */
+/*  (so e.g. the slow idle arm sway only regenerates vertices every few frames) */
+#define MODEL_CACHE_EPSILON 0.005f
+enum ModelCacheMode { MODEL_CACHE_NONE, MODEL_CACHE_RECORD, MODEL_CACHE_REPLAY };
+static cc_uint8 cacheMode;
+static struct ModelCache* curCache;
+
+static void Model_GetCacheKey(struct Model* model, struct Entity* e, struct ModelCacheKey* key) {
+	struct AnimatedComp* anim = &e->Anim;
+	key->model   = model;
+	key->block   = e->ModelBlock;
+	key->col     = Models.Cols[0];
+	key->noShade = e->NoShade;
+
+	key->skinType        = e->SkinType;
+	key->defaultSkinType = model->defaultTex ? model->defaultTex->skinType : 0;
+	key->texID  = model->usesHumanSkin ? e->TextureId : e->MobTextureId;
+	key->uScale = e->uScale; 
+	key->vScale = e->vScale;
+
+	key->angles[0]  = (e->Yaw - e->RotY) * MATH_DEG2RAD;
+	key->angles[1]  = e->Pitch * MATH_DEG2RAD;
+	key->angles[2]  = anim->LeftLegX;  key->angles[3]  = anim->LeftLegZ;
+	key->angles[4]  = anim->RightLegX; key->angles[5]  = anim->RightLegZ;
+	key->angles[6]  = anim->LeftArmX;  key->angles[7]  = anim->LeftArmZ;
+	key->angles[8]  = anim->RightArmX; key->angles[9]  = anim->RightArmZ;
+	key->angles[10] = anim->WalkTime;  key->angles[11] = anim->Swing;
+}
+
+static cc_bool Model_CacheKeyMatches(const struct ModelCacheKey* a, const struct ModelCacheKey* b) {
+	int i;
+	if (a->model    != b->model    || a->col             != b->col             || a->noShade != b->noShade) return false;
+	if (a->block    != b->block) return false;
+	if (a->skinType != b->skinType || a->defaultSkinType != b->defaultSkinType || a->texID   != b->texID)   return false;
+	if (a->uScale   != b->uScale   || a->vScale          != b->vScale) return false;
+
+	for (i = 0; i < Array_Elems(a->angles); i++) {
+		if (Math_AbsF(a->angles[i] - b->angles[i]) >= MODEL_CACHE_EPSILON) return false;
+	}
+	return true;
+}
+
+static void Model_BeginCache(struct Model* model, struct Entity* e) {
+	struct ModelCache* cache;
+	struct ModelCacheKey key;
+	cacheMode = MODEL_CACHE_NONE;
+	if (!model->cacheable) return;
+
+	if (!e->ModelCache) {
+		e->ModelCache = (struct ModelCache*)Mem_TryAllocCleared(1, sizeof(struct ModelCache));
+		Mem_SetPlace(e->ModelCache, "model cache");
+		if (!e->ModelCache) return;
+	}
+	cache = e->ModelCache;
+	Model_GetCacheKey(model, e, &key);
+	curCache      = cache;
+	cache->offset = 0;
+
+	if (cache->valid && Model_CacheKeyMatches(&key, &cache->key)) {
+		cacheMode = MODEL_CACHE_REPLAY;
+	} else {
+		cacheMode    = MODEL_CACHE_RECORD;
+		cache->key   = key;
+		cache->count = 0;
+		cache->valid = true;
+	}
+}
+
+/* Copies the vertices about to be uploaded into the cache */
+static void Model_RecordVertices(int count) {
+	struct ModelCache* cache = curCache;
+	struct VertexTextured* vertices;
+	int capacity;
+
+	if (cache->count + count > cache->capacity) {
+		capacity = max(cache->count + count, cache->capacity * 2);
+		vertices = (struct VertexTextured*)Mem_TryRealloc(cache->vertices, capacity, sizeof(struct VertexTextured));
+
+		if (!vertices) { cache->valid = false; cacheMode = MODEL_CACHE_NONE; return; }
+		Mem_SetPlace(vertices, "model cache");
+		cache->vertices = vertices;
+		cache->capacity = capacity;
+	}
+
+	Mem_Copy(&cache->vertices[cache->count], Models.Vertices, count * sizeof(struct VertexTextured));
+	cache->count += count;
+}
+
+/* Returns the cached vertices to upload instead of Models.Vertices */
+static struct VertexTextured* Model_ReplayVertices(int count) {
+	struct ModelCache* cache = curCache;
+	struct VertexTextured* vertices = &cache->vertices[cache->offset];
+
+	/* Should never happen, but regenerate vertices next time just in case */
+	if (cache->offset + count > cache->count) { cache->valid = false; return Models.Vertices; }
+	cache->offset += count;
+	return vertices;
+}
+
+void Model_FreeCache(struct Entity* e) {
+	if (!e->ModelCache) return;
+	Mem_Free(e->ModelCache->vertices);
+	Mem_Free(e->ModelCache);
+	e->ModelCache = NULL;
+}
+
+/* Cached vertices of block models also depend on block definitions and the terrain atlas */
+static void Models_InvalidateCaches(void* obj) {
+	struct Entity* e;
+	int i;
+
+	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
+		e = Entities.List[i];
+		if (e && e->ModelCache) e->ModelCache->valid = false;
+	}
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------------Model batch-----------------------------------------------------*
+*#########################################################################################################################*/
+/* Vertices of batchable models are transformed into world space on the CPU, then all the vertices */
+/*  using the same texture are drawn at once from one large dynamic VB (like terrain particles) */
+#define MODEL_BATCH_MAX_VERTICES 16384
+#define MODEL_BATCH_MAX_RUNS 1024
+
+/* Vertices from one Model_UpdateVB call while batching */
+struct ModelBatchRun {
+	struct Matrix transform; /* Transform of the entity the vertices are for */
+	GfxResourceID tex;
+	cc_bool alphaTest;
+	int offset, count;       /* Range of the untransformed vertices in batch.vertices */
+};
+
+static struct ModelBatch {
+	cc_bool active;    /* Whether batchable models are currently being batched */
+	cc_bool recording; /* Whether the model currently being drawn is being added to the batch */
+	cc_bool alphaTest; /* Alpha testing state for the model currently being drawn */
+	GfxResourceID tex; /* Texture for the model currently being drawn */
+	struct Matrix* transform;
+	GfxResourceID vb;
+	struct VertexTextured* vertices;
+	int count, numRuns;
+	struct ModelBatchRun runs[MODEL_BATCH_MAX_RUNS];
+	cc_uint32 keys[MODEL_BATCH_MAX_RUNS];
+	cc_uint16 order[MODEL_BATCH_MAX_RUNS];
+} batch;
+
+/* Models only bind textures through this, so that binding can be deferred when batching */
+static void Model_BindTexture(GfxResourceID tex) {
+	if (batch.recording) { batch.tex = tex; } else { Gfx_BindTexture(tex); }
+}
+
+/* Models only change alpha testing through this, so that it can be deferred when batching */
+static void Model_SetAlphaTest(cc_bool enabled) {
+	if (batch.recording) { batch.alphaTest = enabled; } else { Gfx_SetAlphaTest(enabled); }
+}
+
+/* Transforms the given vertices into world space */
+static void Model_TransformBatch(const struct VertexTextured* src, struct VertexTextured* dst, int count, const struct Matrix* m) {
+	int i;
+#ifdef MODEL_SSE2
+	__m128 r1 = _mm_loadu_ps(&m->row1.X), r2 = _mm_loadu_ps(&m->row2.X);
+	__m128 r3 = _mm_loadu_ps(&m->row3.X), r4 = _mm_loadu_ps(&m->row4.X);
+	__m128 xyzMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	__m128 pos, col;
+
+	for (i = 0; i < count; i++, src++, dst++) {
+		pos = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(src->X), r1), _mm_mul_ps(_mm_set1_ps(src->Y), r2)),
+						 _mm_add_ps(_mm_mul_ps(_mm_set1_ps(src->Z), r3), r4));
+		/* Col immediately follows X/Y/Z, so all four can be written at once */
+		col = _mm_andnot_ps(xyzMask, _mm_loadu_ps(&src->X));
+		_mm_storeu_ps(&dst->X, _mm_or_ps(_mm_and_ps(pos, xyzMask), col));
+		dst->U = src->U; dst->V = src->V;
+	}
+#else
+	float x, y, z;
+	for (i = 0; i < count; i++, src++, dst++) {
+		x = src->X; y = src->Y; z = src->Z;
+		dst->X = x * m->row1.X + y * m->row2.X + z * m->row3.X + m->row4.X;
+		dst->Y = x * m->row1.Y + y * m->row2.Y + z * m->row3.Y + m->row4.Y;
+		dst->Z = x * m->row1.Z + y * m->row2.Z + z * m->row3.Z + m->row4.Z;
+		dst->Col = src->Col; dst->U = src->U; dst->V = src->V;
+	}
+#endif
+}
+
+static void Model_SortBatch(int left, int right) {
+	cc_uint16* values = batch.order; cc_uint16 value;
+	cc_uint32* keys   = batch.keys;  cc_uint32 key;
+
+	while (left < right) {
+		int i = left, j = right;
+		cc_uint32 pivot = keys[(i + j) >> 1];
+
+		/* partition the list */
+		while (i <= j) {
+			while (pivot > keys[i]) i++;
+			while (pivot < keys[j]) j--;
+			QuickSort_Swap_KV_Maybe();
+		}
+		/* recurse into the smaller subset */
+		QuickSort_Recurse(Model_SortBatch)
+	}
+}
+
+static cc_bool Model_SameGroup(const struct ModelBatchRun* a, const struct ModelBatchRun* b) {
+	return a->tex == b->tex && a->alphaTest == b->alphaTest;
+}
+
+/* Draws all the vertices in the batch, grouped by texture and alpha testing */
+static void Model_FlushBatch(void) {
+	struct VertexTextured* data;
+	struct ModelBatchRun* run;
+	struct ModelBatchRun* first;
+	int i, offset = 0, count = 0;
+	if (!batch.numRuns) return;
+
+	/* Sort key doesn't need to be unique, as groups are split wherever texture/alpha testing differs */
+	for (i = 0; i < batch.numRuns; i++) {
+		run = &batch.runs[i];
+		batch.keys[i]  = ((cc_uint32)(cc_uintptr)run->tex << 1) | run->alphaTest;
+		batch.order[i] = i;
+	}
+	Model_SortBatch(0, batch.numRuns - 1);
+
+	data = (struct VertexTextured*)Gfx_LockDynamicVb(batch.vb, VERTEX_FORMAT_TEXTURED, batch.count);
+	for (i = 0; i < batch.numRuns; i++) {
+		run = &batch.runs[batch.order[i]];
+		Model_TransformBatch(&batch.vertices[run->offset], data, run->count, &run->transform);
+		data += run->count;
+	}
+	Gfx_UnlockDynamicVb(batch.vb);
+
+	first = &batch.runs[batch.order[0]];
+	for (i = 0; i < batch.numRuns; i++) {
+		run = &batch.runs[batch.order[i]];
+		if (!Model_SameGroup(run, first)) {
+			Gfx_BindTexture(first->tex);
+			Gfx_SetAlphaTest(first->alphaTest);
+			Gfx_DrawVb_IndexedTris_Range(count, offset);
+
+			offset += count;
+			count   = 0;
+			first   = run;
+		}
+		count += run->count;
+	}
+
+	Gfx_BindTexture(first->tex);
+	Gfx_SetAlphaTest(first->alphaTest);
+	Gfx_DrawVb_IndexedTris_Range(count, offset);
+	Gfx_SetAlphaTest(true);
+
+	batch.count   = 0;
+	batch.numRuns = 0;
+}
+
+/* Draws the given vertices immediately, using the current model's deferred state */
+static void Model_DrawUnbatched(struct VertexTextured* vertices, int count) {
+	struct Matrix m;
+	Matrix_Mul(&m, batch.transform, &Gfx.View);
+
+	Gfx_LoadMatrix(MATRIX_VIEW, &m);
+	Gfx_BindTexture(batch.tex);
+	Gfx_SetAlphaTest(batch.alphaTest);
+	Gfx_UpdateDynamicVb_IndexedTris(Models.Vb, vertices, count);
+
+	Gfx_SetAlphaTest(true);
+	Gfx_LoadMatrix(MATRIX_VIEW, &Gfx.View);
+}
+
+static void Model_AddToBatch(struct VertexTextured* vertices, int count) {
+	struct ModelBatchRun* run;
+	if (!count) return;
+	/* Should only happen when a plugin has increased Models.MaxVertices */
+	if (count > MODEL_BATCH_MAX_VERTICES) { Model_DrawUnbatched(vertices, count); return; }
+
+	if (batch.count + count > MODEL_BATCH_MAX_VERTICES || batch.numRuns == MODEL_BATCH_MAX_RUNS) {
+		Model_FlushBatch();
+	}
+	run = &batch.runs[batch.numRuns++];
+	run->transform = *batch.transform;
+	run->tex       = batch.tex;
+	run->alphaTest = batch.alphaTest;
+	run->offset    = batch.count;
+	run->count     = count;
+
+	Mem_Copy(&batch.vertices[batch.count], vertices, count * sizeof(struct VertexTextured));
+	batch.count += count;
+}
+
+void Model_BeginBatch(void) {
+	if (!batch.vertices) {
+		batch.vertices = (struct VertexTextured*)Mem_TryAlloc(MODEL_BATCH_MAX_VERTICES, sizeof(struct VertexTextured));
+		Mem_SetPlace(batch.vertices, "model batch");
+	}
+	/* If out of memory, models are just drawn immediately instead */
+	batch.active = batch.vertices && batch.vb;
+}
+
+void Model_EndBatch(void) {
+	Model_FlushBatch();
+	batch.active = false;
+}
+
+
+/*########################################################################################################################*
+*------------------------------------------------------------Model--------------------------------------------------------*
+*#########################################################################################################################*/
 void Model_Render(struct Model* model, struct Entity* e) {
 	struct Matrix m;
 	Vec3 pos = e->Position;
@@ -100,12 +420,27 @@ void Model_Render(struct Model* model, struct Entity* e) {
 
 	Model_SetupState(model, e);
 	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
-
 	model->GetTransform(e, pos, &e->Transform);
+
+	if (batch.active && model->batchable) {
+		batch.recording = true;
+		batch.transform = &e->Transform;
+		batch.alphaTest = true;
+		batch.tex       = 0;
+
+		Model_BeginCache(model, e);
+		model->Draw(e);
+		cacheMode       = MODEL_CACHE_NONE;
+		batch.recording = false;
+		return;
+	}
+
 	Matrix_Mul(&m, &e->Transform, &Gfx.View);
 
 	Gfx_LoadMatrix(MATRIX_VIEW, &m);
+	Model_BeginCache(model, e);
 	model->Draw(e);
+	cacheMode = MODEL_CACHE_NONE;
 	Gfx_LoadMatrix(MATRIX_VIEW, &Gfx.View);
 }
 
@@ -143,7 +478,19 @@ void Model_SetupState(struct Model* model, struct Entity* e) {
 
 void Model_UpdateVB(void) {
 	struct Model* model = Models.Active;
-	Gfx_UpdateDynamicVb_IndexedTris(Models.Vb, Models.Vertices, model->index);
+	struct VertexTextured* vertices = Models.Vertices;
+
+	if (cacheMode == MODEL_CACHE_RECORD) {
+		Model_RecordVertices(model->index);
+	} else if (cacheMode == MODEL_CACHE_REPLAY) {
+		vertices = Model_ReplayVertices(model->index);
+	}
+
+	if (batch.recording) {
+		Model_AddToBatch(vertices, model->index);
+	} else {
+		Gfx_UpdateDynamicVb_IndexedTris(Models.Vb, vertices, model->index);
+	}
 	model->index = 0;
 }
 
@@ -162,53 +509,119 @@ void Model_ApplyTexture(struct Entity* e) {
 		Models.skinType = data->skinType;
 	}
 
-	Gfx_BindTexture(tex);
+	Model_BindTexture(tex);
 	_64x64 = Models.skinType != SKIN_64x32;
 
 	Models.uScale = e->uScale * 0.015625f;
 	Models.vScale = e->vScale * (_64x64 ? 0.015625f : 0.03125f);
 }
 
-void Model_DrawPart(struct ModelPart* part) {
+/* Transforms the vertices of the given part into Models.Vertices */
+/* If rot is non NULL, vertices are rotated by that 3x3 matrix around the part's rotation origin */
+static void Model_TransformPart(struct ModelPart* part, const float* rot) {
 	struct Model* model        = Models.Active;
 	struct ModelVertex* src    = &model->vertices[part->offset];
 	struct VertexTextured* dst = &Models.Vertices[model->index];
+	float uScale = Models.uScale, vScale = Models.vScale;
+	float x = part->rotX, y = part->rotY, z = part->rotZ;
 
 	struct ModelVertex v;
-	int i, count = part->count;
-
-	for (i = 0; i < count; i++) {
-		v = *src;
-		dst->X = v.X; dst->Y = v.Y; dst->Z = v.Z;
+	int i = 0, count = part->count;
+#ifdef MODEL_SSE2
+	/* Transforms one quad (4 vertices) at a time, which all share the same colour */
+	/* NOTE: Relies on struct ModelVertex being exactly 4 floats in size */
+	float outX[4], outY[4], outZ[4], outU[4], outV[4];
+	__m128 pX = _mm_set1_ps(x), pY = _mm_set1_ps(y), pZ = _mm_set1_ps(z);
+	__m128 sU = _mm_set1_ps(uScale), sV = _mm_set1_ps(vScale), maxOffset = _mm_set1_ps(0.01f);
+	__m128i posMask = _mm_set1_epi32(UV_POS_MASK), lowMask = _mm_set1_epi32(0xFFFF);
+	__m128 vX, vY, vZ, vUV, tX, tY, tZ;
+	__m128i uv, u, w;
+	PackedCol col;
+	int j;
+
+	for (; i + 4 <= count; i += 4) {
+		vX  = _mm_loadu_ps((const float*)&src[i + 0]);
+		vY  = _mm_loadu_ps((const float*)&src[i + 1]);
+		vZ  = _mm_loadu_ps((const float*)&src[i + 2]);
+		vUV = _mm_loadu_ps((const float*)&src[i + 3]);
+		_MM_TRANSPOSE4_PS(vX, vY, vZ, vUV);
+
+		if (rot) {
+			vX = _mm_sub_ps(vX, pX); vY = _mm_sub_ps(vY, pY); vZ = _mm_sub_ps(vZ, pZ);
+
+			tX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vX, _mm_set1_ps(rot[0])), 
+				_mm_mul_ps(vY, _mm_set1_ps(rot[1]))), _mm_mul_ps(vZ, _mm_set1_ps(rot[2])));
+			tY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vX, _mm_set1_ps(rot[3])), 
+				_mm_mul_ps(vY, _mm_set1_ps(rot[4]))), _mm_mul_ps(vZ, _mm_set1_ps(rot[5])));
+			tZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vX, _mm_set1_ps(rot[6])), 
+				_mm_mul_ps(vY, _mm_set1_ps(rot[7]))), _mm_mul_ps(vZ, _mm_set1_ps(rot[8])));
+
+			vX = _mm_add_ps(tX, pX); vY = _mm_add_ps(tY, pY); vZ = _mm_add_ps(tZ, pZ);
+		}
+		_mm_storeu_ps(outX, vX); _mm_storeu_ps(outY, vY); _mm_storeu_ps(outZ, vZ);
+
+		/* U is in low 16 bits, V is in high 16 bits */
+		uv = _mm_castps_si128(vUV);
+		u  = _mm_and_si128(uv, lowMask);
+		w  = _mm_srli_epi32(uv, 16);
+		_mm_storeu_ps(outU, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(u, posMask)), sU),
+			_mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(u, UV_MAX_SHIFT)), maxOffset), sU)));
+		_mm_storeu_ps(outV, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(w, posMask)), sV),
+			_mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(w, UV_MAX_SHIFT)), maxOffset), sV)));
+
+		col = Models.Cols[i >> 2];
+		for (j = 0; j < 4; j++, dst++) {
+			dst->X = outX[j]; dst->Y = outY[j]; dst->Z = outZ[j];
+			dst->Col = col;
+			dst->U = outU[j]; dst->V = outV[j];
+		}
+	}
+#endif
+
+	for (; i < count; i++, dst++) {
+		v = src[i];
+		if (rot) {
+			v.X -= x; v.Y -= y; v.Z -= z;
+			dst->X = rot[0] * v.X + rot[1] * v.Y + rot[2] * v.Z + x;
+			dst->Y = rot[3] * v.X + rot[4] * v.Y + rot[5] * v.Z + y;
+			dst->Z = rot[6] * v.X + rot[7] * v.Y + rot[8] * v.Z + z;
+		} else {
+			dst->X = v.X; dst->Y = v.Y; dst->Z = v.Z;
+		}
 		dst->Col = Models.Cols[i >> 2];
 
-		dst->U = (v.U & UV_POS_MASK) * Models.uScale - (v.U >> UV_MAX_SHIFT) * 0.01f * Models.uScale;
-		dst->V = (v.V & UV_POS_MASK) * Models.vScale - (v.V >> UV_MAX_SHIFT) * 0.01f * Models.vScale;
-		src++; dst++;
+		dst->U = (v.U & UV_POS_MASK) * uScale - (v.U >> UV_MAX_SHIFT) * 0.01f * uScale;
+		dst->V = (v.V & UV_POS_MASK) * vScale - (v.V >> UV_MAX_SHIFT) * 0.01f * vScale;
 	}
 	model->index += count;
 }
 
+void Model_DrawPart(struct ModelPart* part) {
+	/* Cached vertices will be uploaded instead */
+	if (cacheMode == MODEL_CACHE_REPLAY) { Models.Active->index += part->count; return; }
+	Model_TransformPart(part, NULL);
+}
+
 #define Model_RotateX t = cosX * v.Y + sinX * v.Z; v.Z = -sinX * v.Y + cosX * v.Z; v.Y = t;
 #define Model_RotateY t = cosY * v.X - sinY * v.Z; v.Z =  sinY * v.X + cosY * v.Z; v.X = t;
 #define Model_RotateZ t = cosZ * v.X + sinZ * v.Y; v.Y = -sinZ * v.X + cosZ * v.Y; v.X = t;
 
 void Model_DrawRotate(float angleX, float angleY, float angleZ, struct ModelPart* part, cc_bool head) {
-	struct Model* model        = Models.Active;
-	struct ModelVertex* src    = &model->vertices[part->offset];
-	struct VertexTextured* dst = &Models.Vertices[model->index];
+	float cosX, sinX, cosY, sinY, cosZ, sinZ;
+	float t, rot[9];
+	Vec3 v;
+	int i;
 
-	float cosX = (float)Math_Cos(-angleX), sinX = (float)Math_Sin(-angleX);
-	float cosY = (float)Math_Cos(-angleY), sinY = (float)Math_Sin(-angleY);
-	float cosZ = (float)Math_Cos(-angleZ), sinZ = (float)Math_Sin(-angleZ);
-	float t, x = part->rotX, y = part->rotY, z = part->rotZ;
-	
-	struct ModelVertex v;
-	int i, count = part->count;
+	/* Cached vertices will be uploaded instead */
+	if (cacheMode == MODEL_CACHE_REPLAY) { Models.Active->index += part->count; return; }
+	cosX = (float)Math_Cos(-angleX); sinX = (float)Math_Sin(-angleX);
+	cosY = (float)Math_Cos(-angleY); sinY = (float)Math_Sin(-angleY);
+	cosZ = (float)Math_Cos(-angleZ); sinZ = (float)Math_Sin(-angleZ);
 
-	for (i = 0; i < count; i++) {
-		v = *src;
-		v.X -= x; v.Y -= y; v.Z -= z;
+	/* Rotations are the same for every vertex, so combine them into one matrix */
+	/*  by rotating each axis, instead of rotating every vertex one axis at a time */
+	for (i = 0; i < 3; i++) {
+		v.X = i == 0; v.Y = i == 1; v.Z = i == 2;
 
 		/* Rotate locally */
 		if (Models.Rotation == ROTATE_ORDER_ZYX) {
@@ -233,14 +646,9 @@ void Model_DrawRotate(float angleX, float angleY, float angleZ, struct ModelPart
 		if (head) {
 			t = Models.cosHead * v.X - Models.sinHead * v.Z; v.Z = Models.sinHead * v.X + Models.cosHead * v.Z; v.X = t;
 		}
-		dst->X = v.X + x; dst->Y = v.Y + y; dst->Z = v.Z + z;
-		dst->Col = Models.Cols[i >> 2];
-
-		dst->U = (v.U & UV_POS_MASK) * Models.uScale - (v.U >> UV_MAX_SHIFT) * 0.01f * Models.uScale;
-		dst->V = (v.V & UV_POS_MASK) * Models.vScale - (v.V >> UV_MAX_SHIFT) * 0.01f * Models.vScale;
-		src++; dst++;
+		rot[0 + i] = v.X; rot[3 + i] = v.Y; rot[6 + i] = v.Z;
 	}
-	model->index += count;
+	Model_TransformPart(part, rot);
 }
 
 void Model_RenderArm(struct Model* model, struct Entity* e) {
@@ -826,6 +1234,8 @@ void CustomModel_Register(struct CustomModel* cm) {
 	cm->model.GetCollisionSize = CustomModel_GetCollisionSize;
 	cm->model.GetPickingBounds = CustomModel_GetPickingBounds;
 	cm->model.DrawArm          = CustomModel_DrawArm;
+	/* CustomModel_Draw only changes graphics state through Model_ApplyTexture */
+	cm->model.batchable        = true;
 
 	/* add to front of models linked list to override original models */
 	if (!models_head) {
@@ -871,7 +1281,7 @@ static void HumanModel_DrawCore(struct Entity* e, struct ModelSet* model, cc_boo
 
 	Model_ApplyTexture(e);
 	/* human model draws the body opaque so players can't have invisible skins */
-	if (opaque) Gfx_SetAlphaTest(false);
+	if (opaque) Model_SetAlphaTest(false);
 
 	type = Models.skinType;
 	set  = &model->limbs[type & 0x3];
@@ -889,7 +1299,7 @@ static void HumanModel_DrawCore(struct Entity* e, struct ModelSet* model, cc_boo
 	/* have to seperately draw these vertices without alpha testing */
 	if (opaque) {
 		Model_UpdateVB();
-		Gfx_SetAlphaTest(true);
+		Model_SetAlphaTest(true);
 	}
 
 	if (type != SKIN_64x32) {
@@ -1651,7 +2061,7 @@ static void FurlessModel_Draw(struct Entity* e) {
 
 static void SheepModel_Draw(struct Entity* e) {
 	FurlessModel_Draw(e);
-	Gfx_BindTexture(fur_tex.texID);
+	Model_BindTexture(fur_tex.texID);
 	Model_DrawRotate(-e->Pitch * MATH_DEG2RAD, 0, 0, &fur_head, true);
 
 	Model_DrawPart(&fur_torso);
@@ -2030,9 +2440,27 @@ static void BlockModel_BuildParts(cc_bool sprite) {
 	}
 }
 
-static void BlockModel_DrawParts(void) {
+/* Faces in the same order that BlockModel_BuildParts gets their textures in */
+static const cc_uint8 bModel_spriteFaces[8] = {
+	FACE_XMAX, FACE_XMAX, FACE_ZMAX, FACE_ZMAX, FACE_ZMAX, FACE_ZMAX, FACE_XMAX, FACE_XMAX
+};
+static const cc_uint8 bModel_cubeFaces[FACE_COUNT] = {
+	FACE_YMIN, FACE_ZMIN, FACE_XMAX, FACE_ZMAX, FACE_XMIN, FACE_YMAX
+};
+
+/* Only works out the 1D atlas of each face, for when vertices are reused from the cache */
+static void BlockModel_GetTexIndices(cc_bool sprite) {
+	const cc_uint8* faces = sprite ? bModel_spriteFaces : bModel_cubeFaces;
+	int i, count = sprite ? Array_Elems(bModel_spriteFaces) : Array_Elems(bModel_cubeFaces);
+
+	for (i = 0; i < count; i++) {
+		BlockModel_GetTex(faces[i]);
+	}
+}
+
+static void BlockModel_DrawParts(struct VertexTextured* vertices) {
 	int lastTexIndex, i, offset = 0, count = 0;
-	Gfx_SetDynamicVbData(Models.Vb, Models.Vertices, bModel_index * 4);
+	Gfx_SetDynamicVbData(Models.Vb, vertices, bModel_index * 4);
 
 	lastTexIndex = bModel_texIndices[0];
 	for (i = 0; i < bModel_index; i++, count += 4) {
@@ -2054,6 +2482,7 @@ static void BlockModel_DrawParts(void) {
 }
 
 static void BlockModel_Draw(struct Entity* p) {
+	struct VertexTextured* vertices;
 	cc_bool sprite;
 	int i;
 
@@ -2067,11 +2496,22 @@ static void BlockModel_Draw(struct Entity* p) {
 		}
 	}
 
-	sprite = Blocks.Draw[bModel_block] == DRAW_SPRITE;
-	BlockModel_BuildParts(sprite);
+	sprite   = Blocks.Draw[bModel_block] == DRAW_SPRITE;
+	vertices = Models.Vertices;
+
+	if (cacheMode == MODEL_CACHE_REPLAY) {
+		BlockModel_GetTexIndices(sprite);
+		vertices = Model_ReplayVertices(bModel_index * 4);
+	}
+	/* Also rebuilds vertices when the cached vertices couldn't be used */
+	if (vertices == Models.Vertices) {
+		bModel_index = 0;
+		BlockModel_BuildParts(sprite);
+		if (cacheMode == MODEL_CACHE_RECORD) Model_RecordVertices(bModel_index * 4);
+	}
 
 	if (sprite) Gfx_SetFaceCulling(true);
-	BlockModel_DrawParts();
+	BlockModel_DrawParts(vertices);
 	if (sprite) Gfx_SetFaceCulling(false);
 }
 
@@ -2208,6 +2648,25 @@ static void HoldModel_Register(void) {
 /*########################################################################################################################*
 *-------------------------------------------------------Models component--------------------------------------------------*
 *#########################################################################################################################*/
+/* Vertices of built in models only depend on what's in struct ModelCacheKey, */
+/*  apart from block model (see Models_InvalidateCaches) and hold model */
+/*  (which changes its entity's block/animation state when drawing) */
+static void Models_MarkCacheable(void) {
+	struct Model* model;
+	for (model = models_head; model; model = model->next) {
+		model->cacheable = model != &hold_model;
+	}
+}
+
+/* Built in models only change graphics state through Model_BindTexture/Model_SetAlphaTest, */
+/*  apart from block and hold models (which draw directly using the terrain atlas) */
+static void Models_MarkBatchable(void) {
+	struct Model* model;
+	for (model = models_head; model; model = model->next) {
+		model->batchable = model != &block_model && model != &hold_model;
+	}
+}
+
 static void RegisterDefaultModels(void) {
 	Model_RegisterTexture(&human_tex);
 	Model_RegisterTexture(&chicken_tex);
@@ -2240,11 +2699,14 @@ static void RegisterDefaultModels(void) {
 	CorpseModel_Register();
 	SkinnedCubeModel_Register();
 	HoldModel_Register();
+	Models_MarkCacheable();
+	Models_MarkBatchable();
 }
 
 static void OnContextLost(void* obj) {
 	struct ModelTex* tex;
 	Gfx_DeleteDynamicVb(&Models.Vb);
+	Gfx_DeleteDynamicVb(&batch.vb);
 	if (Gfx.ManagedTextures) return;
 
 	for (tex = textures_head; tex; tex = tex->next) {
@@ -2254,6 +2716,7 @@ static void OnContextLost(void* obj) {
 
 static void OnContextRecreated(void* obj) {
 	Gfx_RecreateDynamicVb(&Models.Vb, VERTEX_FORMAT_TEXTURED, Models.MaxVertices);
+	Gfx_RecreateDynamicVb(&batch.vb,  VERTEX_FORMAT_TEXTURED, MODEL_BATCH_MAX_VERTICES);
 }
 
 static void OnInit(void) {
@@ -2265,6 +2728,8 @@ static void OnInit(void) {
 	Models.ClassicArms = Options_GetBool(OPT_CLASSIC_ARM_MODEL, Game_ClassicMode);
 
 	Event_Register_(&TextureEvents.FileChanged,  NULL, Models_TextureChanged);
+	Event_Register_(&TextureEvents.AtlasChanged, NULL, Models_InvalidateCaches);
+	Event_Register_(&BlockEvents.BlockDefChanged, NULL, Models_InvalidateCaches);
 	Event_Register_(&GfxEvents.ContextLost,      NULL, OnContextLost);
 	Event_Register_(&GfxEvents.ContextRecreated, NULL, OnContextRecreated);
 }
@@ -2272,6 +2737,8 @@ static void OnInit(void) {
 static void OnFree(void) {
 	OnContextLost(NULL);
 	CustomModel_FreeAll();
+	Mem_Free(batch.vertices);
+	batch.vertices = NULL;
 }
 
 static void OnReset(void) { CustomModel_FreeAll(); }
@@ -82,6 +82,30 @@ struct Model {
 
 	float maxScale, shadowScale, nameScale;
 	struct Model* next;
+	/* Whether vertices generated by Draw only depend on the fields in struct ModelCacheKey, */
+	/*  and so can be reused when drawing the same entity again. (see Model_Render) */
+	/* NOTE: All cached vertices are invalidated when block definitions or terrain atlas change */
+	cc_bool cacheable;
+	/* Whether Draw only changes graphics state through Model_ApplyTexture, */
+	/*  and so can be drawn together with other models using the same texture. (see Model_BeginBatch) */
+	cc_bool batchable;
+};
+
+/* What vertices generated when drawing a cacheable model for an entity depend on */
+struct ModelCacheKey {
+	struct Model* model; BlockID block;
+	PackedCol col; cc_bool noShade; 
+	cc_uint8 skinType, defaultSkinType;
+	GfxResourceID texID; float uScale, vScale;
+	/* Head yaw/pitch and animation state (in radians) */
+	float angles[12];
+};
+/* Vertices generated the last time an entity's model was drawn */
+struct ModelCache {
+	struct VertexTextured* vertices;
+	int count, capacity, offset;
+	cc_bool valid;
+	struct ModelCacheKey key;
 };
 
 /* Shared data for models. */
@@ -120,7 +144,16 @@ cc_bool Model_ShouldRender(struct Entity* entity);
 /* Approximately how far the given entity is away from the player. */
 float Model_RenderDistance(struct Entity* entity);
 /* Draws the given entity as the given model. */
+/* NOTE: If the model is cacheable, vertices from last time the entity was drawn may be reused. */
 CC_API void Model_Render(struct Model* model, struct Entity* entity);
+/* Frees the cached vertices of the given entity's model. */
+void Model_FreeCache(struct Entity* entity);
+/* Starts deferring drawing of batchable models, so that all the batched models using the */
+/*  same texture can be drawn at once from one large dynamic vertex buffer. */
+/* NOTE: Expects alpha testing to be enabled and the view matrix to be Gfx.View. */
+void Model_BeginBatch(void);
+/* Draws all the models batched since Model_BeginBatch, then stops batching. */
+void Model_EndBatch(void);
 /* Sets up state to be suitable for rendering the given model. */
 /* NOTE: Model_Render already calls this, you don't normally need to call this. */
 CC_API void Model_SetupState(struct Model* model, struct Entity* entity);
@@ -13,6 +13,13 @@
 
 #define OPT_VIEW_DISTANCE "viewdist"
 #define OPT_BLOCK_PHYSICS "singleplayerphysics"
+#define OPT_AUTOSAVE_INTERVAL "singleplayer-autosave"
+/* Ticks entities/particles on another thread, overlapping only with building chunk meshes */
+#define OPT_ENTITY_TICK_THREAD "entity-tick-thread"
+#define OPT_JOB_THREADS "job-threads"
+/* Older thread count options, only read when OPT_JOB_THREADS is not set */
+#define OPT_PHYSICS_THREADS "singleplayer-physics-threads"
+#define OPT_SOFTGPU_THREADS "gfx-softgpu-threads"
 #define OPT_NAMES_MODE "namesmode"
 #define OPT_INVERT_MOUSE "invertmouse"
 #define OPT_SENSITIVITY "mousesensitivity"
@@ -23,7 +30,10 @@
 #define OPT_RENDER_TYPE "normal"
 #define OPT_SMOOTH_LIGHTING "gfx-smoothlighting"
 #define OPT_MIPMAPS "gfx-mipmaps"
+#define OPT_MAX_PARTICLES "gfx-maxparticles"
 #define OPT_CHAT_LOGGING "chat-logging"
+#define OPT_LOG_FRAME_STATS "framestats-logging"
+#define OPT_MEM_TRACKING "mem-tracking"
 #define OPT_WINDOW_WIDTH "window-width"
 #define OPT_WINDOW_HEIGHT "window-height"
 
@@ -48,6 +58,8 @@
 #define OPT_INVENTORY_SCALE "gui-inventoryscale"
 #define OPT_CHAT_SCALE "gui-chatscale"
 #define OPT_SHOW_FPS "gui-showfps"
+#define OPT_SHOW_FRAME_STATS "gui-framestats"
+#define OPT_SHOW_MEMORY "gui-memory"
 #define OPT_FONT_NAME "gui-fontname"
 #define OPT_BLACK_TEXT "gui-blacktextshadows"
 
@@ -1,3 +1,8 @@
+#if defined __x86_64__ || defined _M_X64
+/* Included first, since C++ standard headers may #undef the min/max macros from Funcs.h */
+#include <emmintrin.h>
+#define PARTICLES_SSE2
+#endif
 #include "Particle.h"
 #include "Block.h"
 #include "World.h"
@@ -9,16 +14,107 @@
 #include "Funcs.h"
 #include "Game.h"
 #include "Event.h"
+#include "Options.h"
+#include "Platform.h"
 
 
 /*########################################################################################################################*
 *------------------------------------------------------Particle base------------------------------------------------------*
 *#########################################################################################################################*/
 static GfxResourceID Particles_TexId, Particles_VB;
-#define PARTICLES_MAX 600
+#define PARTICLES_MIN_MAX 256
+#define PARTICLES_DEF_MAX 4096
+/* Each particle is drawn as a quad, and all particles of a type are drawn in one batch */
+#define PARTICLES_MAX_LIMIT (GFX_MAX_VERTICES / 4)
+static int particles_max;
 static RNGState rnd;
 static cc_bool hitTerrain;
+static cc_uint64 tick_elapsed, tick_peak;
 typedef cc_bool (*CanPassThroughFunc)(BlockID b);
+typedef void (*ParticleMoveFunc)(int dst, int src);
+
+#define PARTICLE_REMOVE 0x01
+/* Particles are stored as a structure of arrays, so movement can be updated for several particles at once */
+struct ParticlePool {
+	float* velX;  float* velY;  float* velZ;
+	float* lastX; float* lastY; float* lastZ;
+	float* nextX; float* nextY; float* nextZ;
+	float* lifetime; float* size; float* gravity;
+	cc_uint8* flags;
+	int count;
+	/* Moves the type specific data of a particle to another index (can be NULL) */
+	ParticleMoveFunc MoveExtra;
+};
+#define PARTICLE_FLOATS 12
+
+static void ParticlePool_Alloc(struct ParticlePool* p) {
+	float* data = (float*)Mem_Alloc(particles_max * PARTICLE_FLOATS, sizeof(float), "particles");
+	p->velX     = data; data += particles_max;
+	p->velY     = data; data += particles_max;
+	p->velZ     = data; data += particles_max;
+	p->lastX    = data; data += particles_max;
+	p->lastY    = data; data += particles_max;
+	p->lastZ    = data; data += particles_max;
+	p->nextX    = data; data += particles_max;
+	p->nextY    = data; data += particles_max;
+	p->nextZ    = data; data += particles_max;
+	p->lifetime = data; data += particles_max;
+	p->size     = data; data += particles_max;
+	p->gravity  = data;
+
+	p->flags = (cc_uint8*)Mem_AllocCleared(particles_max, 1, "particle flags");
+	p->count = 0;
+}
+
+static void ParticlePool_Free(struct ParticlePool* p) {
+	/* velX is the start of the combined allocation */
+	Mem_Free(p->velX);
+	Mem_Free(p->flags);
+	p->velX  = NULL;
+	p->flags = NULL;
+	p->count = 0;
+}
+
+static void ParticlePool_Move(struct ParticlePool* p, int dst, int src) {
+	p->velX[dst]  = p->velX[src];  p->velY[dst]  = p->velY[src];  p->velZ[dst]  = p->velZ[src];
+	p->lastX[dst] = p->lastX[src]; p->lastY[dst] = p->lastY[src]; p->lastZ[dst] = p->lastZ[src];
+	p->nextX[dst] = p->nextX[src]; p->nextY[dst] = p->nextY[src]; p->nextZ[dst] = p->nextZ[src];
+
+	p->lifetime[dst] = p->lifetime[src];
+	p->size[dst]     = p->size[src];
+	p->gravity[dst]  = p->gravity[src];
+	p->flags[dst]    = p->flags[src];
+	if (p->MoveExtra) p->MoveExtra(dst, src);
+}
+
+/* Removes all particles flagged with PARTICLE_REMOVE, preserving the order of remaining particles */
+static void ParticlePool_Compact(struct ParticlePool* p) {
+	int i, j = 0;
+	for (i = 0; i < p->count; i++) {
+		if (p->flags[i] & PARTICLE_REMOVE) continue;
+		if (i != j) ParticlePool_Move(p, j, i);
+		j++;
+	}
+	p->count = j;
+}
+
+/* Removes the oldest particles if needed, so that 'count' more particles can be spawned */
+static void ParticlePool_Reserve(struct ParticlePool* p, int count) {
+	int i, excess = p->count + count - particles_max;
+	if (excess <= 0) return;
+	excess = min(excess, p->count);
+
+	for (i = 0; i < excess; i++)        { p->flags[i] |=  PARTICLE_REMOVE; }
+	for (i = excess; i < p->count; i++) { p->flags[i] &= ~PARTICLE_REMOVE; }
+	ParticlePool_Compact(p);
+}
+
+/* Returns the index of a newly spawned particle, removing the oldest particle if the pool is full */
+static int ParticlePool_Spawn(struct ParticlePool* p) {
+	if (p->count == particles_max) ParticlePool_Reserve(p, 1);
+	p->flags[p->count] = 0;
+	return p->count++;
+}
 
 void Particle_DoRender(const Vec2* size, const Vec3* pos, const TextureRec* rec, PackedCol col, struct VertexTextured* v) {
 	struct Matrix* view;
@@ -29,7 +125,7 @@ void Particle_DoRender(const Vec2* size, const Vec3* pos, const TextureRec* rec,
 	sX = size->X * 0.5f; sY = size->Y * 0.5f;
 	centre = *pos; centre.Y += sY;
 	view   = &Gfx.View;
-	
+
 	aX = view->row1.X * sX; aY = view->row2.X * sX; aZ = view->row3.X * sX; /* right * size.X * 0.5f */
 	bX = view->row1.Y * sY; bY = view->row2.Y * sY; bZ = view->row3.Y * sY; /* up    * size.Y * 0.5f */
 
@@ -39,12 +135,16 @@ void Particle_DoRender(const Vec2* size, const Vec3* pos, const TextureRec* rec,
 	v->X = centre.X + aX - bX; v->Y = centre.Y + aY - bY; v->Z = centre.Z + aZ - bZ; v->Col = col; v->U = rec->U2; v->V = rec->V2; v++;
 }
 
-static cc_bool CollidesHor(Vec3* nextPos, BlockID block) {
-	Vec3 horPos = Vec3_Create3((float)Math_Floor(nextPos->X), 0.0f, (float)Math_Floor(nextPos->Z));
-	Vec3 min, max;
-	Vec3_Add(&min, &Blocks.MinBB[block], &horPos);
-	Vec3_Add(&max, &Blocks.MaxBB[block], &horPos);
-	return nextPos->X >= min.X && nextPos->Z >= min.Z && nextPos->X < max.X && nextPos->Z < max.Z;
+static void ParticlePool_GetPos(struct ParticlePool* p, int i, float t, Vec3* pos) {
+	pos->X = p->lastX[i] + (p->nextX[i] - p->lastX[i]) * t;
+	pos->Y = p->lastY[i] + (p->nextY[i] - p->lastY[i]) * t;
+	pos->Z = p->lastZ[i] + (p->nextZ[i] - p->lastZ[i]) * t;
+}
+
+static cc_bool CollidesHor(float x, float z, BlockID block) {
+	float horX = (float)Math_Floor(x), horZ = (float)Math_Floor(z);
+	return x >= Blocks.MinBB[block].X + horX && z >= Blocks.MinBB[block].Z + horZ
+		&& x <  Blocks.MaxBB[block].X + horX && z <  Blocks.MaxBB[block].Z + horZ;
 }
 
 static BlockID GetBlock(int x, int y, int z) {
@@ -55,79 +155,111 @@ static BlockID GetBlock(int x, int y, int z) {
 	return Env.SidesBlock;
 }
 
-static cc_bool ClipY(struct Particle* p, int y, cc_bool topFace, CanPassThroughFunc canPassThrough) {
+static cc_bool ClipY(struct ParticlePool* p, int i, int y, cc_bool topFace, CanPassThroughFunc canPassThrough) {
 	BlockID block;
 	Vec3 minBB, maxBB;
 	float collideY;
 	cc_bool collideVer;
 
 	if (y < 0) {
-		p->nextPos.Y = ENTITY_ADJUSTMENT; 
-		p->lastPos.Y = ENTITY_ADJUSTMENT;
+		p->nextY[i] = ENTITY_ADJUSTMENT;
+		p->lastY[i] = ENTITY_ADJUSTMENT;
 
-		Vec3_Set(p->velocity, 0,0,0);
+		p->velX[i] = 0; p->velY[i] = 0; p->velZ[i] = 0;
 		hitTerrain = true;
 		return false;
 	}
 
-	block = GetBlock((int)p->nextPos.X, y, (int)p->nextPos.Z);
+	block = GetBlock((int)p->nextX[i], y, (int)p->nextZ[i]);
 	if (canPassThrough(block)) return true;
 	minBB = Blocks.MinBB[block]; maxBB = Blocks.MaxBB[block];
 
 	collideY   = y + (topFace ? maxBB.Y : minBB.Y);
-	collideVer = topFace ? (p->nextPos.Y < collideY) : (p->nextPos.Y > collideY);
+	collideVer = topFace ? (p->nextY[i] < collideY) : (p->nextY[i] > collideY);
 
-	if (collideVer && CollidesHor(&p->nextPos, block)) {
+	if (collideVer && CollidesHor(p->nextX[i], p->nextZ[i], block)) {
 		float adjust = topFace ? ENTITY_ADJUSTMENT : -ENTITY_ADJUSTMENT;
-		p->lastPos.Y = collideY + adjust;
-		p->nextPos.Y = p->lastPos.Y;
+		p->lastY[i] = collideY + adjust;
+		p->nextY[i] = p->lastY[i];
 
-		Vec3_Set(p->velocity, 0,0,0);
+		p->velX[i] = 0; p->velY[i] = 0; p->velZ[i] = 0;
 		hitTerrain = true;
 		return false;
 	}
 	return true;
 }
 
-static cc_bool IntersectsBlock(struct Particle* p, CanPassThroughFunc canPassThrough) {
-	BlockID cur = GetBlock((int)p->nextPos.X, (int)p->nextPos.Y, (int)p->nextPos.Z);
-	float minY  = Math_Floor(p->nextPos.Y) + Blocks.MinBB[cur].Y;
-	float maxY  = Math_Floor(p->nextPos.Y) + Blocks.MaxBB[cur].Y;
+static cc_bool IntersectsBlock(struct ParticlePool* p, int i, CanPassThroughFunc canPassThrough) {
+	float x = p->nextX[i], y = p->nextY[i], z = p->nextZ[i];
+	BlockID cur = GetBlock((int)x, (int)y, (int)z);
+	float minY  = Math_Floor(y) + Blocks.MinBB[cur].Y;
+	float maxY  = Math_Floor(y) + Blocks.MaxBB[cur].Y;
 
-	return !canPassThrough(cur) && p->nextPos.Y >= minY && p->nextPos.Y < maxY && CollidesHor(&p->nextPos, cur);
+	return !canPassThrough(cur) && y >= minY && y < maxY && CollidesHor(x, z, cur);
 }
 
-static cc_bool PhysicsTick(struct Particle* p, float gravity, CanPassThroughFunc canPassThrough, double delta) {
-	Vec3 velocity;
-	int y, begY, endY;
+/* Begins a physics tick for the given particle, returning whether it is stuck inside a block */
+static cc_bool ParticlePool_BeginTick(struct ParticlePool* p, int i, CanPassThroughFunc canPassThrough) {
+	p->lastX[i] = p->nextX[i];
+	p->lastY[i] = p->nextY[i];
+	p->lastZ[i] = p->nextZ[i];
+	return IntersectsBlock(p, i, canPassThrough);
+}
+
+/* Applies gravity and velocity to all particles in the pool, then decreases their lifetime */
+static void ParticlePool_Integrate(struct ParticlePool* p, float delta) {
+	float scale = delta * 3.0f;
+	int i = 0;
+#ifdef PARTICLES_SSE2
+	__m128 delta4 = _mm_set1_ps(delta), scale4 = _mm_set1_ps(scale);
+	__m128 vel;
+
+	for (; i + 4 <= p->count; i += 4) {
+		vel = _mm_loadu_ps(p->velY + i);
+		vel = _mm_sub_ps(vel, _mm_mul_ps(_mm_loadu_ps(p->gravity + i), delta4));
+		_mm_storeu_ps(p->velY + i, vel);
+		_mm_storeu_ps(p->nextY + i, _mm_add_ps(_mm_loadu_ps(p->nextY + i), _mm_mul_ps(vel, scale4)));
 
-	p->lastPos = p->nextPos;
-	if (IntersectsBlock(p, canPassThrough)) return true;
+		vel = _mm_loadu_ps(p->velX + i);
+		_mm_storeu_ps(p->nextX + i, _mm_add_ps(_mm_loadu_ps(p->nextX + i), _mm_mul_ps(vel, scale4)));
+		vel = _mm_loadu_ps(p->velZ + i);
+		_mm_storeu_ps(p->nextZ + i, _mm_add_ps(_mm_loadu_ps(p->nextZ + i), _mm_mul_ps(vel, scale4)));
+
+		_mm_storeu_ps(p->lifetime + i, _mm_sub_ps(_mm_loadu_ps(p->lifetime + i), delta4));
+	}
+#endif
+	for (; i < p->count; i++) {
+		p->velY[i]  -= p->gravity[i] * delta;
+		p->nextX[i] += p->velX[i] * scale;
+		p->nextY[i] += p->velY[i] * scale;
+		p->nextZ[i] += p->velZ[i] * scale;
+		p->lifetime[i] -= delta;
+	}
+}
 
-	p->velocity.Y -= gravity * (float)delta;
-	begY = Math_Floor(p->nextPos.Y);
-	
-	Vec3_Mul1(&velocity, &p->velocity, (float)delta * 3.0f);
-	Vec3_Add(&p->nextPos, &p->nextPos, &velocity);
-	endY = Math_Floor(p->nextPos.Y);
+/* Clips the movement of the given particle against blocks it passed through this tick */
+/* Returns whether the particle collided with terrain */
+static cc_bool ParticlePool_Collide(struct ParticlePool* p, int i, CanPassThroughFunc canPassThrough) {
+	int y, begY, endY;
+	/* lastPos is the position at the start of this tick */
+	begY = Math_Floor(p->lastY[i]);
+	endY = Math_Floor(p->nextY[i]);
+	hitTerrain = false;
 
-	if (p->velocity.Y > 0.0f) {
+	if (p->velY[i] > 0.0f) {
 		/* don't test block we are already in */
-		for (y = begY + 1; y <= endY && ClipY(p, y, false, canPassThrough); y++) {}
+		for (y = begY + 1; y <= endY && ClipY(p, i, y, false, canPassThrough); y++) {}
 	} else {
-		for (y = begY; y >= endY && ClipY(p, y, true, canPassThrough); y--) {}
+		for (y = begY; y >= endY && ClipY(p, i, y, true, canPassThrough); y--) {}
 	}
-
-	p->lifetime -= (float)delta;
-	return p->lifetime < 0.0f;
+	return hitTerrain;
 }
 
 
 /*########################################################################################################################*
 *-------------------------------------------------------Rain particle-----------------------------------------------------*
 *#########################################################################################################################*/
-static struct Particle rain_Particles[PARTICLES_MAX];
-static int rain_count;
+static struct ParticlePool rain;
 static TextureRec rain_rec = { 2.0f/128.0f, 14.0f/128.0f, 5.0f/128.0f, 16.0f/128.0f };
 
 static cc_bool RainParticle_CanPass(BlockID block) {
@@ -135,19 +267,14 @@ static cc_bool RainParticle_CanPass(BlockID block) {
 	return draw == DRAW_GAS || draw == DRAW_SPRITE;
 }
 
-static cc_bool RainParticle_Tick(struct Particle* p, double delta) {
-	hitTerrain = false;
-	return PhysicsTick(p, 3.5f, RainParticle_CanPass, delta) || hitTerrain;
-}
-
-static void RainParticle_Render(struct Particle* p, float t, struct VertexTextured* vertices) {
+static void RainParticle_Render(int i, float t, struct VertexTextured* vertices) {
 	Vec3 pos;
 	Vec2 size;
 	PackedCol col;
 	int x, y, z;
 
-	Vec3_Lerp(&pos, &p->lastPos, &p->nextPos, t);
-	size.X = p->size * 0.015625f; size.Y = size.X;
+	ParticlePool_GetPos(&rain, i, t, &pos);
+	size.X = rain.size[i] * 0.015625f; size.Y = size.X;
 
 	x = Math_Floor(pos.X); y = Math_Floor(pos.Y); z = Math_Floor(pos.Z);
 	col = Lighting_Color(x, y, z);
@@ -157,77 +284,75 @@ static void RainParticle_Render(struct Particle* p, float t, struct VertexTextur
 static void Rain_Render(float t) {
 	struct VertexTextured* data;
 	int i;
-	if (!rain_count) return;
-	
-	data = (struct VertexTextured*)Gfx_LockDynamicVb(Particles_VB, 
-										VERTEX_FORMAT_TEXTURED, rain_count * 4);
-	for (i = 0; i < rain_count; i++) {
-		RainParticle_Render(&rain_Particles[i], t, data);
+	if (!rain.count) return;
+
+	data = (struct VertexTextured*)Gfx_LockDynamicVb(Particles_VB,
+										VERTEX_FORMAT_TEXTURED, rain.count * 4);
+	for (i = 0; i < rain.count; i++) {
+		RainParticle_Render(i, t, data);
 		data += 4;
 	}
 
 	Gfx_BindTexture(Particles_TexId);
 	Gfx_UnlockDynamicVb(Particles_VB);
-	Gfx_DrawVb_IndexedTris(rain_count * 4);
-}
-
-static void Rain_RemoveAt(int i) {
-	for (; i < rain_count - 1; i++) {
-		rain_Particles[i] = rain_Particles[i + 1];
-	}
-	rain_count--;
+	Gfx_DrawVb_IndexedTris(rain.count * 4);
 }
 
 static void Rain_Tick(double delta) {
 	int i;
-	for (i = 0; i < rain_count; i++) {
-		if (RainParticle_Tick(&rain_Particles[i], delta)) {
-			Rain_RemoveAt(i); i--;
+	for (i = 0; i < rain.count; i++) {
+		rain.flags[i] = ParticlePool_BeginTick(&rain, i, RainParticle_CanPass) ? PARTICLE_REMOVE : 0;
+	}
+	ParticlePool_Integrate(&rain, (float)delta);
+
+	for (i = 0; i < rain.count; i++) {
+		if (rain.flags[i]) continue;
+		if (ParticlePool_Collide(&rain, i, RainParticle_CanPass) || rain.lifetime[i] < 0.0f) {
+			rain.flags[i] = PARTICLE_REMOVE;
 		}
 	}
+	ParticlePool_Compact(&rain);
 }
 
 
 /*########################################################################################################################*
 *------------------------------------------------------Terrain particle---------------------------------------------------*
 *#########################################################################################################################*/
-struct TerrainParticle {
-	struct Particle base;
-	TextureRec rec;
-	TextureLoc texLoc;
-	BlockID block;
-};
-
-static struct TerrainParticle terrain_particles[PARTICLES_MAX];
-static int terrain_count;
-static cc_uint16 terrain_1DCount[ATLAS1D_MAX_ATLASES];
-static cc_uint16 terrain_1DIndices[ATLAS1D_MAX_ATLASES];
+static struct ParticlePool terrain;
+static TextureRec* terrain_recs;
+static TextureLoc* terrain_texLocs;
+static BlockID*    terrain_blocks;
+static int terrain_1DCount[ATLAS1D_MAX_ATLASES];
+static int terrain_1DIndices[ATLAS1D_MAX_ATLASES];
 
 static cc_bool TerrainParticle_CanPass(BlockID block) {
 	cc_uint8 draw = Blocks.Draw[block];
 	return draw == DRAW_GAS || draw == DRAW_SPRITE || Blocks.IsLiquid[block];
 }
 
-static cc_bool TerrainParticle_Tick(struct TerrainParticle* p, double delta) {
-	return PhysicsTick(&p->base, Blocks.ParticleGravity[p->block], TerrainParticle_CanPass, delta);
+static void TerrainParticle_Move(int dst, int src) {
+	terrain_recs[dst]    = terrain_recs[src];
+	terrain_texLocs[dst] = terrain_texLocs[src];
+	terrain_blocks[dst]  = terrain_blocks[src];
 }
 
-static void TerrainParticle_Render(struct TerrainParticle* p, float t, struct VertexTextured* vertices) {
+static void TerrainParticle_Render(int i, float t, struct VertexTextured* vertices) {
 	PackedCol col = PACKEDCOL_WHITE;
+	BlockID block = terrain_blocks[i];
 	Vec3 pos;
 	Vec2 size;
 	int x, y, z;
 
-	Vec3_Lerp(&pos, &p->base.lastPos, &p->base.nextPos, t);
-	size.X = p->base.size * 0.015625f; size.Y = size.X;
-	
-	if (!Blocks.FullBright[p->block]) {
+	ParticlePool_GetPos(&terrain, i, t, &pos);
+	size.X = terrain.size[i] * 0.015625f; size.Y = size.X;
+
+	if (!Blocks.FullBright[block]) {
 		x = Math_Floor(pos.X); y = Math_Floor(pos.Y); z = Math_Floor(pos.Z);
 		col = Lighting_Color_XSide(x, y, z);
 	}
 
-	Block_Tint(col, p->block);
-	Particle_DoRender(&size, &pos, &p->rec, col, vertices);
+	Block_Tint(col, block);
+	Particle_DoRender(&size, &pos, &terrain_recs[i], col, vertices);
 }
 
 static void Terrain_Update1DCounts(void) {
@@ -237,8 +362,8 @@ static void Terrain_Update1DCounts(void) {
 		terrain_1DCount[i]   = 0;
 		terrain_1DIndices[i] = 0;
 	}
-	for (i = 0; i < terrain_count; i++) {
-		index = Atlas1D_Index(terrain_particles[i].texLoc);
+	for (i = 0; i < terrain.count; i++) {
+		index = Atlas1D_Index(terrain_texLocs[i]);
 		terrain_1DCount[index] += 4;
 	}
 	for (i = 1; i < Atlas1D.Count; i++) {
@@ -251,16 +376,16 @@ static void Terrain_Render(float t) {
 	struct VertexTextured* ptr;
 	int offset = 0;
 	int i, index;
-	if (!terrain_count) return;
+	if (!terrain.count) return;
 
-	data = (struct VertexTextured*)Gfx_LockDynamicVb(Particles_VB, 
-										VERTEX_FORMAT_TEXTURED, terrain_count * 4);
+	data = (struct VertexTextured*)Gfx_LockDynamicVb(Particles_VB,
+										VERTEX_FORMAT_TEXTURED, terrain.count * 4);
 	Terrain_Update1DCounts();
-	for (i = 0; i < terrain_count; i++) {
-		index = Atlas1D_Index(terrain_particles[i].texLoc);
+	for (i = 0; i < terrain.count; i++) {
+		index = Atlas1D_Index(terrain_texLocs[i]);
 		ptr   = data + terrain_1DIndices[index];
 
-		TerrainParticle_Render(&terrain_particles[i], t, ptr);
+		TerrainParticle_Render(i, t, ptr);
 		terrain_1DIndices[index] += 4;
 	}
 
@@ -275,34 +400,46 @@ static void Terrain_Render(float t) {
 	}
 }
 
-static void Terrain_RemoveAt(int i) {
-	for (; i < terrain_count - 1; i++) {
-		terrain_particles[i] = terrain_particles[i + 1];
-	}
-	terrain_count--;
-}
-
 static void Terrain_Tick(double delta) {
 	int i;
-	for (i = 0; i < terrain_count; i++) {
-		if (TerrainParticle_Tick(&terrain_particles[i], delta)) {
-			Terrain_RemoveAt(i); i--;
-		}
+	for (i = 0; i < terrain.count; i++) {
+		terrain.gravity[i] = Blocks.ParticleGravity[terrain_blocks[i]];
+		terrain.flags[i]   = ParticlePool_BeginTick(&terrain, i, TerrainParticle_CanPass) ? PARTICLE_REMOVE : 0;
 	}
+	ParticlePool_Integrate(&terrain, (float)delta);
+
+	for (i = 0; i < terrain.count; i++) {
+		if (terrain.flags[i]) continue;
+		ParticlePool_Collide(&terrain, i, TerrainParticle_CanPass);
+		if (terrain.lifetime[i] < 0.0f) terrain.flags[i] = PARTICLE_REMOVE;
+	}
+	ParticlePool_Compact(&terrain);
+}
+
+static void Terrain_Alloc(void) {
+	ParticlePool_Alloc(&terrain);
+	terrain.MoveExtra = TerrainParticle_Move;
+
+	terrain_recs    = (TextureRec*)Mem_Alloc(particles_max, sizeof(TextureRec), "terrain particles");
+	terrain_texLocs = (TextureLoc*)Mem_Alloc(particles_max, sizeof(TextureLoc), "terrain particles");
+	terrain_blocks  = (BlockID*)   Mem_Alloc(particles_max, sizeof(BlockID),    "terrain particles");
+}
+
+static void Terrain_Free(void) {
+	ParticlePool_Free(&terrain);
+	Mem_Free(terrain_recs);    terrain_recs    = NULL;
+	Mem_Free(terrain_texLocs); terrain_texLocs = NULL;
+	Mem_Free(terrain_blocks);  terrain_blocks  = NULL;
 }
 
+
 /*########################################################################################################################*
 *-------------------------------------------------------Custom particle---------------------------------------------------*
 *#########################################################################################################################*/
-struct CustomParticle {
-	struct Particle base;
-	int effectId;
-	float totalLifespan;
-};
-
 struct CustomParticleEffect Particles_CustomEffects[256];
-static struct CustomParticle custom_particles[PARTICLES_MAX];
-static int custom_count;
+static struct ParticlePool custom;
+static cc_uint8* custom_effectIds;
+static float* custom_lifespans;
 static cc_uint8 collideFlags;
 #define EXPIRES_UPON_TOUCHING_GROUND (1 << 0)
 #define SOLID_COLLIDES  (1 << 1)
@@ -311,7 +448,7 @@ static cc_uint8 collideFlags;
 
 static cc_bool CustomParticle_CanPass(BlockID block) {
 	cc_uint8 draw, collide;
-	
+
 	draw = Blocks.Draw[block];
 	if (draw == DRAW_TRANSPARENT_THICK && !(collideFlags & LEAF_COLLIDES)) return true;
 
@@ -321,32 +458,28 @@ static cc_bool CustomParticle_CanPass(BlockID block) {
 	return true;
 }
 
-static cc_bool CustomParticle_Tick(struct CustomParticle* p, double delta) {
-	struct CustomParticleEffect* e = &Particles_CustomEffects[p->effectId];
-	hitTerrain   = false;
-	collideFlags = e->collideFlags;
-
-	return PhysicsTick(&p->base, e->gravity, CustomParticle_CanPass, delta)
-		|| (hitTerrain && (e->collideFlags & EXPIRES_UPON_TOUCHING_GROUND));
+static void CustomParticle_Move(int dst, int src) {
+	custom_effectIds[dst] = custom_effectIds[src];
+	custom_lifespans[dst] = custom_lifespans[src];
 }
 
-static void CustomParticle_Render(struct CustomParticle* p, float t, struct VertexTextured* vertices) {
-	struct CustomParticleEffect* e = &Particles_CustomEffects[p->effectId];
+static void CustomParticle_Render(int i, float t, struct VertexTextured* vertices) {
+	struct CustomParticleEffect* e = &Particles_CustomEffects[custom_effectIds[i]];
 	Vec3 pos;
 	Vec2 size;
 	PackedCol col;
 	TextureRec rec = e->rec;
 	int x, y, z;
 
-	float time_lived = p->totalLifespan - p->base.lifetime;
-	int curFrame = Math_Floor(e->frameCount * (time_lived / p->totalLifespan));
+	float time_lived = custom_lifespans[i] - custom.lifetime[i];
+	int curFrame = Math_Floor(e->frameCount * (time_lived / custom_lifespans[i]));
 	float shiftU = curFrame * (rec.U2 - rec.U1);
 
 	rec.U1 += shiftU;/* * 0.0078125f; */
 	rec.U2 += shiftU;/* * 0.0078125f; */
 
-	Vec3_Lerp(&pos, &p->base.lastPos, &p->base.nextPos, t);
-	size.X = p->base.size; size.Y = size.X;
+	ParticlePool_GetPos(&custom, i, t, &pos);
+	size.X = custom.size[i]; size.Y = size.X;
 
 	x = Math_Floor(pos.X); y = Math_Floor(pos.Y); z = Math_Floor(pos.Z);
 	col = e->fullBright ? PACKEDCOL_WHITE : Lighting_Color(x, y, z);
@@ -358,34 +491,59 @@ static void CustomParticle_Render(struct CustomParticle* p, float t, struct Vert
 static void Custom_Render(float t) {
 	struct VertexTextured* data;
 	int i;
-	if (!custom_count) return;
+	if (!custom.count) return;
 
-	data = (struct VertexTextured*)Gfx_LockDynamicVb(Particles_VB, 
-										VERTEX_FORMAT_TEXTURED, custom_count * 4);
-	for (i = 0; i < custom_count; i++) {
-		CustomParticle_Render(&custom_particles[i], t, data);
+	data = (struct VertexTextured*)Gfx_LockDynamicVb(Particles_VB,
+										VERTEX_FORMAT_TEXTURED, custom.count * 4);
+	for (i = 0; i < custom.count; i++) {
+		CustomParticle_Render(i, t, data);
 		data += 4;
 	}
 
 	Gfx_BindTexture(Particles_TexId);
 	Gfx_UnlockDynamicVb(Particles_VB);
-	Gfx_DrawVb_IndexedTris(custom_count * 4);
-}
-
-static void Custom_RemoveAt(int i) {
-	for (; i < custom_count - 1; i++) {
-		custom_particles[i] = custom_particles[i + 1];
-	}
-	custom_count--;
+	Gfx_DrawVb_IndexedTris(custom.count * 4);
 }
 
 static void Custom_Tick(double delta) {
+	struct CustomParticleEffect* e;
 	int i;
-	for (i = 0; i < custom_count; i++) {
-		if (CustomParticle_Tick(&custom_particles[i], delta)) {
-			Custom_RemoveAt(i); i--;
+
+	for (i = 0; i < custom.count; i++) {
+		e = &Particles_CustomEffects[custom_effectIds[i]];
+		collideFlags = e->collideFlags;
+
+		custom.gravity[i] = e->gravity;
+		custom.flags[i]   = ParticlePool_BeginTick(&custom, i, CustomParticle_CanPass) ? PARTICLE_REMOVE : 0;
+	}
+	ParticlePool_Integrate(&custom, (float)delta);
+
+	for (i = 0; i < custom.count; i++) {
+		if (custom.flags[i]) continue;
+		e = &Particles_CustomEffects[custom_effectIds[i]];
+		collideFlags = e->collideFlags;
+
+		if (ParticlePool_Collide(&custom, i, CustomParticle_CanPass) && (e->collideFlags & EXPIRES_UPON_TOUCHING_GROUND)) {
+			custom.flags[i] = PARTICLE_REMOVE;
+		} else if (custom.lifetime[i] < 0.0f) {
+			custom.flags[i] = PARTICLE_REMOVE;
 		}
 	}
+	ParticlePool_Compact(&custom);
+}
+
+static void Custom_Alloc(void) {
+	ParticlePool_Alloc(&custom);
+	custom.MoveExtra = CustomParticle_Move;
+
+	custom_effectIds = (cc_uint8*)Mem_Alloc(particles_max, 1,             "custom particles");
+	custom_lifespans = (float*)   Mem_Alloc(particles_max, sizeof(float), "custom particles");
+}
+
+static void Custom_Free(void) {
+	ParticlePool_Free(&custom);
+	Mem_Free(custom_effectIds); custom_effectIds = NULL;
+	Mem_Free(custom_lifespans); custom_lifespans = NULL;
 }
 
 
@@ -393,7 +551,7 @@ static void Custom_Tick(double delta) {
 *--------------------------------------------------------Particles--------------------------------------------------------*
 *#########################################################################################################################*/
 void Particles_Render(float t) {
-	if (!terrain_count && !rain_count && !custom_count) return;
+	if (!terrain.count && !rain.count && !custom.count) return;
 	if (Gfx.LostContext) return;
 
 	Gfx_SetTexturing(true);
@@ -410,13 +568,57 @@ void Particles_Render(float t) {
 
 static void Particles_Tick(struct ScheduledTask* task) {
 	double delta = task->interval;
+	cc_uint64 beg = Stopwatch_Measure();
+
 	Terrain_Tick(delta);
 	Rain_Tick(delta);
 	Custom_Tick(delta);
+
+	tick_elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+	tick_peak    = max(tick_peak, tick_elapsed);
+}
+
+void Particles_GetStats(struct ParticleStats* stats) {
+	stats->RainCount    = rain.count;
+	stats->TerrainCount = terrain.count;
+	stats->CustomCount  = custom.count;
+	stats->MaxCount     = particles_max;
+	stats->TickTime     = (int)tick_elapsed;
+	stats->TickPeak     = (int)tick_peak;
+}
+
+#define GRID_SIZE 4
+/* gridOffset gives the centre of the cell on a grid */
+#define CELL_CENTRE ((1.0f / GRID_SIZE) * 0.5f)
+
+static void Particles_GetCell(int x, int y, int z, Vec3* cell) {
+	cell->X = CELL_CENTRE     + (float)x / GRID_SIZE;
+	cell->Y = CELL_CENTRE / 2 + (float)y / GRID_SIZE;
+	cell->Z = CELL_CENTRE     + (float)z / GRID_SIZE;
+}
+
+static cc_bool Particles_CellInside(const Vec3* cell, const Vec3* minBB, const Vec3* maxBB) {
+	return cell->X >= minBB->X && cell->X <= maxBB->X && cell->Y >= minBB->Y
+		&& cell->Y <= maxBB->Y && cell->Z >= minBB->Z && cell->Z <= maxBB->Z;
+}
+
+/* Returns number of cells in the 4x4x4 grid of a block that a particle is spawned from */
+static int Particles_CountCells(const Vec3* minBB, const Vec3* maxBB) {
+	int x, y, z, count = 0;
+	Vec3 cell;
+
+	for (x = 0; x < GRID_SIZE; x++) {
+		for (y = 0; y < GRID_SIZE; y++) {
+			for (z = 0; z < GRID_SIZE; z++) {
+				Particles_GetCell(x, y, z, &cell);
+				if (Particles_CellInside(&cell, minBB, maxBB)) count++;
+			}
+		}
+	}
+	return count;
 }
 
 void Particles_BreakBlockEffect(IVec3 coords, BlockID old, BlockID now) {
-	struct TerrainParticle* p;
 	TextureLoc loc;
 	int texIndex;
 	TextureRec baseRec, rec;
@@ -427,16 +629,16 @@ void Particles_BreakBlockEffect(IVec3 coords, BlockID old, BlockID now) {
 	int minX, minZ, maxX, maxZ;
 	int minU, minV, maxU, maxV;
 	int maxUsedU, maxUsedV;
-	
+
 	/* per-particle variables */
 	float cellX, cellY, cellZ;
 	Vec3 cell;
-	int x, y, z, type;
+	int x, y, z, i, type;
 
 	if (now != BLOCK_AIR || Blocks.Draw[old] == DRAW_GAS) return;
 	IVec3_ToVec3(&origin, &coords);
 	loc = Block_Tex(old, FACE_XMIN);
-	
+
 	baseRec = Atlas1D_TexRec(loc, 1, &texIndex);
 	uScale  = (1.0f/16.0f); vScale = (1.0f/16.0f) * Atlas1D.InvTileSize;
 
@@ -451,9 +653,8 @@ void Particles_BreakBlockEffect(IVec3 coords, BlockID old, BlockID now) {
 	if (minU < 12 && maxU > 12) maxUsedU = 12;
 	if (minV < 12 && maxV > 12) maxUsedV = 12;
 
-	#define GRID_SIZE 4
-	/* gridOffset gives the centre of the cell on a grid */
-	#define CELL_CENTRE ((1.0f / GRID_SIZE) * 0.5f)
+	/* Make room for all the new particles at once, instead of removing the oldest one by one */
+	ParticlePool_Reserve(&terrain, Particles_CountCells(&minBB, &maxBB));
 
 	maxU2 = baseRec.U1 + maxU * uScale;
 	maxV2 = baseRec.V1 + maxV * vScale;
@@ -461,18 +662,15 @@ void Particles_BreakBlockEffect(IVec3 coords, BlockID old, BlockID now) {
 		for (y = 0; y < GRID_SIZE; y++) {
 			for (z = 0; z < GRID_SIZE; z++) {
 
+				Particles_GetCell(x, y, z, &cell);
+				if (!Particles_CellInside(&cell, &minBB, &maxBB)) continue;
 				cellX = (float)x / GRID_SIZE; cellY = (float)y / GRID_SIZE; cellZ = (float)z / GRID_SIZE;
-				cell  = Vec3_Create3(CELL_CENTRE + cellX, CELL_CENTRE / 2 + cellY, CELL_CENTRE + cellZ);
-				if (cell.X < minBB.X || cell.X > maxBB.X || cell.Y < minBB.Y
-					|| cell.Y > maxBB.Y || cell.Z < minBB.Z || cell.Z > maxBB.Z) continue;
-
-				if (terrain_count == PARTICLES_MAX) Terrain_RemoveAt(0);
-				p = &terrain_particles[terrain_count++];
 
+				i = ParticlePool_Spawn(&terrain);
 				/* centre random offset around [-0.2, 0.2] */
-				p->base.velocity.X = CELL_CENTRE + (cellX - 0.5f) + (Random_Float(&rnd) * 0.4f - 0.2f);
-				p->base.velocity.Y = CELL_CENTRE + (cellY - 0.0f) + (Random_Float(&rnd) * 0.4f - 0.2f);
-				p->base.velocity.Z = CELL_CENTRE + (cellZ - 0.5f) + (Random_Float(&rnd) * 0.4f - 0.2f);
+				terrain.velX[i] = CELL_CENTRE + (cellX - 0.5f) + (Random_Float(&rnd) * 0.4f - 0.2f);
+				terrain.velY[i] = CELL_CENTRE + (cellY - 0.0f) + (Random_Float(&rnd) * 0.4f - 0.2f);
+				terrain.velZ[i] = CELL_CENTRE + (cellZ - 0.5f) + (Random_Float(&rnd) * 0.4f - 0.2f);
 
 				rec = baseRec;
 				rec.U1 = baseRec.U1 + Random_Range(&rnd, minU, maxUsedU) * uScale;
@@ -481,56 +679,60 @@ void Particles_BreakBlockEffect(IVec3 coords, BlockID old, BlockID now) {
 				rec.V2 = rec.V1 + 4 * vScale;
 				rec.U2 = min(rec.U2, maxU2) - 0.01f * uScale;
 				rec.V2 = min(rec.V2, maxV2) - 0.01f * vScale;
-		
-				Vec3_Add(&p->base.lastPos, &origin, &cell);
-				p->base.nextPos  = p->base.lastPos;
-				p->base.lifetime = 0.3f + Random_Float(&rnd) * 1.2f;
-
-				p->rec    = rec;
-				p->texLoc = loc;
-				p->block  = old;
+
+				terrain.lastX[i] = origin.X + cell.X; terrain.nextX[i] = terrain.lastX[i];
+				terrain.lastY[i] = origin.Y + cell.Y; terrain.nextY[i] = terrain.lastY[i];
+				terrain.lastZ[i] = origin.Z + cell.Z; terrain.nextZ[i] = terrain.lastZ[i];
+				terrain.lifetime[i] = 0.3f + Random_Float(&rnd) * 1.2f;
+
+				terrain_recs[i]    = rec;
+				terrain_texLocs[i] = loc;
+				terrain_blocks[i]  = old;
 				type = Random_Next(&rnd, 30);
-				p->base.size = type >= 28 ? 12 : (type >= 25 ? 10 : 8);
+				terrain.size[i] = type >= 28 ? 12 : (type >= 25 ? 10 : 8);
 			}
 		}
 	}
 }
 
 void Particles_RainSnowEffect(float x, float y, float z) {
-	struct Particle* p;
-	int i, type;
+	int i, j, type;
+	ParticlePool_Reserve(&rain, 2);
 
-	for (i = 0; i < 2; i++) {
-		if (rain_count == PARTICLES_MAX) Rain_RemoveAt(0);
-		p = &rain_Particles[rain_count++];
+	for (j = 0; j < 2; j++) {
+		i = ParticlePool_Spawn(&rain);
+		rain.velX[i] = Random_Float(&rnd) * 0.8f - 0.4f; /* [-0.4, 0.4] */
+		rain.velZ[i] = Random_Float(&rnd) * 0.8f - 0.4f;
+		rain.velY[i] = Random_Float(&rnd) + 0.4f;
 
-		p->velocity.X = Random_Float(&rnd) * 0.8f - 0.4f; /* [-0.4, 0.4] */
-		p->velocity.Z = Random_Float(&rnd) * 0.8f - 0.4f;
-		p->velocity.Y = Random_Float(&rnd) + 0.4f;
+		rain.lastX[i] = x + Random_Float(&rnd); /* [0.0, 1.0] */
+		rain.lastY[i] = y + Random_Float(&rnd) * 0.1f + 0.01f;
+		rain.lastZ[i] = z + Random_Float(&rnd);
 
-		p->lastPos.X = x + Random_Float(&rnd); /* [0.0, 1.0] */
-		p->lastPos.Y = y + Random_Float(&rnd) * 0.1f + 0.01f;
-		p->lastPos.Z = z + Random_Float(&rnd);
-
-		p->nextPos  = p->lastPos;
-		p->lifetime = 40.0f;
+		rain.nextX[i]    = rain.lastX[i];
+		rain.nextY[i]    = rain.lastY[i];
+		rain.nextZ[i]    = rain.lastZ[i];
+		rain.lifetime[i] = 40.0f;
+		rain.gravity[i]  = 3.5f;
 
 		type = Random_Next(&rnd, 30);
-		p->size = type >= 28 ? 2 : (type >= 25 ? 4 : 3);
+		rain.size[i] = type >= 28 ? 2 : (type >= 25 ? 4 : 3);
 	}
 }
 
 void Particles_CustomEffect(int effectID, float x, float y, float z, float originX, float originY, float originZ) {
-	struct CustomParticle* p;
 	struct CustomParticleEffect* e = &Particles_CustomEffects[effectID];
-	int i, count = e->particleCount;
-	Vec3 offset, delta;
+	int i, j, count = e->particleCount;
+	Vec3 offset, delta, pos;
+	Vec3 origin;
 	float d;
 
-	for (i = 0; i < count; i++) {
-		if (custom_count == PARTICLES_MAX) Custom_RemoveAt(0);
-		p = &custom_particles[custom_count++];
-		p->effectId = effectID;
+	origin.X = originX; origin.Y = originY; origin.Z = originZ;
+	ParticlePool_Reserve(&custom, count);
+
+	for (j = 0; j < count; j++) {
+		i = ParticlePool_Spawn(&custom);
+		custom_effectIds[i] = (cc_uint8)effectID;
 
 		offset.X = Random_Float(&rnd) - 0.5f;
 		offset.Y = Random_Float(&rnd) - 0.5f;
@@ -543,28 +745,30 @@ void Particles_CustomEffect(int effectID, float x, float y, float z, float origi
 		d  = Math_Exp(Math_Log(d) / 3.0); /* d^1/3 for better distribution */
 		d *= e->spread;
 
-		p->base.lastPos.X = x + offset.X * d;
-		p->base.lastPos.Y = y + offset.Y * d;
-		p->base.lastPos.Z = z + offset.Z * d;
-		
-		Vec3 origin = { originX, originY, originZ };
-		Vec3_Sub(&delta, &p->base.lastPos, &origin);
+		pos.X = x + offset.X * d;
+		pos.Y = y + offset.Y * d;
+		pos.Z = z + offset.Z * d;
+
+		Vec3_Sub(&delta, &pos, &origin);
 		Vec3_Normalise(&delta);
 
-		p->base.velocity.X = delta.X * e->speed;
-		p->base.velocity.Y = delta.Y * e->speed;
-		p->base.velocity.Z = delta.Z * e->speed;
+		custom.velX[i] = delta.X * e->speed;
+		custom.velY[i] = delta.Y * e->speed;
+		custom.velZ[i] = delta.Z * e->speed;
 
-		p->base.nextPos  = p->base.lastPos;
-		p->base.lifetime = e->baseLifetime + (e->baseLifetime * e->lifetimeVariation) * ((Random_Float(&rnd) - 0.5f) * 2);
-		p->totalLifespan = p->base.lifetime;
+		custom.lastX[i] = pos.X; custom.nextX[i] = pos.X;
+		custom.lastY[i] = pos.Y; custom.nextY[i] = pos.Y;
+		custom.lastZ[i] = pos.Z; custom.nextZ[i] = pos.Z;
+		custom.lifetime[i] = e->baseLifetime + (e->baseLifetime * e->lifetimeVariation) * ((Random_Float(&rnd) - 0.5f) * 2);
+		custom_lifespans[i] = custom.lifetime[i];
+		custom.gravity[i]   = e->gravity;
 
-		p->base.size = e->size + (e->size * e->sizeVariation) * ((Random_Float(&rnd) - 0.5f) * 2);
+		custom.size[i] = e->size + (e->size * e->sizeVariation) * ((Random_Float(&rnd) - 0.5f) * 2);
 
 		/* Don't spawn custom particle inside a block (otherwise it appears */
 		/*   for a few frames, then disappears in first PhysicsTick call)*/
 		collideFlags = e->collideFlags;
-		if (IntersectsBlock(&p->base, CustomParticle_CanPass)) custom_count--;
+		if (IntersectsBlock(&custom, i, CustomParticle_CanPass)) custom.count--;
 	}
 }
 
@@ -579,7 +783,7 @@ static void OnContextLost(void* obj) {
 	Gfx_DeleteTexture(&Particles_TexId);
 }
 static void OnContextRecreated(void* obj) {
-	Gfx_RecreateDynamicVb(&Particles_VB, VERTEX_FORMAT_TEXTURED, PARTICLES_MAX * 4);
+	Gfx_RecreateDynamicVb(&Particles_VB, VERTEX_FORMAT_TEXTURED, particles_max * 4);
 }
 static void OnBreakBlockEffect_Handler(void* obj, IVec3 coords, BlockID old, BlockID now) {
 	Particles_BreakBlockEffect(coords, old, now);
@@ -592,7 +796,13 @@ static void OnFileChanged(void* obj, struct Stream* stream, const cc_string* nam
 }
 
 static void OnInit(void) {
-	ScheduledTask_Add(GAME_DEF_TICKS, Particles_Tick);
+	particles_max = Options_GetInt(OPT_MAX_PARTICLES, PARTICLES_MIN_MAX, PARTICLES_MAX_LIMIT, PARTICLES_DEF_MAX);
+	ParticlePool_Alloc(&rain);
+	Terrain_Alloc();
+	Custom_Alloc();
+
+	ScheduledTask_AddEx("Particles_Tick", GAME_DEF_TICKS, Particles_Tick,
+						TASK_PRIORITY_LOW, 0, TASK_FLAG_TICK_THREAD);
 	Random_SeedFromCurrentTime(&rnd);
 	OnContextRecreated(NULL);	
 
@@ -602,9 +812,14 @@ static void OnInit(void) {
 	Event_Register_(&GfxEvents.ContextRecreated, NULL, OnContextRecreated);
 }
 
-static void OnFree(void) { OnContextLost(NULL); }
+static void OnFree(void) {
+	OnContextLost(NULL);
+	ParticlePool_Free(&rain);
+	Terrain_Free();
+	Custom_Free();
+}
 
-static void OnReset(void) { rain_count = 0; terrain_count = 0; custom_count = 0; }
+static void OnReset(void) { rain.count = 0; terrain.count = 0; custom.count = 0; }
 
 struct IGameComponent Particles_Component = {
 	OnInit,  /* Init  */
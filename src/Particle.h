@@ -11,11 +11,10 @@ struct VertexTextured;
 struct ScheduledTask;
 extern struct IGameComponent Particles_Component;
 
-struct Particle {
-	Vec3 velocity;
-	float lifetime;
-	Vec3 lastPos, nextPos;
-	float size;
+struct ParticleStats {
+	int RainCount, TerrainCount, CustomCount; /* Number of particles of each type currently alive */
+	int MaxCount; /* Maximum number of particles of each type that can be alive at once */
+	int TickTime, TickPeak; /* Time (in microseconds) taken by the last and slowest particle ticks */
 };
 
 struct CustomParticleEffect {
@@ -42,4 +41,5 @@ void Particles_Render(float t);
 void Particles_BreakBlockEffect(IVec3 coords, BlockID oldBlock, BlockID block);
 void Particles_RainSnowEffect(float x, float y, float z);
 void Particles_CustomEffect(int effectID, float x, float y, float z, float originX, float originY, float originZ);
+void Particles_GetStats(struct ParticleStats* stats);
 #endif
@@ -7,6 +7,8 @@
 #include "Funcs.h"
 #include "Logger.h"
 #include "Entity.h"
+#include "Event.h"
+#include "Game.h"
 
 
 /*########################################################################################################################*
@@ -149,17 +151,184 @@ static void Searcher_QuickSort(int left, int right) {
 	}
 }
 
+/* Which blocks in each 16x16x16 chunk have solid collision, so searching for reachable blocks */
+/*  can skip over chunks without any solid blocks and not have to check every single block */
+/* Each chunk is only built when first searched, and then kept up to date as blocks change */
+#define SOLID_UNBUILT 0xFFFF
+static cc_uint16* solidCounts;    /* Number of solid blocks in each chunk, or SOLID_UNBUILT */
+static cc_uint16** solidRows;     /* Per chunk solid bits, for each [y][z] row, bit x */
+static cc_uint16 solidAllRows[CHUNK_SIZE_2]; /* Shared by chunks that are completely solid */
+static int solidChunksX, solidChunksY, solidChunksZ;
+static BlockRaw* solidBlocks; /* World.Blocks when cache was created */
+
+#define SolidCache_Index(cx, cy, cz) (((cy) * solidChunksZ + (cz)) * solidChunksX + (cx))
+#define SolidCache_IsSolid(block) (Blocks.Collide[block] == COLLIDE_SOLID)
+
+static void SolidCache_Free(void) {
+	int i, count = solidChunksX * solidChunksY * solidChunksZ;
+	if (solidRows) {
+		for (i = 0; i < count; i++) {
+			if (solidRows[i] != solidAllRows) Mem_Free(solidRows[i]);
+		}
+	}
+
+	Mem_Free(solidCounts); solidCounts = NULL;
+	Mem_Free(solidRows);   solidRows   = NULL;
+	solidChunksX = 0; solidChunksY = 0; solidChunksZ = 0;
+}
+
+static cc_bool SolidCache_Init(void) {
+	int i, count;
+	solidChunksX = (World.Width  + CHUNK_MAX) >> CHUNK_SHIFT;
+	solidChunksY = (World.Height + CHUNK_MAX) >> CHUNK_SHIFT;
+	solidChunksZ = (World.Length + CHUNK_MAX) >> CHUNK_SHIFT;
+	count        = solidChunksX * solidChunksY * solidChunksZ;
+
+	solidCounts = (cc_uint16*)Mem_TryAlloc(count, sizeof(cc_uint16));
+	solidRows   = (cc_uint16**)Mem_TryAllocCleared(count, sizeof(cc_uint16*));
+	Mem_SetPlace(solidCounts, "solid cache");
+	Mem_SetPlace(solidRows,   "solid cache");
+	if (!solidCounts || !solidRows) { SolidCache_Free(); return false; }
+
+	solidBlocks = World.Blocks;
+	for (i = 0; i < count; i++)        solidCounts[i]  = SOLID_UNBUILT;
+	for (i = 0; i < CHUNK_SIZE_2; i++) solidAllRows[i] = 0xFFFF;
+	return true;
+}
+
+/* Calculates which blocks in the given chunk are solid */
+static void SolidCache_Build(int cx, int cy, int cz, int index) {
+	cc_uint16 rows[CHUNK_SIZE_2];
+	int x, y, z, x1 = cx << CHUNK_SHIFT, y1 = cy << CHUNK_SHIFT, z1 = cz << CHUNK_SHIFT;
+	int x2 = min(x1 + CHUNK_SIZE, World.Width), y2 = min(y1 + CHUNK_SIZE, World.Height), z2 = min(z1 + CHUNK_SIZE, World.Length);
+	cc_uint16 row;
+	int count = 0;
+
+	for (y = y1; y < y2; y++) {
+		for (z = z1; z < z2; z++) {
+			row = 0;
+			for (x = x1; x < x2; x++) {
+				if (!SolidCache_IsSolid(World_GetBlock(x, y, z))) continue;
+				row |= 1 << (x - x1); count++;
+			}
+			rows[((y - y1) << CHUNK_SHIFT) | (z - z1)] = row;
+		}
+	}
+
+	if (count == CHUNK_SIZE_3) {
+		solidRows[index] = solidAllRows;
+	} else if (count) {
+		solidRows[index] = (cc_uint16*)Mem_TryAllocCleared(CHUNK_SIZE_2, sizeof(cc_uint16));
+		Mem_SetPlace(solidRows[index], "solid cache");
+		/* Not enough memory to cache this chunk, so just check every block in it */
+		if (!solidRows[index]) { solidRows[index] = solidAllRows; count = CHUNK_SIZE_3; }
+		else Mem_Copy(solidRows[index], rows, sizeof(rows));
+	}
+	solidCounts[index] = count;
+}
+
+void Searcher_OnBlockChanged(int x, int y, int z, BlockID old, BlockID now) {
+	int index, bit;
+	cc_uint16* row;
+	if (!solidCounts || SolidCache_IsSolid(old) == SolidCache_IsSolid(now)) return;
+
+	index = SolidCache_Index(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
+	if (solidCounts[index] == SOLID_UNBUILT) return;
+
+	/* Chunk is completely solid or empty, so would need to allocate rows */
+	if (!solidRows[index] || solidRows[index] == solidAllRows) {
+		solidRows[index]   = NULL;
+		solidCounts[index] = SOLID_UNBUILT; return;
+	}
+
+	row = &solidRows[index][((y & CHUNK_MASK) << CHUNK_SHIFT) | (z & CHUNK_MASK)];
+	bit = 1 << (x & CHUNK_MASK);
+	if (SolidCache_IsSolid(now)) {
+		*row |= bit;  solidCounts[index]++;
+	} else {
+		*row &= ~bit; solidCounts[index]--;
+	}
+}
+
+static void SolidCache_Reset(void)          { SolidCache_Free(); }
+static void SolidCache_BlockDefChanged(void* obj) { SolidCache_Free(); }
+
+static void SolidCache_ComponentInit(void) {
+	Event_Register_(&BlockEvents.BlockDefChanged, NULL, SolidCache_BlockDefChanged);
+}
+
+struct IGameComponent Searcher_Component = {
+	SolidCache_ComponentInit, /* Init  */
+	SolidCache_Free,          /* Free  */
+	SolidCache_Reset,         /* Reset */
+	SolidCache_Reset          /* OnNewMap */
+};
+
+static struct SearcherState* curState;
+static Vec3 searchVel;
+static struct AABB* searchBB;
+static struct AABB* searchExtentBB;
+
+static void Searcher_AddBlock(int x, int y, int z, BlockID block) {
+	struct AABB blockBB;
+	float xx, yy, zz, tx, ty, tz;
+
+	xx = (float)x; yy = (float)y; zz = (float)z;
+	blockBB.Min = Blocks.MinBB[block];
+	blockBB.Min.X += xx; blockBB.Min.Y += yy; blockBB.Min.Z += zz;
+	blockBB.Max = Blocks.MaxBB[block];
+	blockBB.Max.X += xx; blockBB.Max.Y += yy; blockBB.Max.Z += zz;
+
+	if (!AABB_Intersects(searchExtentBB, &blockBB)) return; /* necessary for non whole blocks. (slabs) */
+	Searcher_CalcTime(&searchVel, searchBB, &blockBB, &tx, &ty, &tz);
+	if (tx > 1.0f || ty > 1.0f || tz > 1.0f) return;
+
+	curState->X = (x << 3) | (block  & 0x007);
+	curState->Y = (y << 4) | ((block & 0x078) >> 3);
+	curState->Z = (z << 3) | ((block & 0x380) >> 7);
+	curState->tSquared = tx * tx + ty * ty + tz * tz;
+	curState++;
+}
+
+/* Checks every block in the given row, for parts of rows outside the map */
+static void Searcher_FindInRow(int x1, int x2, int y, int z) {
+	BlockID block;
+	int x;
+
+	for (x = x1; x <= x2; x++) {
+		block = World_GetPhysicsBlock(x, y, z);
+		if (Blocks.Collide[block] != COLLIDE_SOLID) continue;
+		Searcher_AddBlock(x, y, z, block);
+	}
+}
+
+/* Checks only the solid blocks in the given row, for parts of rows inside the map */
+static void Searcher_FindInCachedRow(int x1, int x2, int y, int z) {
+	int cx, cy = y >> CHUNK_SHIFT, cz = z >> CHUNK_SHIFT;
+	int x, index, rowIndex = ((y & CHUNK_MASK) << CHUNK_SHIFT) | (z & CHUNK_MASK);
+	cc_uint16 row;
+
+	for (cx = x1 >> CHUNK_SHIFT; cx <= (x2 >> CHUNK_SHIFT); cx++) {
+		index = SolidCache_Index(cx, cy, cz);
+		if (solidCounts[index] == SOLID_UNBUILT) SolidCache_Build(cx, cy, cz, index);
+		if (!solidCounts[index]) continue;
+
+		/* Only consider blocks from x1 to x2 */
+		x   = max(x1, cx << CHUNK_SHIFT);
+		row = solidRows[index][rowIndex] >> (x & CHUNK_MASK);
+		if (cx == (x2 >> CHUNK_SHIFT)) row &= 0xFFFF >> (CHUNK_MAX - (x2 & CHUNK_MASK) + (x & CHUNK_MASK));
+
+		for (; row; row >>= 1, x++) {
+			if (row & 1) Searcher_AddBlock(x, y, z, World_GetBlock(x, y, z));
+		}
+	}
+}
+
 int Searcher_FindReachableBlocks(struct Entity* entity, struct AABB* entityBB, struct AABB* entityExtentBB) {
 	Vec3 vel = entity->Velocity;
 	IVec3 min, max;
 	cc_uint32 elements;
-	struct SearcherState* curState;
-	int count;
-
-	BlockID block;
-	struct AABB blockBB;
-	float xx, yy, zz, tx, ty, tz;
-	int x, y, z;
+	int count, x1, x2, y, z;
 
 	Entity_GetBounds(entity, entityBB);
 	/* Exact maximum extent the entity can reach, and the equivalent map coordinates. */
@@ -180,31 +349,34 @@ int Searcher_FindReachableBlocks(struct Entity* entity, struct AABB* entityBB, s
 		searcherCapacity = elements;
 		Searcher_States  = (struct SearcherState*)Mem_Alloc(elements, sizeof(struct SearcherState), "collision search states");
 	}
-	curState = Searcher_States;
+	if (solidCounts && solidBlocks != World.Blocks) SolidCache_Free();
+	if (!solidCounts && World.Blocks) SolidCache_Init();
+
+	curState  = Searcher_States;
+	searchVel = vel;
+	searchBB  = entityBB; searchExtentBB = entityExtentBB;
 
 	/* Order loops so that we minimise cache misses */
+	/* NOTE: Blocks must be found in the same order as checking every block, */
+	/*  since quicksort isn't stable and so order affects collision results */
 	for (y = min.Y; y <= max.Y; y++) {
 		for (z = min.Z; z <= max.Z; z++) {
-			for (x = min.X; x <= max.X; x++) {
-				block = World_GetPhysicsBlock(x, y, z);
-				if (Blocks.Collide[block] != COLLIDE_SOLID) continue;
-
-				xx = (float)x; yy = (float)y; zz = (float)z;
-				blockBB.Min = Blocks.MinBB[block];
-				blockBB.Min.X += xx; blockBB.Min.Y += yy; blockBB.Min.Z += zz;
-				blockBB.Max = Blocks.MaxBB[block];
-				blockBB.Max.X += xx; blockBB.Max.Y += yy; blockBB.Max.Z += zz;
-
-				if (!AABB_Intersects(entityExtentBB, &blockBB)) continue; /* necessary for non whole blocks. (slabs) */
-				Searcher_CalcTime(&vel, entityBB, &blockBB, &tx, &ty, &tz);
-				if (tx > 1.0f || ty > 1.0f || tz > 1.0f) continue;
-
-				curState->X = (x << 3) | (block  & 0x007);
-				curState->Y = (y << 4) | ((block & 0x078) >> 3);
-				curState->Z = (z << 3) | ((block & 0x380) >> 7);
-				curState->tSquared = tx * tx + ty * ty + tz * tz;
-				curState++;
+			if (!solidCounts || y < 0 || !World_ContainsXZ(0, z)) {
+				Searcher_FindInRow(min.X, max.X, y, z); continue;
+			}
+
+			/* Only the part of the row inside the map can use the cache */
+			Searcher_FindInRow(min.X, min(max.X, -1), y, z);
+			if (max.X >= 0 && min.X < World.Width) {
+				x1 = max(min.X, 0); x2 = min(max.X, World.MaxX);
+
+				if (y < World.Height) {
+					Searcher_FindInCachedRow(x1, x2, y, z);
+				} else if (Blocks.Collide[BLOCK_AIR] == COLLIDE_SOLID) {
+					Searcher_FindInRow(x1, x2, y, z); /* above the map is all air */
+				}
 			}
+			Searcher_FindInRow(max(min.X, World.Width), max.X, y, z);
 		}
 	}
 
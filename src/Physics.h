@@ -8,6 +8,7 @@
    Copyright 2014-2021 ClassiCube | Licensed under BSD-3
 */
 struct Entity;
+struct IGameComponent;
 
 /* Descibes an axis aligned bounding box. */
 struct AABB { Vec3 Min, Max; };
@@ -36,4 +37,7 @@ extern struct SearcherState* Searcher_States;
 int Searcher_FindReachableBlocks(struct Entity* entity, struct AABB* entityBB, struct AABB* entityExtentBB);
 void Searcher_CalcTime(Vec3* vel, struct AABB *entityBB, struct AABB* blockBB, float* tx, float* ty, float* tz);
 void Searcher_Free(void);
+/* Updates cached solid blocks, so that searching for reachable blocks remains correct. */
+void Searcher_OnBlockChanged(int x, int y, int z, BlockID old, BlockID now);
+extern struct IGameComponent Searcher_Component;
 #endif
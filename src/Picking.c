@@ -151,8 +151,57 @@ static BlockID Picking_GetOutside(int x, int y, int z, IVec3 origin) {
 	return BLOCK_AIR;
 }
 
+/* Whether every block of the given chunk is within reach of the ray's origin */
+static cc_bool Picking_ChunkInReach(const Vec3* origin, int cx, int cy, int cz, float reachSq) {
+	float x1 = (float)(cx * CHUNK_SIZE), x2 = x1 + CHUNK_SIZE;
+	float y1 = (float)(cy * CHUNK_SIZE), y2 = y1 + CHUNK_SIZE;
+	float z1 = (float)(cz * CHUNK_SIZE), z2 = z1 + CHUNK_SIZE;
+	float dx = max(Math_AbsF(origin->X - x1), Math_AbsF(origin->X - x2));
+	float dy = max(Math_AbsF(origin->Y - y1), Math_AbsF(origin->Y - y2));
+	float dz = max(Math_AbsF(origin->Z - z1), Math_AbsF(origin->Z - z2));
+	return dx * dx + dy * dy + dz * dz <= reachSq;
+}
+
+/* Whether Picking_GetInside only returns gas blocks for all blocks in the given chunk */
+static cc_bool Picking_IsEmptyChunk(int cx, int cy, int cz) {
+	int x1 = cx * CHUNK_SIZE, y1 = cy * CHUNK_SIZE, z1 = cz * CHUNK_SIZE;
+	int x2 = x1 + CHUNK_MAX,    z2 = z1 + CHUNK_MAX;
+	if (y1 < 0) return false;
+
+	/* Outside the map horizontally, there is only the border below sides height */
+	if (x1 < 0 || z1 < 0 || x2 >= World.Width || z2 >= World.Length) {
+		if (Env.SidesBlock != BLOCK_AIR && y1 < Env_SidesHeight) return false;
+		if (x2 < 0 || z2 < 0 || x1 >= World.Width || z1 >= World.Length) return true;
+	}
+	/* Above the map is always air */
+	if (y1 >= World.Height) return true;
+	return World_GetChunkOccupancy(cx, cy, cz) == CHUNK_OCCUPANCY_AIR;
+}
+
+/* Steps the ray out of the chunk it is currently in, if that chunk only contains gas blocks */
+/* NOTE: Gas blocks are never intersected, so skipping over them does not change the result */
+static cc_bool Picking_SkipEmptyChunk(struct RayTracer* t, float reachSq, IVec3* checked, int* steps) {
+	int cx = t->pos.X >> CHUNK_SHIFT, cy = t->pos.Y >> CHUNK_SHIFT, cz = t->pos.Z >> CHUNK_SHIFT;
+	int i;
+	/* Only need to check each chunk the ray passes through once */
+	if (cx == checked->X && cy == checked->Y && cz == checked->Z) return false;
+	checked->X = cx; checked->Y = cy; checked->Z = cz;
+
+	if (!Picking_IsEmptyChunk(cx, cy, cz)) return false;
+	/* Cells past reach distance end the trace, so those have to be visited normally */
+	if (!Picking_ChunkInReach(&t->origin, cx, cy, cz, reachSq)) return false;
+
+	/* A ray can't pass through more than CHUNK_SIZE * 3 cells of a chunk, so capping */
+	/*  the steps also stops a zero or NaN direction from looping forever here */
+	for (i = 0; i < CHUNK_SIZE * 3; i++) {
+		RayTracer_Step(t); (*steps)++;
+		if ((t->pos.X >> CHUNK_SHIFT) != cx || (t->pos.Y >> CHUNK_SHIFT) != cy || (t->pos.Z >> CHUNK_SHIFT) != cz) break;
+	}
+	return true;
+}
+
 static cc_bool RayTrace(struct RayTracer* t, const Vec3* origin, const Vec3* dir, float reach, IntersectTest intersect) {
-	IVec3 pOrigin;
+	IVec3 pOrigin, checked;
 	cc_bool insideMap;
 	float reachSq;
 	Vec3 v;
@@ -173,8 +222,11 @@ static cc_bool RayTrace(struct RayTracer* t, const Vec3* origin, const Vec3* dir
 	/*  pick blocks on the INSIDE of the map borders instead of OUTSIDE them */
 	insideMap = World_ContainsXZ(pOrigin.X, pOrigin.Z) && pOrigin.Y >= 0;
 	reachSq   = reach * reach;
+	checked.X = Int32_MaxValue; checked.Y = Int32_MaxValue; checked.Z = Int32_MaxValue;
 		
 	for (i = 0; i < 25000; i++) {
+		if (insideMap && Picking_SkipEmptyChunk(t, reachSq, &checked, &i)) continue;
+
 		x   = t->pos.X; y   = t->pos.Y; z   = t->pos.Z;
 		v.X = (float)x; v.Y = (float)y; v.Z = (float)z;
 
@@ -196,6 +248,8 @@ static cc_bool RayTrace(struct RayTracer* t, const Vec3* origin, const Vec3* dir
 	return false;
 }
 
+/* Maximum distance a block can be picked from */
+static float picking_reach;
 static cc_bool ClipBlock(struct RayTracer* t) {
 	Vec3 scaledDir;
 	float lenSq, reach;
@@ -211,7 +265,7 @@ static cc_bool ClipBlock(struct RayTracer* t) {
 
 	/* Only pick the block if the block is precisely within reach distance. */
 	lenSq = Vec3_LengthSquared(&scaledDir);
-	reach = LocalPlayer_Instance.ReachDistance;
+	reach = picking_reach;
 
 	if (lenSq <= reach * reach) {
 		SetAsValid(t);
@@ -241,11 +295,30 @@ static cc_bool ClipCamera(struct RayTracer* t) {
 }
 
 void Picking_CalcPickedBlock(const Vec3* origin, const Vec3* dir, float reach, struct RayTracer* t) {
+	picking_reach = LocalPlayer_Instance.ReachDistance;
 	if (!RayTrace(t, origin, dir, reach, ClipBlock)) {
 		RayTracer_SetInvalid(t);
 	}
 }
 
+/* Whether the ray actually goes anywhere (i.e. direction is not zero or NaN) */
+static cc_bool Picking_ValidDir(const Vec3* dir) {
+	float lenSq = Vec3_LengthSquared(dir);
+	return lenSq > 0.0f && lenSq == lenSq;
+}
+
+void Picking_CalcPickedBlocks(const struct PickingRay* rays, int count, struct RayTracer* results) {
+	int i;
+	for (i = 0; i < count; i++) {
+		picking_reach = rays[i].reach;
+		/* Effects/AI may produce degenerate rays, which would otherwise step until the iteration limit */
+		if (!Picking_ValidDir(&rays[i].dir) ||
+			!RayTrace(&results[i], &rays[i].origin, &rays[i].dir, rays[i].reach, ClipBlock)) {
+			RayTracer_SetInvalid(&results[i]);
+		}
+	}
+}
+
 void Picking_ClipCameraPos(const Vec3* origin, const Vec3* dir, float reach, struct RayTracer* t) {
 	cc_bool noClip = (!Camera.Clipping || LocalPlayer_Instance.Hacks.Noclip)
 						&& LocalPlayer_Instance.Hacks.CanNoclip;
@@ -39,5 +39,14 @@ void RayTracer_Step(struct RayTracer* t);
    Marks pickedPos as invalid if a block could not be found due to going outside map boundaries
    or not being able to find a suitable candiate within the given reach distance.*/
 void Picking_CalcPickedBlock(const Vec3* origin, const Vec3* dir, float reach, struct RayTracer* t);
+
+/* Describes a ray along which to pick a block */
+struct PickingRay { Vec3 origin, dir; float reach; };
+/* Determines the picked block along each of the given rays, storing the result in the corresponding ray tracer. */
+/* NOTE: Unlike Picking_CalcPickedBlock, the reach distance of each ray is used instead of the local player's. */
+/* Rays with a zero or NaN direction are always marked as invalid. */
+void Picking_CalcPickedBlocks(const struct PickingRay* rays, int count, struct RayTracer* results);
+
+/* Determines where the camera should be placed so that it does not end up inside a solid block. */
 void Picking_ClipCameraPos(const Vec3* origin, const Vec3* dir, float reach, struct RayTracer* t);
 #endif
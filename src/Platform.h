@@ -134,6 +134,26 @@ CC_API void* Mem_AllocCleared(cc_uint32 numElems, cc_uint32 elemsSize, const cha
 CC_API void* Mem_Realloc(void* mem, cc_uint32 numElems, cc_uint32 elemsSize, const char* place);
 /* Frees an allocated a block of memory. Does nothing when passed NULL. */
 CC_API void  Mem_Free(void* mem);
+/* Attributes a block of memory allocated by one of the Mem_Try functions to the given place. */
+/* NOTE: Only has an effect while memory tracking is enabled. */
+CC_API void  Mem_SetPlace(void* mem, const char* place);
+
+/* Memory currently allocated for a place, counted since memory tracking was enabled */
+struct MemPlaceStats {
+	const char* place;   /* Place passed to Mem_Alloc or Mem_SetPlace */
+	cc_uint32 curBytes;  /* Number of bytes currently allocated */
+	cc_uint32 peakBytes; /* Most bytes that were ever allocated at once */
+	int curAllocs;       /* Number of blocks currently allocated */
+	int totalAllocs;     /* Number of blocks allocated in total */
+};
+/* Whether how much memory is allocated for each place is being tracked. */
+cc_bool Mem_IsTracking(void);
+/* Starts or stops tracking memory allocations. Stopping discards all statistics. */
+/* NOTE: Blocks allocated before tracking was started are not counted. */
+void Mem_SetTracking(cc_bool enabled);
+/* Copies the statistics for up to maxPlaces places into places. Returns number of places copied. */
+/* Statistics for all places combined are copied into total. (peakBytes is the most ever allocated at once) */
+int  Mem_GetPlaceStats(struct MemPlaceStats* places, int maxPlaces, struct MemPlaceStats* total);
 /* Sets the contents of a block of memory to the given value. */
 void Mem_Set(void* dst, cc_uint8 value, cc_uint32 numBytes);
 /* Copies a block of memory to another block of memory. */
@@ -178,6 +198,9 @@ cc_result File_Create(cc_file* file, const cc_string* path);
 cc_result File_Open(cc_file* file, const cc_string* path);
 /* Attempts to open an existing or create a new file for reading and writing. */
 cc_result File_OpenOrCreate(cc_file* file, const cc_string* path);
+/* Attempts to rename a file, replacing the destination file if it already exists. */
+/* NOTE: The replacement is atomic where the OS supports it. (i.e. no partially renamed files) */
+cc_result File_Rename(const cc_string* src, const cc_string* dst);
 /* Attempts to read data from the file. */
 cc_result File_Read(cc_file file, void* data, cc_uint32 count, cc_uint32* bytesRead);
 /* Attempts to write data to the file. */
@@ -224,6 +247,12 @@ CC_API void  Waitable_Wait(void* handle);
 /* Blocks the calling thread until the waitable gets signalled, or milliseconds delay passes. */
 CC_API void  Waitable_WaitFor(void* handle, cc_uint32 milliseconds);
 
+/* Atomically adds value to the given integer, returning the integer's original value. */
+/* NOTE: This also acts as a full memory barrier. */
+CC_API int Atomic_Add(volatile int* target, int value);
+/* Returns the number of logical processors. (1 if unknown) */
+CC_API int Platform_ProcessorCount(void);
+
 /* Calls SysFonts_Register on each font that is available on this platform. */
 void Platform_LoadSysFonts(void);
 
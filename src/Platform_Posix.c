@@ -63,23 +63,12 @@ const cc_result ReturnCode_DirectoryExists  = EEXIST;
 void Mem_Set(void*  dst, cc_uint8 value,  cc_uint32 numBytes) { memset(dst, value, numBytes); }
 void Mem_Copy(void* dst, const void* src, cc_uint32 numBytes) { memcpy(dst, src,   numBytes); }
 
-void* Mem_TryAlloc(cc_uint32 numElems, cc_uint32 elemsSize) {
-	cc_uint32 size = CalcMemSize(numElems, elemsSize);
-	return size ? malloc(size) : NULL;
+static void* Mem_SysAlloc(cc_uint32 size, cc_bool cleared) {
+	return cleared ? calloc(size, 1) : malloc(size);
 }
 
-void* Mem_TryAllocCleared(cc_uint32 numElems, cc_uint32 elemsSize) {
-	return calloc(numElems, elemsSize);
-}
-
-void* Mem_TryRealloc(void* mem, cc_uint32 numElems, cc_uint32 elemsSize) {
-	cc_uint32 size = CalcMemSize(numElems, elemsSize);
-	return size ? realloc(mem, size) : NULL;
-}
-
-void Mem_Free(void* mem) {
-	if (mem) free(mem);
-}
+static void* Mem_SysRealloc(void* mem, cc_uint32 size) { return realloc(mem, size); }
+static void  Mem_SysFree(void* mem) { free(mem); }
 
 
 /*########################################################################################################################*
@@ -229,6 +218,13 @@ cc_result File_OpenOrCreate(cc_file* file, const cc_string* path) {
 	return File_Do(file, path, O_RDWR | O_CREAT);
 }
 
+cc_result File_Rename(const cc_string* src, const cc_string* dst) {
+	char srcStr[NATIVE_STR_LEN], dstStr[NATIVE_STR_LEN];
+	Platform_EncodeUtf8(srcStr, src);
+	Platform_EncodeUtf8(dstStr, dst);
+	return rename(srcStr, dstStr) == -1 ? errno : 0;
+}
+
 cc_result File_Read(cc_file file, void* data, cc_uint32 count, cc_uint32* bytesRead) {
 	*bytesRead = read(file, data, count);
 	return *bytesRead == -1 ? errno : 0;
@@ -408,6 +404,15 @@ void Waitable_WaitFor(void* handle, cc_uint32 milliseconds) {
 	Mutex_Unlock(&ptr->mutex);
 }
 
+int Atomic_Add(volatile int* target, int value) {
+	return __sync_fetch_and_add(target, value);
+}
+
+int Platform_ProcessorCount(void) {
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int)count : 1;
+}
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------Font/Text--------------------------------------------------------*
@@ -43,24 +43,12 @@ const cc_result ReturnCode_DirectoryExists  = ERROR_ALREADY_EXISTS;
 void Mem_Set(void*  dst, cc_uint8 value,  cc_uint32 numBytes) { memset(dst, value, numBytes); }
 void Mem_Copy(void* dst, const void* src, cc_uint32 numBytes) { memcpy(dst, src,   numBytes); }
 
-void* Mem_TryAlloc(cc_uint32 numElems, cc_uint32 elemsSize) {
-	cc_uint32 size = CalcMemSize(numElems, elemsSize);
-	return size ? HeapAlloc(heap, 0, size) : NULL;
+static void* Mem_SysAlloc(cc_uint32 size, cc_bool cleared) {
+	return HeapAlloc(heap, cleared ? HEAP_ZERO_MEMORY : 0, size);
 }
 
-void* Mem_TryAllocCleared(cc_uint32 numElems, cc_uint32 elemsSize) {
-	cc_uint32 size = CalcMemSize(numElems, elemsSize);
-	return size ? HeapAlloc(heap, HEAP_ZERO_MEMORY, size) : NULL;
-}
-
-void* Mem_TryRealloc(void* mem, cc_uint32 numElems, cc_uint32 elemsSize) {
-	cc_uint32 size = CalcMemSize(numElems, elemsSize);
-	return size ? HeapReAlloc(heap, 0, mem, size) : NULL;
-}
-
-void Mem_Free(void* mem) {
-	if (mem) HeapFree(heap, 0, mem);
-}
+static void* Mem_SysRealloc(void* mem, cc_uint32 size) { return HeapReAlloc(heap, 0, mem, size); }
+static void  Mem_SysFree(void* mem) { HeapFree(heap, 0, mem); }
 
 
 /*########################################################################################################################*
@@ -247,6 +235,22 @@ cc_result File_OpenOrCreate(cc_file* file, const cc_string* path) {
 	return DoFile(file, path, GENERIC_WRITE | GENERIC_READ, OPEN_ALWAYS);
 }
 
+cc_result File_Rename(const cc_string* src, const cc_string* dst) {
+	WCHAR srcStr[NATIVE_STR_LEN], dstStr[NATIVE_STR_LEN];
+	cc_result res;
+	Platform_EncodeUtf16(srcStr, src);
+	Platform_EncodeUtf16(dstStr, dst);
+
+	if (MoveFileExW(srcStr, dstStr, MOVEFILE_REPLACE_EXISTING)) return 0;
+	if ((res = GetLastError()) != ERROR_CALL_NOT_IMPLEMENTED) return res;
+
+	/* Windows 9x does not support MoveFileEx, so destination has to be deleted first */
+	Platform_Utf16ToAnsi(srcStr);
+	Platform_Utf16ToAnsi(dstStr);
+	DeleteFileA((LPCSTR)dstStr);
+	return MoveFileA((LPCSTR)srcStr, (LPCSTR)dstStr) ? 0 : GetLastError();
+}
+
 cc_result File_Read(cc_file file, void* data, cc_uint32 count, cc_uint32* bytesRead) {
 	BOOL success = ReadFile(file, data, count, bytesRead, NULL);
 	return success ? 0 : GetLastError();
@@ -344,6 +348,16 @@ void Waitable_WaitFor(void* handle, cc_uint32 milliseconds) {
 	WaitForSingleObject((HANDLE)handle, milliseconds);
 }
 
+int Atomic_Add(volatile int* target, int value) {
+	return InterlockedExchangeAdd((volatile LONG*)target, value);
+}
+
+int Platform_ProcessorCount(void) {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return max(1, (int)info.dwNumberOfProcessors);
+}
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------Font/Text--------------------------------------------------------*
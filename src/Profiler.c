@@ -0,0 +1,537 @@
+#include "Profiler.h"
+#include "Platform.h"
+#include "Stream.h"
+#include "Funcs.h"
+#include "Game.h"
+#include "Options.h"
+#include "Logger.h"
+#include "Utils.h"
+
+#define PROFILER_MAX_DEPTH 16
+/* Number of timed zones kept for saving traces (several seconds worth) */
+#define PROFILER_MAX_EVENTS 16384
+#define PROFILER_FRAME_NAME "Frame"
+
+struct ProfilerEvent { const char* name; cc_uint64 beg, end; int depth; };
+struct ProfilerOpen  { const char* name; cc_uint64 beg; int zone; };
+/* Time spent in a zone during the current frame, and over the current second */
+struct ProfilerZone  { const char* name; int depth, parent; cc_uint64 frame, total, peak; };
+
+cc_bool Profiler_Enabled, Profiler_ShowFrameStats, Profiler_LogFrameStats, Profiler_ShowMemory;
+/* Whether zones are being timed (needed for the profiler, and to find what caused stutters) */
+static cc_bool timing;
+static struct ProfilerEvent* events;
+static int events_next, events_count;
+
+static struct ProfilerOpen stack[PROFILER_MAX_DEPTH];
+static int stack_depth;
+
+static struct ProfilerZone zones[PROFILER_MAX_ZONES];
+static int zones_count;
+static struct ProfilerZoneStats stats[PROFILER_MAX_ZONES];
+static int stats_count;
+
+static cc_uint64 frame_beg, second_beg;
+static int second_frames;
+static void Profiler_UpdateTiming(void);
+
+
+/*########################################################################################################################*
+*----------------------------------------------------------Zones----------------------------------------------------------*
+*#########################################################################################################################*/
+/* Returns index of the zone with the given name, or -1 if too many zones */
+static int Profiler_FindZone(const char* name, int depth, int parent) {
+	struct ProfilerZone* z;
+	int i;
+	for (i = 0; i < zones_count; i++) {
+		if (zones[i].name == name) return i;
+	}
+	if (zones_count == PROFILER_MAX_ZONES) return -1;
+
+	z = &zones[zones_count];
+	z->name   = name;
+	z->depth  = depth;
+	z->parent = parent;
+	z->frame  = 0;
+	z->total  = 0;
+	z->peak   = 0;
+	return zones_count++;
+}
+
+static void Profiler_ResetZones(void) {
+	stack_depth = 0;
+	zones_count = 0;
+	stats_count = 0;
+	/* Ensure frame zone is always the first zone */
+	Profiler_FindZone(PROFILER_FRAME_NAME, 0, -1);
+}
+
+static void Profiler_AddEvent(const char* name, cc_uint64 beg, cc_uint64 end, int depth, int zone) {
+	struct ProfilerEvent* e;
+	if (zone >= 0) zones[zone].frame += end - beg;
+	if (!events) return;
+
+	e = &events[events_next];
+	e->name  = name;
+	e->beg   = beg;
+	e->end   = end;
+	e->depth = depth;
+
+	events_next  = (events_next + 1) % PROFILER_MAX_EVENTS;
+	events_count = min(events_count + 1, PROFILER_MAX_EVENTS);
+}
+
+void Profiler_Begin(const char* name) {
+	struct ProfilerOpen* open;
+	int parent;
+	if (!timing) return;
+	/* Too deeply nested zones are still counted, so Profiler_End stays balanced */
+	if (stack_depth++ >= PROFILER_MAX_DEPTH) return;
+
+	/* Zones are always nested inside the frame zone */
+	parent = stack_depth > 1 ? stack[stack_depth - 2].zone : 0;
+	open   = &stack[stack_depth - 1];
+
+	open->name = name;
+	open->zone = Profiler_FindZone(name, stack_depth, max(parent, 0));
+	open->beg  = Stopwatch_Measure();
+}
+
+void Profiler_End(void) {
+	struct ProfilerOpen* open;
+	cc_uint64 end;
+	if (!timing || !stack_depth) return;
+	if (--stack_depth >= PROFILER_MAX_DEPTH) return;
+
+	end  = Stopwatch_Measure();
+	open = &stack[stack_depth];
+	Profiler_AddEvent(open->name, open->beg, end, stack_depth + 1, open->zone);
+}
+
+void Profiler_SetEnabled(cc_bool enabled) {
+	if (enabled == Profiler_Enabled) return;
+	Profiler_Enabled = enabled;
+	events_next  = 0;
+	events_count = 0;
+
+	if (enabled) {
+		events = (struct ProfilerEvent*)Mem_Alloc(PROFILER_MAX_EVENTS, sizeof(struct ProfilerEvent), "profiler events");
+	} else {
+		Mem_Free(events);
+		events = NULL;
+	}
+	Profiler_UpdateTiming();
+}
+
+/* Adds stats for the given zone, followed by stats for the zones nested inside it */
+static void Profiler_AddStats(int zone) {
+	struct ProfilerZoneStats* s = &stats[stats_count++];
+	struct ProfilerZone* z      = &zones[zone];
+	float total = (float)Stopwatch_ElapsedMicroseconds(0, z->total);
+	int i;
+
+	s->name  = z->name;
+	s->depth = z->depth;
+	s->avgMs = total / max(second_frames, 1) / 1000.0f;
+	s->maxMs = Stopwatch_ElapsedMicroseconds(0, z->peak) / 1000.0f;
+
+	z->total = 0;
+	z->peak  = 0;
+	/* Nested zones are always found after the zone they are nested in */
+	for (i = zone + 1; i < zones_count; i++) {
+		if (zones[i].parent == zone) Profiler_AddStats(i);
+	}
+}
+
+/* Returns the innermost zone that most of the current frame was spent in */
+static const char* Profiler_FindSlowestZone(void) {
+	int i, zone = 0, slowest;
+
+	for (;;) {
+		slowest = -1;
+		for (i = zone + 1; i < zones_count; i++) {
+			if (zones[i].parent != zone) continue;
+			if (slowest == -1 || zones[i].frame > zones[slowest].frame) slowest = i;
+		}
+
+		/* Most of the time was not spent in any one nested zone */
+		if (slowest == -1 || zones[slowest].frame * 2 < zones[zone].frame) break;
+		zone = slowest;
+	}
+	return zone ? zones[zone].name : "other";
+}
+
+int Profiler_GetStats(struct ProfilerZoneStats* out) {
+	Mem_Copy(out, stats, stats_count * sizeof(struct ProfilerZoneStats));
+	return stats_count;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Frame times-------------------------------------------------------*
+*#########################################################################################################################*/
+/* Frames are counted in 0.5 millisecond wide buckets, with the last bucket counting all slower frames */
+#define FRAME_BUCKETS 201
+#define FRAME_BUCKET_MS 0.5f
+/* Number of most recent frames that rolling statistics are calculated from */
+#define FRAME_WINDOW 1024
+/* Frames slower than this, and also twice as slow as the median frame, are counted as stutters */
+#define STUTTER_MIN_MS 50.0f
+
+static float frame_times[FRAME_WINDOW];
+static int frame_next, frame_count;
+static int frame_buckets[FRAME_BUCKETS];
+static int stutters;
+static float stutter_ms;
+static const char* stutter_zone;
+
+/* Frame times over the current second, for the CSV log */
+static int second_buckets[FRAME_BUCKETS];
+static int second_stutters;
+static float second_totalMs, second_maxMs;
+static const char* second_maxZone;
+static struct Stream csv_stream;
+static cc_uint64 csv_beg;
+
+static int Profiler_FrameBucket(float ms) {
+	int bucket = (int)(ms / FRAME_BUCKET_MS);
+	return min(bucket, FRAME_BUCKETS - 1);
+}
+
+/* Calculates the frame time that the given percentage of frames were at least as fast as */
+static float Profiler_Percentile(const int* buckets, int count, int percent, float maxMs) {
+	int i, target = (count * percent + 99) / 100, total = 0;
+	if (!count) return 0.0f;
+
+	for (i = 0; i < FRAME_BUCKETS - 1; i++) {
+		total += buckets[i];
+		/* Report upper edge of bucket, but never more than slowest frame */
+		if (total >= target) return min((i + 1) * FRAME_BUCKET_MS, maxMs);
+	}
+	return maxMs;
+}
+
+static float sorted_times[FRAME_WINDOW];
+static void Profiler_QuickSort(int left, int right) {
+	float* keys = sorted_times; float key;
+
+	while (left < right) {
+		int i = left, j = right;
+		float pivot = keys[(i + j) >> 1];
+
+		/* partition the list */
+		while (i <= j) {
+			while (pivot > keys[i]) i++;
+			while (pivot < keys[j]) j--;
+			QuickSort_Swap_Maybe();
+		}
+		/* recurse into the smaller subset */
+		QuickSort_Recurse(Profiler_QuickSort)
+	}
+}
+
+static void Profiler_AddFrameTime(float ms) {
+	const char* zone = NULL;
+	float median;
+
+	/* Replace oldest frame in the rolling window */
+	if (frame_count == FRAME_WINDOW) {
+		frame_buckets[Profiler_FrameBucket(frame_times[frame_next])]--;
+	} else {
+		frame_count++;
+	}
+	frame_times[frame_next] = ms;
+	frame_next = (frame_next + 1) % FRAME_WINDOW;
+	frame_buckets[Profiler_FrameBucket(ms)]++;
+
+	second_buckets[Profiler_FrameBucket(ms)]++;
+	second_totalMs += ms;
+	if (ms > second_maxMs) {
+		second_maxMs   = ms;
+		second_maxZone = timing ? Profiler_FindSlowestZone() : NULL;
+		zone           = second_maxZone;
+	}
+
+	if (ms < STUTTER_MIN_MS) return;
+	median = Profiler_Percentile(frame_buckets, frame_count, 50, ms);
+	if (ms < median * 2) return;
+
+	stutters++; second_stutters++;
+	stutter_ms   = ms;
+	stutter_zone = zone ? zone : (timing ? Profiler_FindSlowestZone() : NULL);
+}
+
+void Profiler_GetFrameStats(struct ProfilerFrameStats* s) {
+	s->frames = frame_count;
+	if (frame_count) {
+		/* Exact percentiles, since buckets are too coarse for fast frames */
+		Mem_Copy(sorted_times, frame_times, frame_count * sizeof(float));
+		Profiler_QuickSort(0, frame_count - 1);
+
+		s->maxMs = sorted_times[frame_count - 1];
+		s->p50Ms = sorted_times[(frame_count - 1) * 50 / 100];
+		s->p99Ms = sorted_times[(frame_count - 1) * 99 / 100];
+	} else {
+		s->maxMs = 0.0f; s->p50Ms = 0.0f; s->p99Ms = 0.0f;
+	}
+
+	s->stutters    = stutters;
+	s->stutterMs   = stutter_ms;
+	s->stutterZone = stutter_zone;
+}
+
+int Profiler_CountFrames(float minMs, float maxMs) {
+	int i, count = 0;
+	for (i = 0; i < frame_count; i++) {
+		if (frame_times[i] >= minMs && frame_times[i] < maxMs) count++;
+	}
+	return count;
+}
+
+static void Profiler_LogSecond(void) {
+	static const cc_string header = String_FromConst("seconds,frames,avg_ms,p50_ms,p99_ms,max_ms,stutters,max_zone");
+	cc_string line; char lineBuffer[256];
+	float secs, avgMs, p50Ms, p99Ms;
+	cc_uint32 pos;
+	cc_result res;
+
+	String_InitArray(line, lineBuffer);
+	secs  = Stopwatch_ElapsedMicroseconds(csv_beg, second_beg) / (1000.0f * 1000.0f);
+	avgMs = second_totalMs / max(second_frames, 1);
+	p50Ms = Profiler_Percentile(second_buckets, second_frames, 50, second_maxMs);
+	p99Ms = Profiler_Percentile(second_buckets, second_frames, 99, second_maxMs);
+
+	String_Format4(&line, "%f1,%i,%f2,%f2,", &secs, &second_frames, &avgMs, &p50Ms);
+	String_Format4(&line, "%f2,%f2,%i,%c", &p99Ms, &second_maxMs, &second_stutters,
+					second_maxZone ? second_maxZone : "");
+
+	/* Only write header when log file is first created */
+	if (!csv_stream.Position(&csv_stream, &pos) && !pos) {
+		Stream_WriteLine(&csv_stream, (cc_string*)&header);
+	}
+	res = Stream_WriteLine(&csv_stream, &line);
+	if (res) { Logger_SysWarn(res, "writing frame times"); Profiler_SetLogFrameStats(false); }
+}
+
+static void Profiler_ResetSecond(void) {
+	Mem_Set(second_buckets, 0, sizeof(second_buckets));
+	second_frames   = 0;
+	second_stutters = 0;
+	second_totalMs  = 0.0f;
+	second_maxMs    = 0.0f;
+	second_maxZone  = NULL;
+}
+
+void Profiler_NextFrame(void) {
+	cc_uint64 now = Stopwatch_Measure();
+	int i;
+
+	if (frame_beg) {
+		/* Frame zone is always the first zone */
+		if (timing) Profiler_AddEvent(PROFILER_FRAME_NAME, frame_beg, now, 0, 0);
+		second_frames++;
+		Profiler_AddFrameTime(Stopwatch_ElapsedMicroseconds(frame_beg, now) / 1000.0f);
+	} else {
+		second_beg = now;
+	}
+
+	for (i = 0; i < zones_count; i++) {
+		zones[i].total += zones[i].frame;
+		zones[i].peak   = max(zones[i].peak, zones[i].frame);
+		zones[i].frame  = 0;
+	}
+
+	if (Stopwatch_ElapsedMS(second_beg, now) >= 1000) {
+		if (Profiler_LogFrameStats) Profiler_LogSecond();
+		stats_count = 0;
+		if (timing) Profiler_AddStats(0);
+
+		Profiler_ResetSecond();
+		second_beg = now;
+	}
+	/* Discard any zones that were not ended last frame */
+	stack_depth = 0;
+	frame_beg   = now;
+}
+
+static void Profiler_UpdateTiming(void) {
+	cc_bool needed = Profiler_Enabled || Profiler_ShowFrameStats || Profiler_LogFrameStats;
+	if (needed == timing) return;
+
+	timing = needed;
+	Profiler_ResetZones();
+}
+
+void Profiler_SetShowFrameStats(cc_bool show) {
+	Profiler_ShowFrameStats = show;
+	Profiler_UpdateTiming();
+}
+
+void Profiler_SetLogFrameStats(cc_bool log) {
+	static const cc_string path = String_FromConst("logs/frametimes.csv");
+	cc_result res;
+	if (log == Profiler_LogFrameStats) return;
+
+	if (log) {
+		if (!Utils_EnsureDirectory("logs")) return;
+		res = Stream_AppendFile(&csv_stream, &path);
+		if (res) { Logger_SysWarn2(res, "appending to", &path); return; }
+		csv_beg = Stopwatch_Measure();
+	} else {
+		res = csv_stream.Close(&csv_stream);
+		if (res) Logger_SysWarn2(res, "closing", &path);
+	}
+
+	Profiler_LogFrameStats = log;
+	Profiler_UpdateTiming();
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Trace export------------------------------------------------------*
+*#########################################################################################################################*/
+static cc_result Profiler_Flush(struct Stream* s, cc_string* str) {
+	cc_result res = Stream_Write(s, (const cc_uint8*)str->buffer, str->length);
+	str->length   = 0;
+	return res;
+}
+
+static cc_result Profiler_WriteEvents(struct Stream* s) {
+	cc_string str; char strBuffer[8192];
+	struct ProfilerEvent* e;
+	cc_uint64 start = 0;
+	int i, first = (events_next - events_count + PROFILER_MAX_EVENTS) % PROFILER_MAX_EVENTS;
+	int ts, dur, tid = 1;
+	cc_result res;
+
+	/* Parent zones are recorded after the zones nested inside them */
+	for (i = 0; i < events_count; i++) {
+		e = &events[(first + i) % PROFILER_MAX_EVENTS];
+		if (!i || e->beg < start) start = e->beg;
+	}
+
+	String_InitArray(str, strBuffer);
+	String_AppendConst(&str, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	for (i = 0; i < events_count; i++) {
+		e   = &events[(first + i) % PROFILER_MAX_EVENTS];
+		/* Calculate duration from rounded end time, so zones stay exactly within their parents */
+		ts  = (int)Stopwatch_ElapsedMicroseconds(start, e->beg);
+		dur = (int)Stopwatch_ElapsedMicroseconds(start, e->end) - ts;
+
+		String_Format3(&str, "{\"name\":\"%c\",\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"ts\":%i,", 
+						e->name, &tid, &ts);
+		String_Format2(&str, "\"dur\":%i,\"args\":{\"depth\":%i}}", &dur, &e->depth);
+		String_AppendConst(&str, i < events_count - 1 ? ",\n" : "\n");
+
+		if (str.length < str.capacity - 256) continue;
+		if ((res = Profiler_Flush(s, &str))) return res;
+	}
+
+	String_AppendConst(&str, "]}\n");
+	return Profiler_Flush(s, &str);
+}
+
+cc_result Profiler_SaveTrace(const cc_string* path) {
+	struct Stream stream;
+	cc_result res;
+
+	res = Stream_CreateFile(&stream, path);
+	if (res) return res;
+	res = Profiler_WriteEvents(&stream);
+
+	if (res) { stream.Close(&stream); return res; }
+	return stream.Close(&stream);
+}
+
+
+/*########################################################################################################################*
+*------------------------------------------------------Memory statistics--------------------------------------------------*
+*#########################################################################################################################*/
+/* Enough for every place the game itself allocates memory for */
+#define PROFILER_MAX_PLACES 256
+static struct MemPlaceStats mem_places[PROFILER_MAX_PLACES];
+
+void Profiler_SetShowMemory(cc_bool show) {
+	Profiler_ShowMemory = show;
+	if (show) Mem_SetTracking(true);
+}
+
+static void Profiler_SortPlaces(struct MemPlaceStats* places, int count) {
+	struct MemPlaceStats tmp;
+	int i, j;
+
+	/* Insertion sort, since there are only a small number of places */
+	for (i = 1; i < count; i++) {
+		tmp = places[i];
+		for (j = i; j > 0 && places[j - 1].curBytes < tmp.curBytes; j--) {
+			places[j] = places[j - 1];
+		}
+		places[j] = tmp;
+	}
+}
+
+int Profiler_GetMemoryStats(struct MemPlaceStats* places, int maxPlaces, struct MemPlaceStats* total) {
+	int count = Mem_GetPlaceStats(mem_places, PROFILER_MAX_PLACES, total);
+	Profiler_SortPlaces(mem_places, count);
+
+	count = min(count, maxPlaces);
+	Mem_Copy(places, mem_places, count * sizeof(struct MemPlaceStats));
+	return count;
+}
+
+static cc_result Profiler_WritePlaces(struct Stream* s) {
+	cc_string str; char strBuffer[8192];
+	struct MemPlaceStats total, *p;
+	int i, count;
+	cc_result res;
+
+	count = Mem_GetPlaceStats(mem_places, PROFILER_MAX_PLACES, &total);
+	Profiler_SortPlaces(mem_places, count);
+	String_InitArray(str, strBuffer);
+	String_AppendConst(&str, "place,cur_bytes,peak_bytes,cur_allocs,total_allocs\n");
+
+	/* Total is written as the first row */
+	for (i = -1; i < count; i++) {
+		p = i >= 0 ? &mem_places[i] : &total;
+		/* Places never contain commas, so don't need to be quoted */
+		String_Format4(&str, "%c,%i,%i,%i,", p->place, &p->curBytes, &p->peakBytes, &p->curAllocs);
+		String_Format1(&str, "%i\n", &p->totalAllocs);
+
+		if (str.length < str.capacity - 256) continue;
+		if ((res = Profiler_Flush(s, &str))) return res;
+	}
+	return Profiler_Flush(s, &str);
+}
+
+cc_result Profiler_SaveMemoryStats(const cc_string* path) {
+	struct Stream stream;
+	cc_result res;
+
+	res = Stream_CreateFile(&stream, path);
+	if (res) return res;
+	res = Profiler_WritePlaces(&stream);
+
+	if (res) { stream.Close(&stream); return res; }
+	return stream.Close(&stream);
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Profiler component----------------------------------------------------*
+*#########################################################################################################################*/
+static void OnInit(void) {
+	Profiler_SetShowFrameStats(Options_GetBool(OPT_SHOW_FRAME_STATS, false));
+	Profiler_SetLogFrameStats(Options_GetBool(OPT_LOG_FRAME_STATS,    false));
+	Profiler_SetShowMemory(Options_GetBool(OPT_SHOW_MEMORY,          false));
+}
+
+static void OnFree(void) {
+	Profiler_SetEnabled(false);
+	Profiler_SetLogFrameStats(false);
+}
+
+struct IGameComponent Profiler_Component = {
+	OnInit, /* Init  */
+	OnFree, /* Free  */
+};
@@ -0,0 +1,66 @@
+#ifndef CC_PROFILER_H
+#define CC_PROFILER_H
+#include "String.h"
+/* Measures how long named zones of code take each frame, to help find what causes slow frames.
+   Zones can be nested, but must only be used from the main thread.
+   Copyright 2014-2021 ClassiCube | Licensed under BSD-3
+*/
+struct IGameComponent;
+extern struct IGameComponent Profiler_Component;
+
+#define PROFILER_MAX_ZONES 32
+struct ProfilerZoneStats { const char* name; int depth; float avgMs, maxMs; };
+
+/* Whether zone timings are shown in the HUD and recorded for traces. */
+extern cc_bool Profiler_Enabled;
+/* Starts or stops recording zones. Stopping discards all recorded zones. */
+void Profiler_SetEnabled(cc_bool enabled);
+
+/* Marks the end of the current frame, and the start of the next one. */
+void Profiler_NextFrame(void);
+/* Starts timing a zone. NOTE: name must be a string constant. */
+void Profiler_Begin(const char* name);
+/* Stops timing the most recently started zone. */
+void Profiler_End(void);
+/* Times how long the given code takes, as a zone with the given name. */
+#define Profiler_Zone(name, code) { Profiler_Begin(name); code; Profiler_End(); }
+
+/* Gets how long each zone took per frame over the last second. Returns number of zones. */
+/* NOTE: Zones are in the order they were first started, with their nesting depth. */
+int Profiler_GetStats(struct ProfilerZoneStats* zones);
+/* Saves the zones from the last few seconds in the Chrome trace event JSON format. */
+/* (can be viewed with chrome://tracing or https://ui.perfetto.dev) */
+cc_result Profiler_SaveTrace(const cc_string* path);
+
+/* Frame times over the last 1024 frames, and stutters (frames much slower than usual) */
+struct ProfilerFrameStats {
+	int frames;              /* Number of frames the times are calculated from */
+	float p50Ms, p99Ms;      /* Median and 99th percentile frame time */
+	float maxMs;             /* Slowest frame time */
+	int stutters;            /* Number of stutters since the game started */
+	float stutterMs;         /* How long the most recent stutter took */
+	const char* stutterZone; /* Zone most of the most recent stutter was spent in, NULL if unknown */
+};
+
+/* Whether frame time statistics are shown in the HUD. */
+extern cc_bool Profiler_ShowFrameStats;
+void Profiler_SetShowFrameStats(cc_bool show);
+/* Whether frame time statistics for each second are appended to logs/frametimes.csv */
+extern cc_bool Profiler_LogFrameStats;
+void Profiler_SetLogFrameStats(cc_bool log);
+
+void Profiler_GetFrameStats(struct ProfilerFrameStats* stats);
+/* Counts how many of the last 1024 frames took between minMs and maxMs */
+int Profiler_CountFrames(float minMs, float maxMs);
+
+struct MemPlaceStats;
+/* Whether memory allocated for each place is shown in the HUD. */
+/* NOTE: Showing memory also starts memory tracking. (see Mem_SetTracking) */
+extern cc_bool Profiler_ShowMemory;
+void Profiler_SetShowMemory(cc_bool show);
+/* Gets the memory allocated for up to maxPlaces places, sorted by most bytes currently allocated. */
+/* Memory allocated for all places combined is stored in total. */
+int Profiler_GetMemoryStats(struct MemPlaceStats* places, int maxPlaces, struct MemPlaceStats* total);
+/* Saves the memory allocated for every place as comma separated values. */
+cc_result Profiler_SaveMemoryStats(const cc_string* path);
+#endif
@@ -9,6 +9,9 @@
 #include "Launcher.h"
 #include "Server.h"
 #include "Options.h"
+#include "BlockPhysics.h"
+#include "Generator.h"
+#include "Errors.h"
 
 static void RunGame(void) {
 	cc_string title; char titleBuffer[STRING_SIZE];
@@ -111,6 +114,65 @@ static int RunProgram(int argc, char** argv) {
 	return 0;
 }
 
+#if !defined CC_BUILD_MOBILE && !defined CC_BUILD_WEB
+/* Runs physics benchmark without creating a window, e.g. ClassiCube --physics-bench [map] [ticks] [seed] */
+static cc_bool RunPhysicsBenchmark(int argc, char** argv, cc_result* res) {
+	cc_string args[GAME_MAX_CMDARGS];
+	int argsCount, ticks = 1000, seed = 0;
+
+	argsCount = Platform_GetCommandLineArgs(argc, argv, args);
+	if (!argsCount || !String_CaselessEqualsConst(&args[0], "--physics-bench")) return false;
+
+	Logger_Hook();
+	Platform_Init();
+	/* So the number of job workers can be changed with job-threads */
+	Options_Load();
+	if (argsCount < 2) {
+		Platform_LogConst("Usage: --physics-bench [map path] [ticks] [seed]");
+		*res = ERR_INVALID_ARGUMENT; return true;
+	}
+
+	if (argsCount > 2) Convert_ParseInt(&args[2], &ticks);
+	if (argsCount > 3) Convert_ParseInt(&args[3], &seed);
+	*res = Physics_RunBenchmark(&args[1], ticks, seed);
+	return true;
+}
+#endif
+
+#if !defined CC_BUILD_MOBILE && !defined CC_BUILD_WEB
+/* Runs map generator test or benchmark without creating a window, e.g. */
+/*  ClassiCube --gen-test or ClassiCube --gen-bench [seed] [width] [height] [length] */
+static cc_bool RunGeneratorTest(int argc, char** argv, cc_result* res) {
+	static const cc_string path = String_FromConst("gen-test.ccw");
+	cc_string args[GAME_MAX_CMDARGS];
+	int argsCount, seed = 12345;
+	int width = 0, height = 0, length = 0;
+	cc_bool bench;
+
+	argsCount = Platform_GetCommandLineArgs(argc, argv, args);
+	if (!argsCount) return false;
+	bench = String_CaselessEqualsConst(&args[0], "--gen-bench");
+	if (!bench && !String_CaselessEqualsConst(&args[0], "--gen-test")) return false;
+
+	Logger_Hook();
+	Platform_Init();
+	/* So the number of job workers can be changed with job-threads */
+	Options_Load();
+	if (argsCount > 1) Convert_ParseInt(&args[1], &seed);
+
+	if (!bench) {
+		*res = Gen_RunTest(&path);
+	} else if (argsCount > 2 && (argsCount < 5 || !Convert_ParseInt(&args[2], &width) || width <= 0
+			|| !Convert_ParseInt(&args[3], &height) || height <= 0 || !Convert_ParseInt(&args[4], &length) || length <= 0)) {
+		Platform_LogConst("Usage: --gen-bench [seed] [width] [height] [length]");
+		*res = ERR_INVALID_ARGUMENT;
+	} else {
+		*res = Gen_RunBenchmark(seed, width, height, length);
+	}
+	return true;
+}
+#endif
+
 #if defined CC_BUILD_IOS
 /* ClassiCube is sort of and sort of not the executable */
 /*  on iOS - UIKit is responsible for kickstarting the game. */
@@ -141,6 +203,12 @@ int main_real(int argc, char** argv) {
 int main(int argc, char** argv) {
 #endif
 	cc_result res;
+#ifndef CC_BUILD_WEB
+	if (RunPhysicsBenchmark(argc, argv, &res) || RunGeneratorTest(argc, argv, &res)) {
+		Process_Exit(res);
+		return res;
+	}
+#endif
 	SetupProgram(argc, argv);
 
 	res = RunProgram(argc, argv);
@@ -170,7 +170,7 @@ static void AddEntity(cc_uint8* data, EntityID id, const cc_string* name, const
 		e = &NetPlayers_List[id].Base;
 
 		NetPlayer_Init((struct NetPlayer*)e);
-		Entities.List[id] = e;
+		Entities_Add(id, e);
 		Event_RaiseInt(&EntityEvents.Added, id);
 	} else {
 		e = &LocalPlayer_Instance.Base;
@@ -432,6 +432,7 @@ static void MapState_Read(struct MapState* m) {
 
 	if (!m->blocks) {
 		m->blocks = (BlockRaw*)Mem_TryAlloc(map_volume, 1);
+		Mem_SetPlace(m->blocks, "map blocks");
 		/* unlikely but possible */
 		if (!m->blocks) {
 			Window_ShowDialog("Out of memory", "Not enough free memory to join that map.\nTry joining a different map.");
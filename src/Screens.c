@@ -21,6 +21,7 @@
 #include "World.h"
 #include "Input.h"
 #include "Utils.h"
+#include "Profiler.h"
 
 #define CHAT_MAX_STATUS Array_Elems(Chat_Status)
 #define CHAT_MAX_BOTTOMRIGHT Array_Elems(Chat_BottomRight)
@@ -63,10 +64,14 @@ CC_NOINLINE static cc_bool IsOnlyChatActive(void) {
 /*########################################################################################################################*
 *--------------------------------------------------------HUDScreen--------------------------------------------------------*
 *#########################################################################################################################*/
+#define HUD_PROFILER_LINES 12
+#define HUD_MEMORY_LINES 8
 static struct HUDScreen {
 	Screen_Body
 	struct FontDesc font;
-	struct TextWidget line1, line2;
+	struct TextWidget line1, line2, frameStats;
+	struct TextWidget profiler[HUD_PROFILER_LINES];
+	struct TextWidget memory[HUD_MEMORY_LINES];
 	struct TextAtlas posAtlas;
 	double accumulator;
 	int frames;
@@ -102,6 +107,101 @@ static void HUDScreen_UpdateLine1(struct HUDScreen* s) {
 	TextWidget_Set(&s->line1, &status, &s->font);
 }
 
+static void HUDScreen_UpdateFrameStats(struct HUDScreen* s) {
+	cc_string status; char statusBuffer[STRING_SIZE * 2];
+	struct ProfilerFrameStats stats;
+	if (!Profiler_ShowFrameStats) return;
+	Profiler_GetFrameStats(&stats);
+
+	String_InitArray(status, statusBuffer);
+	String_Format3(&status, "Frame %f1 ms, p99 %f1 ms, max %f1 ms", &stats.p50Ms, &stats.p99Ms, &stats.maxMs);
+	String_Format1(&status, ", %i stutters", &stats.stutters);
+
+	if (stats.stutterZone) {
+		String_Format2(&status, " (last %f0 ms in %c)", &stats.stutterMs, stats.stutterZone);
+	} else if (stats.stutters) {
+		String_Format1(&status, " (last %f0 ms)", &stats.stutterMs);
+	}
+	TextWidget_Set(&s->frameStats, &status, &s->font);
+}
+
+static void HUDScreen_LayoutProfiler(struct HUDScreen* s) {
+	struct TextWidget* line;
+	int i, y = Display_ScaleY(2);
+
+	for (i = 0; i < HUD_PROFILER_LINES; i++) {
+		line = &s->profiler[i];
+		Widget_SetLocation(line, ANCHOR_MAX, ANCHOR_MIN, 2, 0);
+		/* We can't use y in Widget_SetLocation because that DPI scales it */
+		line->yOffset = y;
+		Widget_Layout(line);
+		y += line->height;
+	}
+}
+
+static void HUDScreen_UpdateProfiler(struct HUDScreen* s) {
+	cc_string line; char lineBuffer[STRING_SIZE];
+	struct ProfilerZoneStats zones[PROFILER_MAX_ZONES];
+	int i, j, count;
+
+	if (!Profiler_Enabled) {
+		for (i = 0; i < HUD_PROFILER_LINES; i++) { Elem_Free(&s->profiler[i]); }
+		return;
+	}
+	count = Profiler_GetStats(zones);
+
+	for (i = 0; i < HUD_PROFILER_LINES; i++) {
+		String_InitArray(line, lineBuffer);
+		if (i < count) {
+			for (j = 0; j < zones[i].depth; j++) { String_AppendConst(&line, "  "); }
+			String_Format3(&line, "&e%c: &f%f2 ms &7(max %f2)", zones[i].name, &zones[i].avgMs, &zones[i].maxMs);
+		}
+		TextWidget_Set(&s->profiler[i], &line, &s->font);
+	}
+	HUDScreen_LayoutProfiler(s);
+}
+
+static void HUDScreen_LayoutMemory(struct HUDScreen* s) {
+	struct TextWidget* line = &s->profiler[HUD_PROFILER_LINES - 1];
+	int i, y = Display_ScaleY(2);
+	/* Memory usage goes below zone timings when both are shown */
+	if (Profiler_Enabled) y = line->yOffset + line->height;
+
+	for (i = 0; i < HUD_MEMORY_LINES; i++) {
+		line = &s->memory[i];
+		Widget_SetLocation(line, ANCHOR_MAX, ANCHOR_MIN, 2, 0);
+		line->yOffset = y;
+		Widget_Layout(line);
+		y += line->height;
+	}
+}
+
+static void HUDScreen_UpdateMemory(struct HUDScreen* s) {
+	cc_string line; char lineBuffer[STRING_SIZE];
+	struct MemPlaceStats places[HUD_MEMORY_LINES];
+	float curMB, peakMB;
+	int i, count;
+
+	if (!Profiler_ShowMemory) {
+		for (i = 0; i < HUD_MEMORY_LINES; i++) { Elem_Free(&s->memory[i]); }
+		return;
+	}
+	/* First line is the total for all places */
+	count = Profiler_GetMemoryStats(places + 1, HUD_MEMORY_LINES - 1, &places[0]) + 1;
+
+	for (i = 0; i < HUD_MEMORY_LINES; i++) {
+		String_InitArray(line, lineBuffer);
+		if (i < count) {
+			curMB  = places[i].curBytes  / (1024.0f * 1024.0f);
+			peakMB = places[i].peakBytes / (1024.0f * 1024.0f);
+			String_Format4(&line, "&e%c: &f%f2 MB &7(peak %f2, %i blocks)",
+							places[i].place, &curMB, &peakMB, &places[i].curAllocs);
+		}
+		TextWidget_Set(&s->memory[i], &line, &s->font);
+	}
+	HUDScreen_LayoutMemory(s);
+}
+
 static void HUDScreen_DrawPosition(struct HUDScreen* s) {
 	struct VertexTextured vertices[4 * 64];
 	struct VertexTextured* ptr = vertices;
@@ -167,6 +267,9 @@ static void HUDScreen_Update(void* screen, double delta) {
 	if (s->accumulator < 1.0) return;
 
 	HUDScreen_UpdateLine1(s);
+	HUDScreen_UpdateFrameStats(s);
+	HUDScreen_UpdateProfiler(s);
+	HUDScreen_UpdateMemory(s);
 	s->accumulator = 0.0;
 	s->frames      = 0;
 	Game.ChunkUpdates = 0;
@@ -174,11 +277,15 @@ static void HUDScreen_Update(void* screen, double delta) {
 
 static void HUDScreen_ContextLost(void* screen) {
 	struct HUDScreen* s = (struct HUDScreen*)screen;
+	int i;
 	Font_Free(&s->font);
 	TextAtlas_Free(&s->posAtlas);
 	Elem_Free(&s->hotbar);
 	Elem_Free(&s->line1);
 	Elem_Free(&s->line2);
+	Elem_Free(&s->frameStats);
+	for (i = 0; i < HUD_PROFILER_LINES; i++) { Elem_Free(&s->profiler[i]); }
+	for (i = 0; i < HUD_MEMORY_LINES;   i++) { Elem_Free(&s->memory[i]); }
 }
 
 static void HUDScreen_ContextRecreated(void* screen) {	
@@ -234,7 +341,14 @@ static void HUDScreen_Layout(void* screen) {
 	}
 
 	HUDScreen_LayoutHotbar();
+	HUDScreen_LayoutProfiler(s);
+	HUDScreen_LayoutMemory(s);
 	Widget_Layout(line2);
+
+	/* Frame stats go below whichever of the two lines is lower */
+	Widget_SetLocation(&s->frameStats, ANCHOR_MIN, ANCHOR_MIN, 2, 0);
+	s->frameStats.yOffset = max(line1->y + line1->height, line2->y + line2->height);
+	Widget_Layout(&s->frameStats);
 }
 
 static int HUDScreen_KeyDown(void* screen, int key) {
@@ -285,19 +399,25 @@ static void HUDScreen_HacksChanged(void* obj) {
 
 static void HUDScreen_Init(void* screen) {
 	struct HUDScreen* s = (struct HUDScreen*)screen;
+	int i;
 	HotbarWidget_Create(&s->hotbar);
 	TextWidget_Init(&s->line1);
 	TextWidget_Init(&s->line2);
+	TextWidget_Init(&s->frameStats);
+	for (i = 0; i < HUD_PROFILER_LINES; i++) { TextWidget_Init(&s->profiler[i]); }
+	for (i = 0; i < HUD_MEMORY_LINES;   i++) { TextWidget_Init(&s->memory[i]); }
 	Event_Register_(&UserEvents.HacksStateChanged, screen, HUDScreen_HacksChanged);
 }
 
 static void HUDScreen_Render(void* screen, double delta) {
 	struct HUDScreen* s = (struct HUDScreen*)screen;
+	int i;
 	if (Game_HideGui) return;
 
 	/* TODO: If Game_ShowFps is off and not classic mode, we should just return here */
 	Gfx_SetTexturing(true);
 	if (Gui.ShowFPS) Elem_Render(&s->line1, delta);
+	if (Gui.ShowFPS && Profiler_ShowFrameStats) Elem_Render(&s->frameStats, delta);
 
 	if (Game_ClassicMode) {
 		Elem_Render(&s->line2, delta);
@@ -307,6 +427,13 @@ static void HUDScreen_Render(void* screen, double delta) {
 		Elem_Render(&s->line2, delta);
 	}
 
+	if (Profiler_Enabled) {
+		for (i = 0; i < HUD_PROFILER_LINES; i++) { Elem_Render(&s->profiler[i], delta); }
+	}
+	if (Profiler_ShowMemory) {
+		for (i = 0; i < HUD_MEMORY_LINES; i++) { Elem_Render(&s->memory[i], delta); }
+	}
+
 	if (!Gui_GetBlocksWorld()) Elem_Render(&s->hotbar, delta);
 	Gfx_SetTexturing(false);
 }
@@ -958,6 +1085,8 @@ static void ChatScreen_ChatReceived(void* screen, const cc_string* msg, int type
 		/* Status[0] is for texture pack downloading message */
 		/* Status[1] is for reduced performance mode message */
 		TextGroupWidget_Redraw(&s->status, type - MSG_TYPE_EXTRASTATUS_1);
+	} else if (type == MSG_TYPE_EXTRASTATUS_3) {
+		TextGroupWidget_Redraw(&s->status, 5);
 	} 
 }
 
@@ -1309,6 +1438,7 @@ static void ChatScreen_Init(void* screen) {
 
 	s->status.collapsible[0]       = true; /* Texture pack downloading status */
 	s->status.collapsible[1]       = true; /* Reduced performance mode status */
+	s->status.collapsible[5]       = true; /* Background map saving status */
 	s->clientStatus.collapsible[0] = true;
 	s->clientStatus.collapsible[1] = true;
 
@@ -1748,6 +1878,7 @@ static void GeneratingScreen_Init(void* screen) {
 	LoadingScreen_Init(screen);
 
 	Gen_Blocks = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+	Mem_SetPlace(Gen_Blocks, "map blocks");
 	if (!Gen_Blocks) {
 		Window_ShowDialog("Out of memory", "Not enough free memory to generate a map that large.\nTry a smaller size.");
 		Gen_Done = true;
@@ -24,6 +24,8 @@
 #include "Platform.h"
 #include "Input.h"
 #include "Errors.h"
+#include "Options.h"
+#include "Profiler.h"
 
 static char nameBuffer[STRING_SIZE];
 static char motdBuffer[STRING_SIZE];
@@ -180,18 +182,37 @@ static void SPConnection_SendBlock(int x, int y, int z, BlockID old, BlockID now
 static void SPConnection_SendPosition(Vec3 pos, float yaw, float pitch) { }
 static void SPConnection_SendData(const cc_uint8* data, cc_uint32 len) { }
 
+/* Regions of the world modified since the last autosave are periodically written to a */
+/*  .ccw file on a background thread, so that saving doesn't cause the game to stutter */
+static const cc_string autosave_path = String_FromConst("maps/autosave.ccw");
+static int autosave_interval;
+static double autosave_last;
+
+static void Autosave_Tick(void) {
+	cc_result res;
+	if (!autosave_interval || !World.Loaded || !World.Blocks) return;
+	if (Game.Time < autosave_last + autosave_interval) return;
+	autosave_last = Game.Time;
+
+	res = Map_AutosaveInBackground(&autosave_path);
+	if (res) Logger_SysWarn2(res, "autosaving", &autosave_path);
+}
+
 static void SPConnection_Tick(struct ScheduledTask* task) {
 	if (Server.Disconnected) return;
 	if ((ticks % 3) == 0) { /* 60 -> 20 ticks a second */
-		Physics_Tick();
+		Profiler_Zone("Physics_Tick", Physics_Tick());
 		TexturePack_CheckPending();
 	}
+	Autosave_Tick();
 	ticks++;
 }
 
 static void SPConnection_Init(void) {
 	Server_ResetState();
 	Physics_Init();
+	/* Autosaving is opt-in, as it writes an extra file to the maps folder */
+	autosave_interval = Options_GetInt(OPT_AUTOSAVE_INTERVAL, 0, 3600, 0);
 
 	Server.BeginConnect = SPConnection_BeginConnect;
 	Server.Tick         = SPConnection_Tick;
@@ -509,6 +530,10 @@ static void OnNewMap(void) {
 	}
 }
 
+static void Server_Tick(struct ScheduledTask* task) {
+	Profiler_Zone("Server.Tick", Server.Tick(task));
+}
+
 static void OnInit(void) {
 	String_InitArray(Server.Name,    nameBuffer);
 	String_InitArray(Server.MOTD,    motdBuffer);
@@ -520,7 +545,7 @@ static void OnInit(void) {
 		MPConnection_Init();
 	}
 
-	ScheduledTask_Add(GAME_NET_TICKS, Server.Tick);
+	ScheduledTask_AddEx("Server.Tick", GAME_NET_TICKS, Server_Tick, TASK_PRIORITY_HIGH, 0, 0);
 	String_AppendConst(&Server.AppName, GAME_APP_NAME);
 
 #ifdef CC_BUILD_WEB
@@ -264,6 +264,16 @@ static cc_result Stream_MemoryLength(struct Stream* s, cc_uint32* length) {
 	*length = s->Meta.Mem.Length; return 0;
 }
 
+static cc_result Stream_MemoryWrite(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	count = min(count, s->Meta.Mem.Left);
+	Mem_Copy(s->Meta.Mem.Cur, data, count);
+
+	s->Meta.Mem.Cur  += count;
+	s->Meta.Mem.Left -= count;
+	*modified = count;
+	return 0;
+}
+
 void Stream_ReadonlyMemory(struct Stream* s, void* data, cc_uint32 len) {
 	Stream_Init(s);
 	s->Read     = Stream_MemoryRead;
@@ -279,6 +289,18 @@ void Stream_ReadonlyMemory(struct Stream* s, void* data, cc_uint32 len) {
 	s->Meta.Mem.Base   = (cc_uint8*)data;
 }
 
+void Stream_WriteonlyMemory(struct Stream* s, void* data, cc_uint32 len) {
+	Stream_Init(s);
+	s->Write    = Stream_MemoryWrite;
+	s->Position = Stream_MemoryPosition;
+	s->Length   = Stream_MemoryLength;
+
+	s->Meta.Mem.Cur    = (cc_uint8*)data;
+	s->Meta.Mem.Left   = len;
+	s->Meta.Mem.Length = len;
+	s->Meta.Mem.Base   = (cc_uint8*)data;
+}
+
 
 /*########################################################################################################################*
 *----------------------------------------------------BufferedStream-------------------------------------------------------*
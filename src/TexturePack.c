@@ -79,6 +79,7 @@ static void Atlas_Update1D(void) {
 /* Loads the given atlas and converts it into an array of 1D atlases. */
 static void Atlas_Update(struct Bitmap* bmp) {
 	Atlas2D.Bmp       = *bmp;
+	Mem_SetPlace(bmp->scan0, "terrain atlas");
 	Atlas2D.TileSize  = bmp->width  / ATLAS2D_TILES_PER_ROW;
 	Atlas2D.RowsCount = bmp->height / Atlas2D.TileSize;
 	Atlas2D.RowsCount = min(Atlas2D.RowsCount, ATLAS2D_MAX_ROWS_COUNT);
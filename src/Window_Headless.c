@@ -0,0 +1,111 @@
+#include "Core.h"
+#if defined CC_BUILD_HEADLESS
+#include "_WindowBase.h"
+#include "Graphics.h"
+#include "String.h"
+#include "Funcs.h"
+#include "Bitmap.h"
+#include "Errors.h"
+/* Headless backend: there is no display or native window at all. */
+/* The 'window' only tracks its size/state, and never receives any input. */
+static cc_bool win_closing;
+static int win_state, cursorX, cursorY;
+static char clipboardBuffer[512];
+static cc_string clipboard = String_FromArray(clipboardBuffer);
+
+void Window_Init(void) {
+	DisplayInfo.Width  = 1920;
+	DisplayInfo.Height = 1080;
+	DisplayInfo.Depth  = 24;
+	DisplayInfo.ScaleX = 1;
+	DisplayInfo.ScaleY = 1;
+}
+
+static void DoCreateWindow(int width, int height) {
+	WindowInfo.Width   = width;
+	WindowInfo.Height  = height;
+	WindowInfo.Exists  = true;
+	/* Otherwise the game would immediately show the pause menu */
+	WindowInfo.Focused = true;
+	win_closing = false;
+	win_state   = WINDOW_STATE_NORMAL;
+}
+void Window_Create2D(int width, int height) { DoCreateWindow(width, height); }
+void Window_Create3D(int width, int height) { DoCreateWindow(width, height); }
+
+void Window_SetTitle(const cc_string* title) { }
+
+void Clipboard_GetText(cc_string* value) { String_AppendString(value, &clipboard); }
+void Clipboard_SetText(const cc_string* value) { String_Copy(&clipboard, value); }
+
+int Window_GetWindowState(void) { return win_state; }
+
+static void SetWindowState(int state, int width, int height) {
+	win_state = state;
+	Window_SetSize(width, height);
+	Event_RaiseVoid(&WindowEvents.StateChanged);
+}
+
+static int prevWidth, prevHeight;
+cc_result Window_EnterFullscreen(void) {
+	prevWidth = WindowInfo.Width; prevHeight = WindowInfo.Height;
+	SetWindowState(WINDOW_STATE_FULLSCREEN, DisplayInfo.Width, DisplayInfo.Height);
+	return 0;
+}
+
+cc_result Window_ExitFullscreen(void) {
+	SetWindowState(WINDOW_STATE_NORMAL, prevWidth, prevHeight);
+	return 0;
+}
+
+int Window_IsObscured(void) { return 0; }
+void Window_Show(void) { }
+
+void Window_SetSize(int width, int height) {
+	if (width == WindowInfo.Width && height == WindowInfo.Height) return;
+	WindowInfo.Width  = width;
+	WindowInfo.Height = height;
+	Event_RaiseVoid(&WindowEvents.Resized);
+}
+
+void Window_Close(void) { win_closing = true; }
+
+void Window_ProcessEvents(void) {
+	/* Like other backends, closing is only processed on the next event poll */
+	if (!win_closing || !WindowInfo.Exists) return;
+	Platform_LogConst("Exit message received.");
+	Event_RaiseVoid(&WindowEvents.Closing);
+	WindowInfo.Exists = false;
+}
+
+static void Cursor_GetRawPos(int* x, int* y) { *x = cursorX; *y = cursorY; }
+void Cursor_SetPosition(int x, int y) { cursorX = x; cursorY = y; }
+static void Cursor_DoSetVisible(cc_bool visible) { }
+
+static void ShowDialogCore(const char* title, const char* msg) {
+	/* No display to show a dialog on, so log the message instead */
+	Platform_Log2("%c: %c", title, msg);
+}
+
+cc_result Window_OpenFileDialog(const char* const* filters, OpenFileDialogCallback callback) {
+	return ERR_NOT_SUPPORTED;
+}
+
+void Window_AllocFramebuffer(struct Bitmap* bmp) {
+	bmp->scan0 = (BitmapCol*)Mem_Alloc(bmp->width * bmp->height, 4, "window pixels");
+}
+
+void Window_DrawFramebuffer(Rect2D r) { }
+
+void Window_FreeFramebuffer(struct Bitmap* bmp) {
+	Mem_Free(bmp->scan0);
+}
+
+void Window_OpenKeyboard(const struct OpenKeyboardArgs* args) { }
+void Window_SetKeyboardText(const cc_string* text) { }
+void Window_CloseKeyboard(void) { }
+
+void Window_EnableRawMouse(void)  { DefaultEnableRawMouse();  }
+void Window_UpdateRawMouse(void)  { DefaultUpdateRawMouse();  }
+void Window_DisableRawMouse(void) { DefaultDisableRawMouse(); }
+#endif
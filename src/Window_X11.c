@@ -231,7 +231,7 @@ static void HookXErrors(void) {
 /*########################################################################################################################*
 *--------------------------------------------------Public implementation--------------------------------------------------*
 *#########################################################################################################################*/
-#ifdef CC_BUILD_EGL
+#if defined CC_BUILD_EGL || !defined CC_BUILD_GL
 static XVisualInfo GLContext_SelectVisual(void) {
 	XVisualInfo info;
 	cc_result res;
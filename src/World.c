@@ -8,10 +8,20 @@
 #include "ExtMath.h"
 #include "Physics.h"
 #include "Game.h"
+#include "Funcs.h"
 #include "TexturePack.h"
 #include "Window.h"
 
 struct _WorldData World;
+static cc_uint8* dirtyRegions;
+static int dirtyRegionsX, dirtyRegionsZ, dirtyRegionsCount;
+
+/* Number of gas and fully opaque blocks in each chunk */
+static struct ChunkCounts { cc_uint16 gas, opaque, volume; }* chunkCounts;
+static int chunkCountsX, chunkCountsY, chunkCountsZ, chunkCountsCount;
+/* Chunk has not been counted yet, since the map was loaded or block definitions changed */
+#define COUNTS_UNKNOWN 0xFFFF
+
 /*########################################################################################################################*
 *----------------------------------------------------------World----------------------------------------------------------*
 *#########################################################################################################################*/
@@ -44,6 +54,10 @@ void World_Reset(void) {
 #endif
 	Mem_Free(World.Blocks);
 	World.Blocks = NULL;
+	Mem_Free(dirtyRegions);
+	dirtyRegions = NULL;
+	Mem_Free(chunkCounts);
+	chunkCounts = NULL;
 
 	World_SetDimensions(0, 0, 0);
 	World.Loaded   = false;
@@ -51,6 +65,41 @@ void World_Reset(void) {
 	Env_Reset();
 }
 
+static void InitDirtyRegions(void) {
+	int mask = (1 << WORLD_REGION_SHIFT) - 1;
+	dirtyRegionsX     = (World.Width  + mask) >> WORLD_REGION_SHIFT;
+	dirtyRegionsZ     = (World.Length + mask) >> WORLD_REGION_SHIFT;
+	dirtyRegionsCount = dirtyRegionsX * dirtyRegionsZ * ((World.Height + mask) >> WORLD_REGION_SHIFT);
+
+	Mem_Free(dirtyRegions);
+	/* If this fails, World_IsRegionDirty just always returns true */
+	dirtyRegions = (cc_uint8*)Mem_TryAlloc((dirtyRegionsCount + 7) >> 3, 1);
+	Mem_SetPlace(dirtyRegions, "dirty regions");
+	if (dirtyRegions) Mem_Set(dirtyRegions, 0xFF, (dirtyRegionsCount + 7) >> 3);
+}
+
+static void InvalidateChunkCounts(void) {
+	int i;
+	if (!chunkCounts) return;
+
+	for (i = 0; i < chunkCountsCount; i++) {
+		chunkCounts[i].gas = COUNTS_UNKNOWN;
+	}
+}
+
+static void InitChunkCounts(void) {
+	chunkCountsX     = (World.Width  + CHUNK_MAX) >> CHUNK_SHIFT;
+	chunkCountsY     = (World.Height + CHUNK_MAX) >> CHUNK_SHIFT;
+	chunkCountsZ     = (World.Length + CHUNK_MAX) >> CHUNK_SHIFT;
+	chunkCountsCount = chunkCountsX * chunkCountsY * chunkCountsZ;
+
+	Mem_Free(chunkCounts);
+	/* If this fails, World_GetChunkOccupancy just always returns mixed */
+	chunkCounts = (struct ChunkCounts*)Mem_TryAlloc(chunkCountsCount, sizeof(struct ChunkCounts));
+	Mem_SetPlace(chunkCounts, "chunk counts");
+	InvalidateChunkCounts();
+}
+
 void World_NewMap(void) {
 	World_Reset();
 	Event_RaiseVoid(&WorldEvents.NewMap);
@@ -72,6 +121,8 @@ void World_SetNewMap(BlockRaw* blocks, int width, int height, int length) {
 	}
 #endif
 
+	InitDirtyRegions();
+	InitChunkCounts();
 	if (Env.EdgeHeight == -1)   { Env.EdgeHeight   = height / 2; }
 	if (Env.CloudsHeight == -1) { Env.CloudsHeight = height + 2; }
 
@@ -103,9 +154,94 @@ void World_OutOfMemory(void) {
 }
 
 
+static CC_INLINE void MarkRegionDirty(int x, int y, int z) {
+	int region;
+	if (!dirtyRegions) return;
+
+	region = ((y >> WORLD_REGION_SHIFT) * dirtyRegionsZ + (z >> WORLD_REGION_SHIFT)) * dirtyRegionsX + (x >> WORLD_REGION_SHIFT);
+	dirtyRegions[region >> 3] |= 1 << (region & 7);
+}
+
+cc_bool World_IsRegionDirty(int region) {
+	if (!dirtyRegions || (unsigned)region >= (unsigned)dirtyRegionsCount) return true;
+	return (dirtyRegions[region >> 3] & (1 << (region & 7))) != 0;
+}
+
+void World_ClearDirtyRegions(void) {
+	if (dirtyRegions) Mem_Set(dirtyRegions, 0, (dirtyRegionsCount + 7) >> 3);
+}
+
+
+#define ChunkCounts_Pack(cx, cy, cz) (((cy) * chunkCountsZ + (cz)) * chunkCountsX + (cx))
+static CC_INLINE void UpdateChunkCounts(int x, int y, int z, BlockID old, BlockID now) {
+	struct ChunkCounts* counts;
+	if (!chunkCounts) return;
+
+	counts = &chunkCounts[ChunkCounts_Pack(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT)];
+	if (counts->gas == COUNTS_UNKNOWN) return;
+
+	counts->gas    += (Blocks.Draw[now] == DRAW_GAS) - (Blocks.Draw[old] == DRAW_GAS);
+	counts->opaque += Blocks.FullOpaque[now] - Blocks.FullOpaque[old];
+}
+
+static void CountChunk(struct ChunkCounts* counts, int cx, int cy, int cz) {
+	int gas = 0, opaque = 0;
+	int x1, y1, z1, x2, y2, z2;
+	int x, y, z;
+	BlockID block;
+
+	/* Chunks on the far edges of the map may not be a full 16x16x16 blocks */
+	x1 = cx << CHUNK_SHIFT; x2 = min(World.Width,  x1 + CHUNK_SIZE);
+	y1 = cy << CHUNK_SHIFT; y2 = min(World.Height, y1 + CHUNK_SIZE);
+	z1 = cz << CHUNK_SHIFT; z2 = min(World.Length, z1 + CHUNK_SIZE);
+
+	for (y = y1; y < y2; y++) {
+		for (z = z1; z < z2; z++) {
+			for (x = x1; x < x2; x++) {
+				block   = World_GetBlock(x, y, z);
+				gas    += Blocks.Draw[block] == DRAW_GAS;
+				opaque += Blocks.FullOpaque[block];
+			}
+		}
+	}
+	counts->gas    = gas; counts->opaque = opaque;
+	counts->volume = (x2 - x1) * (y2 - y1) * (z2 - z1);
+}
+
+int World_GetChunkOccupancy(int cx, int cy, int cz) {
+	struct ChunkCounts* counts;
+	if (!chunkCounts || (unsigned)cx >= (unsigned)chunkCountsX 
+		|| (unsigned)cy >= (unsigned)chunkCountsY || (unsigned)cz >= (unsigned)chunkCountsZ) return CHUNK_OCCUPANCY_MIXED;
+
+	counts = &chunkCounts[ChunkCounts_Pack(cx, cy, cz)];
+	if (counts->gas == COUNTS_UNKNOWN) CountChunk(counts, cx, cy, cz);
+
+	if (counts->gas    == counts->volume) return CHUNK_OCCUPANCY_AIR;
+	if (counts->opaque == counts->volume) return CHUNK_OCCUPANCY_OPAQUE;
+	return CHUNK_OCCUPANCY_MIXED;
+}
+
+int World_GetOccupancy(int minX, int minY, int minZ, int maxX, int maxY, int maxZ) {
+	int cx, cy, cz, occupancy, cur;
+	if (!World_Contains(minX, minY, minZ) || !World_Contains(maxX, maxY, maxZ)) return CHUNK_OCCUPANCY_MIXED;
+	occupancy = World_GetChunkOccupancy(minX >> CHUNK_SHIFT, minY >> CHUNK_SHIFT, minZ >> CHUNK_SHIFT);
+	if (occupancy == CHUNK_OCCUPANCY_MIXED) return occupancy;
+
+	for (cy = minY >> CHUNK_SHIFT; cy <= (maxY >> CHUNK_SHIFT); cy++) {
+		for (cz = minZ >> CHUNK_SHIFT; cz <= (maxZ >> CHUNK_SHIFT); cz++) {
+			for (cx = minX >> CHUNK_SHIFT; cx <= (maxX >> CHUNK_SHIFT); cx++) {
+				cur = World_GetChunkOccupancy(cx, cy, cz);
+				if (cur != occupancy) return CHUNK_OCCUPANCY_MIXED;
+			}
+		}
+	}
+	return occupancy;
+}
+
 #ifdef EXTENDED_BLOCKS
 static CC_NOINLINE void LazyInitUpper(int i, BlockID block) {
 	BlockRaw* data = (BlockRaw*)Mem_TryAllocCleared(World.Volume, 1);
+	Mem_SetPlace(data, "map blocks");
 	if (!data) { World_OutOfMemory(); return; }
 
 	World_SetMapUpper(data);
@@ -114,7 +250,9 @@ static CC_NOINLINE void LazyInitUpper(int i, BlockID block) {
 
 void World_SetBlock(int x, int y, int z, BlockID block) {
 	int i = World_Pack(x, y, z);
+	UpdateChunkCounts(x, y, z, World_GetBlock(x, y, z), block);
 	World.Blocks[i] = (BlockRaw)block;
+	MarkRegionDirty(x, y, z);
 
 	/* defer allocation of second map array if possible */
 	if (World.Blocks == World.Blocks2) {
@@ -126,7 +264,9 @@ void World_SetBlock(int x, int y, int z, BlockID block) {
 }
 #else
 void World_SetBlock(int x, int y, int z, BlockID block) {
+	UpdateChunkCounts(x, y, z, World.Blocks[World_Pack(x, y, z)], block);
 	World.Blocks[World_Pack(x, y, z)] = block; 
+	MarkRegionDirty(x, y, z);
 }
 #endif
 
@@ -303,7 +443,14 @@ Vec3 Respawn_FindSpawnPosition(float x, float z, Vec3 modelSize) {
 	return spawn;
 }
 
+static void OnBlockDefChanged(void* obj) { InvalidateChunkCounts(); }
+
+static void OnInit(void) {
+	World_Reset();
+	Event_Register_(&BlockEvents.BlockDefChanged, NULL, OnBlockDefChanged);
+}
+
 struct IGameComponent World_Component = {
-	World_Reset, /* Init  */
-	World_Reset  /* Free  */
+	OnInit,     /* Init  */
+	World_Reset /* Free  */
 };
@@ -86,6 +86,24 @@ void World_SetBlock(int x, int y, int z, BlockID block);
 /* Otherwise returns the block at the given coordinates. */
 BlockID World_SafeGetBlock(int x, int y, int z);
 
+/* Changes to blocks are tracked in cubic regions of (1 << WORLD_REGION_SHIFT) blocks. */
+/* Regions are ordered by Y, then Z, then X. (same as blocks) */
+#define WORLD_REGION_SHIFT 5
+/* Whether the given region has been modified since World_ClearDirtyRegions was last called. */
+/* NOTE: All regions are treated as modified after a new map is loaded. */
+cc_bool World_IsRegionDirty(int region);
+/* Resets all regions to not being modified. */
+void World_ClearDirtyRegions(void);
+
+/* Describes the kind of blocks contained in a chunk (16x16x16 region of blocks). */
+enum ChunkOccupancy { CHUNK_OCCUPANCY_MIXED, CHUNK_OCCUPANCY_AIR, CHUNK_OCCUPANCY_OPAQUE };
+/* Returns whether all blocks in the given chunk are drawn as gas, are all fully opaque, or neither. */
+/* NOTE: Chunks outside the map are always treated as mixed. */
+int World_GetChunkOccupancy(int cx, int cy, int cz);
+/* Returns CHUNK_OCCUPANCY_AIR/OPAQUE if all chunks overlapping the given region of blocks are air/opaque. */
+/* NOTE: Regions that extend outside the map are always treated as mixed. */
+int World_GetOccupancy(int minX, int minY, int minZ, int maxX, int maxY, int maxZ);
+
 /* Whether the given coordinates lie inside the map. */
 static CC_INLINE cc_bool World_Contains(int x, int y, int z) {
 	return (unsigned)x < (unsigned)World.Width
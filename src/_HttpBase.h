@@ -271,7 +271,7 @@ static void Http_InitCommon(void) {
 	httpsVerify = Options_GetBool(OPT_HTTPS_VERIFY, true);
 
 	Options_Get(OPT_SKIN_SERVER, &skinServer, SKINS_SERVER);
-	ScheduledTask_Add(30, Http_CleanCacheTask);
+	ScheduledTask_AddEx("Http_CleanCache", 30, Http_CleanCacheTask, TASK_PRIORITY_LOW, 1, 0);
 }
 static void Http_Init(void);
 
@@ -25,29 +25,279 @@ CC_NOINLINE static void AbortOnAllocFailed(const char* place) {
 	Logger_Abort(log.buffer);
 }
 
+static CC_NOINLINE cc_uint32 CalcMemSize(cc_uint32 numElems, cc_uint32 elemsSize) {
+	if (!numElems) return 1; /* treat 0 size as 1 byte */
+	cc_uint32 numBytes = numElems * elemsSize; /* TODO: avoid overflow here */
+	if (numBytes < numElems) return 0; /* TODO: Use proper overflow checking */
+	return numBytes;
+}
+
+/* Implemented by each platform backend */
+static void* Mem_SysAlloc(cc_uint32 size, cc_bool cleared);
+static void* Mem_SysRealloc(void* mem, cc_uint32 size);
+static void  Mem_SysFree(void* mem);
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Memory tracking-----------------------------------------------------*
+*#########################################################################################################################*/
+/* Live blocks are kept in an open addressing hash table keyed by address, */
+/*  so the size and place of a block are known again when it is freed */
+#define MEM_MIN_BLOCKS 1024
+#define MEM_MAX_PLACES 256
+#define MEM_UNNAMED_PLACE "(unnamed)"
+#define MEM_OTHER_PLACES  "(other places)"
+struct MemBlock { void* mem; cc_uint32 size; int place; };
+
+static volatile cc_bool mem_tracking;
+static struct MemTracker {
+	void* mutex;
+	struct MemBlock* blocks;
+	int count, capacity; /* capacity is always a power of two */
+	struct MemPlaceStats places[MEM_MAX_PLACES];
+	int placesCount;
+	struct MemPlaceStats total;
+} mem_tracker;
+
+static int MemTracker_Hash(void* ptr) {
+	cc_uint32 hash = (cc_uint32)((cc_uintptr)ptr >> 4) * 2654435761U;
+	return (int)((hash ^ (hash >> 16)) & (mem_tracker.capacity - 1));
+}
+
+/* Returns the slot of the given block, or the empty slot it would be put into */
+static int MemTracker_Find(void* ptr) {
+	int i = MemTracker_Hash(ptr);
+	while (mem_tracker.blocks[i].mem && mem_tracker.blocks[i].mem != ptr) {
+		i = (i + 1) & (mem_tracker.capacity - 1);
+	}
+	return i;
+}
+
+static cc_bool MemTracker_Grow(void) {
+	struct MemBlock* blocks = mem_tracker.blocks;
+	int i, slot, capacity   = mem_tracker.capacity;
+	int newCapacity = capacity ? capacity * 2 : MEM_MIN_BLOCKS;
+
+	mem_tracker.blocks = (struct MemBlock*)Mem_SysAlloc(newCapacity * sizeof(struct MemBlock), true);
+	if (!mem_tracker.blocks) { mem_tracker.blocks = blocks; return false; }
+	mem_tracker.capacity = newCapacity;
+
+	for (i = 0; i < capacity; i++) {
+		if (!blocks[i].mem) continue;
+		slot = MemTracker_Find(blocks[i].mem);
+		mem_tracker.blocks[slot] = blocks[i];
+	}
+	Mem_SysFree(blocks);
+	return true;
+}
+
+static int MemTracker_FindPlace(const char* place) {
+	cc_string str;
+	int i;
+	if (!place) place = MEM_UNNAMED_PLACE;
+
+	/* Places are usually string constants, so try the fast check first */
+	for (i = 0; i < mem_tracker.placesCount; i++) {
+		if (mem_tracker.places[i].place == place) return i;
+	}
+	str = String_FromReadonly(place);
+	for (i = 0; i < mem_tracker.placesCount; i++) {
+		if (String_CaselessEqualsConst(&str, mem_tracker.places[i].place)) return i;
+	}
+
+	/* Last slot is shared by any places beyond the limit */
+	if (mem_tracker.placesCount == MEM_MAX_PLACES) return MEM_MAX_PLACES - 1;
+	if (mem_tracker.placesCount == MEM_MAX_PLACES - 1) place = MEM_OTHER_PLACES;
+	i = mem_tracker.placesCount++;
+	mem_tracker.places[i].place = place;
+	return i;
+}
+
+static void MemTracker_AddStats(struct MemPlaceStats* stats, cc_uint32 size, cc_bool isNew) {
+	stats->curBytes += size;
+	stats->curAllocs++;
+	if (stats->curBytes > stats->peakBytes) stats->peakBytes = stats->curBytes;
+	if (isNew) stats->totalAllocs++;
+}
+
+static void MemTracker_Insert(void* ptr, cc_uint32 size, int place, cc_bool isNew) {
+	struct MemBlock* block;
+	/* Keep table at most half full, so that probe sequences stay short */
+	if ((mem_tracker.count + 1) * 2 > mem_tracker.capacity && !MemTracker_Grow()) return;
+
+	block = &mem_tracker.blocks[MemTracker_Find(ptr)];
+	block->mem   = ptr;
+	block->size  = size;
+	block->place = place;
+	mem_tracker.count++;
+
+	MemTracker_AddStats(&mem_tracker.places[place], size, isNew);
+	MemTracker_AddStats(&mem_tracker.total,         size, isNew);
+}
+
+/* Removes the given block, returning false if it was allocated before tracking started */
+static cc_bool MemTracker_Remove(void* ptr, struct MemBlock* removed) {
+	struct MemPlaceStats* stats;
+	int i, j, home;
+	if (!mem_tracker.count) return false;
+
+	i = MemTracker_Find(ptr);
+	if (!mem_tracker.blocks[i].mem) return false;
+	*removed = mem_tracker.blocks[i];
+
+	stats = &mem_tracker.places[removed->place];
+	stats->curBytes -= removed->size;
+	stats->curAllocs--;
+	mem_tracker.total.curBytes -= removed->size;
+	mem_tracker.total.curAllocs--;
+	mem_tracker.count--;
+
+	/* Shift back later blocks in the same probe sequence, to fill the gap */
+	for (j = i;;) {
+		j = (j + 1) & (mem_tracker.capacity - 1);
+		if (!mem_tracker.blocks[j].mem) break;
+		home = MemTracker_Hash(mem_tracker.blocks[j].mem);
+
+		/* Block can only move back if its home slot isn't cyclically between the gap and itself */
+		if (i <= j ? (home <= i || home > j) : (home <= i && home > j)) {
+			mem_tracker.blocks[i] = mem_tracker.blocks[j];
+			i = j;
+		}
+	}
+	mem_tracker.blocks[i].mem = NULL;
+	return true;
+}
+
+static void* Mem_AllocTracked(cc_uint32 numElems, cc_uint32 elemsSize, cc_bool cleared, const char* place) {
+	cc_uint32 size = CalcMemSize(numElems, elemsSize);
+	void* ptr      = size ? Mem_SysAlloc(size, cleared) : NULL;
+	if (!ptr || !mem_tracking) return ptr;
+
+	Mutex_Lock(mem_tracker.mutex);
+	if (mem_tracking) MemTracker_Insert(ptr, size, MemTracker_FindPlace(place), true);
+	Mutex_Unlock(mem_tracker.mutex);
+	return ptr;
+}
+
+static void* Mem_ReallocTracked(void* mem, cc_uint32 numElems, cc_uint32 elemsSize, const char* place) {
+	cc_uint32 size = CalcMemSize(numElems, elemsSize);
+	struct MemBlock old;
+	cc_bool tracked;
+	void* ptr;
+
+	if (!size) return NULL;
+	if (!mem_tracking) return Mem_SysRealloc(mem, size);
+
+	/* Old block must be removed before reallocating, as afterwards its address may be reused */
+	/* NOTE: Only the removed copy of the old block is used after reallocating, not mem */
+	Mutex_Lock(mem_tracker.mutex);
+	tracked = mem_tracking && MemTracker_Remove(mem, &old);
+	Mutex_Unlock(mem_tracker.mutex);
+
+	ptr = Mem_SysRealloc(mem, size);
+	Mutex_Lock(mem_tracker.mutex);
+	if (mem_tracking && ptr) {
+		MemTracker_Insert(ptr, size, tracked && !place ? old.place : MemTracker_FindPlace(place), !tracked);
+	} else if (mem_tracking && tracked) {
+		/* Old block is still allocated when reallocating fails */
+		MemTracker_Insert(old.mem, old.size, old.place, false);
+	}
+	Mutex_Unlock(mem_tracker.mutex);
+	return ptr;
+}
+
+void Mem_SetPlace(void* mem, const char* place) {
+	struct MemBlock old;
+	if (!mem || !mem_tracking) return;
+
+	Mutex_Lock(mem_tracker.mutex);
+	if (mem_tracking && MemTracker_Remove(mem, &old)) {
+		mem_tracker.places[old.place].totalAllocs--;
+		mem_tracker.total.totalAllocs--;
+		MemTracker_Insert(mem, old.size, MemTracker_FindPlace(place), true);
+	}
+	Mutex_Unlock(mem_tracker.mutex);
+}
+
+cc_bool Mem_IsTracking(void) { return mem_tracking; }
+
+void Mem_SetTracking(cc_bool enabled) {
+	if (enabled == mem_tracking) return;
+	/* NOTE: Mutex must be created before tracking starts, since creating it allocates memory */
+	if (!mem_tracker.mutex) mem_tracker.mutex = Mutex_Create();
+
+	Mutex_Lock(mem_tracker.mutex);
+	{
+		Mem_SysFree(mem_tracker.blocks);
+		mem_tracker.blocks      = NULL;
+		mem_tracker.count       = 0;
+		mem_tracker.capacity    = 0;
+		mem_tracker.placesCount = 0;
+		mem_tracking    = enabled;
+		Mem_Set(&mem_tracker.total, 0, sizeof(mem_tracker.total));
+	}
+	Mutex_Unlock(mem_tracker.mutex);
+}
+
+int Mem_GetPlaceStats(struct MemPlaceStats* places, int maxPlaces, struct MemPlaceStats* total) {
+	int count = 0;
+	Mem_Set(total, 0, sizeof(*total));
+
+	if (mem_tracking) {
+		Mutex_Lock(mem_tracker.mutex);
+		count  = mem_tracker.placesCount < maxPlaces ? mem_tracker.placesCount : maxPlaces;
+		Mem_Copy(places, mem_tracker.places, count * sizeof(struct MemPlaceStats));
+		*total = mem_tracker.total;
+		Mutex_Unlock(mem_tracker.mutex);
+	}
+	total->place = "Total";
+	return count;
+}
+
+
+/*########################################################################################################################*
+*------------------------------------------------------Memory allocation--------------------------------------------------*
+*#########################################################################################################################*/
+void* Mem_TryAlloc(cc_uint32 numElems, cc_uint32 elemsSize) {
+	return Mem_AllocTracked(numElems, elemsSize, false, NULL);
+}
+
+void* Mem_TryAllocCleared(cc_uint32 numElems, cc_uint32 elemsSize) {
+	return Mem_AllocTracked(numElems, elemsSize, true, NULL);
+}
+
+void* Mem_TryRealloc(void* mem, cc_uint32 numElems, cc_uint32 elemsSize) {
+	return Mem_ReallocTracked(mem, numElems, elemsSize, NULL);
+}
+
 void* Mem_Alloc(cc_uint32 numElems, cc_uint32 elemsSize, const char* place) {
-	void* ptr = Mem_TryAlloc(numElems, elemsSize);
+	void* ptr = Mem_AllocTracked(numElems, elemsSize, false, place);
 	if (!ptr) AbortOnAllocFailed(place);
 	return ptr;
 }
 
 void* Mem_AllocCleared(cc_uint32 numElems, cc_uint32 elemsSize, const char* place) {
-	void* ptr = Mem_TryAllocCleared(numElems, elemsSize);
+	void* ptr = Mem_AllocTracked(numElems, elemsSize, true, place);
 	if (!ptr) AbortOnAllocFailed(place);
 	return ptr;
 }
 
 void* Mem_Realloc(void* mem, cc_uint32 numElems, cc_uint32 elemsSize, const char* place) {
-	void* ptr = Mem_TryRealloc(mem, numElems, elemsSize);
+	void* ptr = Mem_ReallocTracked(mem, numElems, elemsSize, place);
 	if (!ptr) AbortOnAllocFailed(place);
 	return ptr;
 }
 
-static CC_NOINLINE cc_uint32 CalcMemSize(cc_uint32 numElems, cc_uint32 elemsSize) {
-	if (!numElems) return 1; /* treat 0 size as 1 byte */
-	cc_uint32 numBytes = numElems * elemsSize; /* TODO: avoid overflow here */
-	if (numBytes < numElems) return 0; /* TODO: Use proper overflow checking */
-	return numBytes;
+void Mem_Free(void* mem) {
+	struct MemBlock old;
+	if (!mem) return;
+
+	if (mem_tracking) {
+		Mutex_Lock(mem_tracker.mutex);
+		if (mem_tracking) MemTracker_Remove(mem, &old);
+		Mutex_Unlock(mem_tracker.mutex);
+	}
+	Mem_SysFree(mem);
 }
 
 
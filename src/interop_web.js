@@ -248,6 +248,23 @@ mergeInto(LibraryManager.library, {
     }
   },
   interop_FileClose__deps: ['interop_SaveNode'],
+  interop_FileRename: function(rawSrc, rawDst) {
+    var src = UTF8ToString(rawSrc);
+    var dst = UTF8ToString(rawDst);
+    try {
+      // IndexedDB stores files by absolute path
+      var oldPath = FS.lookupPath(src).path;
+      FS.rename(src, dst);
+      // update IndexedDB too, otherwise the old file would reappear next time
+      _interop_SaveNode(dst);
+      _interop_DeleteNode(oldPath);
+      return 0;
+    } catch (e) {
+      if (typeof FS === 'undefined' || !(e instanceof FS.ErrnoError)) abort(e);
+      return -e.errno;
+    }
+  },
+  interop_FileRename__deps: ['interop_SaveNode', 'interop_DeleteNode'],
   
   
 //########################################################################################################################
@@ -322,6 +339,34 @@ mergeInto(LibraryManager.library, {
       _IDBFS_storeRemoteEntry(store, path, entry, callback);
     });
   },
+  interop_DeleteNode__deps: ['IDBFS_getDB'],
+  interop_DeleteNode: function(path) {
+    var callback = function(err) { 
+      if (!err) return;
+      console.log(err);
+      ccall('Platform_LogError', 'void', ['string'], ['&cError deleting ' + path]);
+      ccall('Platform_LogError', 'void', ['string'], ['   &c' + err]);
+    };
+    
+    _IDBFS_getDB(function(err, db) {
+      if (err) return callback(err);
+      var transaction, req;
+      
+      // can still throw errors here
+      try {
+        transaction = db.transaction([IDBFS_DB_STORE_NAME], 'readwrite');
+        req = transaction.objectStore(IDBFS_DB_STORE_NAME).delete(path);
+      } catch (err) {
+        return callback(err);
+      }
+      
+      req.onsuccess = function() { callback(null); };
+      req.onerror   = function(e) {
+        callback(this.error);
+        e.preventDefault();
+      };
+    });
+  },
 //########################################################################################################################
 //--------------------------------------------------------IndexedDB-------------------------------------------------------
 //########################################################################################################################